@@ -0,0 +1,181 @@
+/**----------------------------------------------------------------------------
+ Copyright  2018-, UT-Battelle, LLC
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ Author(s): Jay Jay Billings (billingsjj <at> ornl <dot> gov)
+ -----------------------------------------------------------------------------*/
+#include <ActiveNodeSet.h>
+#include <algorithm>
+
+namespace Kelvin {
+
+ActiveNodeSet::ActiveNodeSet(const int & numNodes) {
+	resize(numNodes);
+}
+
+void ActiveNodeSet::resize(const int & numNodes) {
+	this->numNodes = numNodes;
+	wordTable.clear();
+	words.clear();
+	bits.clear();
+	bases.clear();
+	order.clear();
+	ids.clear();
+	compacted = true;
+}
+
+void ActiveNodeSet::clear() {
+	std::fill(bits.begin(),bits.end(),0);
+	compacted = false;
+}
+
+int ActiveNodeSet::storeWord(const int & nodeId) {
+	int wordIndex = nodeId >> 6;
+	int word = wordTable.find(wordIndex);
+	if (word < 0) {
+		word = words.size();
+		wordTable.insert(wordIndex,word);
+		words.push_back(wordIndex);
+		bits.push_back(0);
+		bases.push_back(0);
+	}
+	return word;
+}
+
+void ActiveNodeSet::assign(const std::set<int> & nodeSet) {
+	int requiredNodes = (nodeSet.empty()) ? 0 : *nodeSet.rbegin() + 1;
+	if (requiredNodes > numNodes) {
+		resize(requiredNodes);
+	} else {
+		clear();
+	}
+	for (auto & nodeId : nodeSet) {
+		insert(nodeId);
+	}
+	compact();
+}
+
+void ActiveNodeSet::compact() {
+
+	if (compacted) {
+		return;
+	}
+
+	// Drop the words without active nodes by moving the last word into
+	// their place. Only the stored words are visited.
+	for (int w = 0; w < (int) words.size(); ) {
+		if (bits[w]) {
+			w++;
+			continue;
+		}
+		wordTable.erase(words[w]);
+		int last = words.size() - 1;
+		if (w != last) {
+			wordTable.erase(words[last]);
+			wordTable.insert(words[last],w);
+			words[w] = words[last];
+			bits[w] = bits[last];
+		}
+		words.pop_back();
+		bits.pop_back();
+		bases.pop_back();
+	}
+
+	// Walk the words in increasing order so that the ids come out sorted,
+	// and record the slot of the first node of each word.
+	int numWords = words.size();
+	order.resize(numWords);
+	for (int w = 0; w < numWords; w++) {
+		order[w] = w;
+	}
+	std::sort(order.begin(),order.end(),
+			[&](const int & a, const int & b) { return words[a] < words[b]; });
+	ids.clear();
+	for (auto & w : order) {
+		bases[w] = ids.size();
+		uint64_t word = bits[w];
+		while (word) {
+#if defined(__GNUC__)
+			int bit = __builtin_ctzll(word);
+#else
+			int bit = 0;
+			while (!((word >> bit) & 1)) {
+				bit++;
+			}
+#endif
+			ids.push_back(words[w]*64 + bit);
+			word &= word - 1;
+		}
+	}
+	compacted = true;
+
+	return;
+}
+
+bool ActiveNodeSet::isCompacted() const {
+	return compacted;
+}
+
+int ActiveNodeSet::size() const {
+	return ids.size();
+}
+
+bool ActiveNodeSet::empty() const {
+	return ids.empty();
+}
+
+int ActiveNodeSet::capacity() const {
+	return numNodes;
+}
+
+ActiveNodeSet::const_iterator ActiveNodeSet::begin() const {
+	return ids.begin();
+}
+
+ActiveNodeSet::const_iterator ActiveNodeSet::end() const {
+	return ids.end();
+}
+
+ActiveNodeSet::const_iterator ActiveNodeSet::find(const int & nodeId) const {
+	int nodeSlot = slot(nodeId);
+	return (nodeSlot < 0) ? ids.end() : ids.begin() + nodeSlot;
+}
+
+const int * ActiveNodeSet::data() const {
+	return ids.data();
+}
+
+bool ActiveNodeSet::operator==(const ActiveNodeSet & other) const {
+	return ids == other.ids;
+}
+
+bool ActiveNodeSet::operator!=(const ActiveNodeSet & other) const {
+	return !(*this == other);
+}
+
+} /* namespace Kelvin */
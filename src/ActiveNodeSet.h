@@ -0,0 +1,312 @@
+/**----------------------------------------------------------------------------
+ Copyright  2018-, UT-Battelle, LLC
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ Author(s): Jay Jay Billings (billingsjj <at> ornl <dot> gov)
+ -----------------------------------------------------------------------------*/
+#ifndef SRC_ACTIVENODESET_H_
+#define SRC_ACTIVENODESET_H_
+
+#include <cstdint>
+#include <set>
+#include <vector>
+#include <BlockTable.h>
+
+namespace Kelvin {
+
+/**
+ * This class tracks the active nodes of a grid, such as the nodes that have
+ * mass. Membership is stored in a bitmap of 64 node words, but only the
+ * words that hold active nodes are stored and they are found through a
+ * BlockTable, so the memory follows the number of active nodes instead of
+ * the size of the grid. Nodes are added and removed in constant time.
+ *
+ * The active nodes are also kept in a compact, sorted array. The position of
+ * a node in that array is its slot. Each stored word keeps the slot of its
+ * first active node, so the slot of any node is that plus the number of
+ * active nodes before it in its word. Per-node quantities such as lumped
+ * masses and forces are stored by slot, so loops over the active nodes run
+ * over contiguous arrays.
+ *
+ * insert() and erase() only change the bitmap. The compact array and the
+ * slots are rebuilt by compact(), which must be called after a batch of
+ * changes and before the set is read through size(), the iterators, the
+ * slots or operator[]. contains() and count() read the bitmap, so they are
+ * always current.
+ *
+ * Read-only access is safe from multiple threads at once.
+ */
+class ActiveNodeSet {
+protected:
+
+	/**
+	 * The number of nodes in the grid
+	 */
+	int numNodes = 0;
+
+	/**
+	 * The position of each stored word in words, bits and bases
+	 */
+	BlockTable wordTable;
+
+	/**
+	 * The index of each stored word, which is its first node id over 64
+	 */
+	std::vector<int> words;
+
+	/**
+	 * The bitmap of each stored word
+	 */
+	std::vector<uint64_t> bits;
+
+	/**
+	 * The slot of the first active node of each stored word
+	 */
+	std::vector<int> bases;
+
+	/**
+	 * Scratch space for the stored words in increasing order, used by
+	 * compact()
+	 */
+	std::vector<int> order;
+
+	/**
+	 * The ids of the active nodes in increasing order
+	 */
+	std::vector<int> ids;
+
+	/**
+	 * This operation returns the position of the stored word of a node,
+	 * storing the word if needed.
+	 * @param nodeId the id of the node
+	 * @return the position of the word
+	 */
+	int storeWord(const int & nodeId);
+
+	/**
+	 * This operation returns the number of set bits in a word.
+	 * @param word the word
+	 * @return the number of set bits
+	 */
+	static int countBits(uint64_t word) {
+#if defined(__GNUC__)
+		return __builtin_popcountll(word);
+#else
+		int numBits = 0;
+		for (; word; word &= word - 1) {
+			numBits++;
+		}
+		return numBits;
+#endif
+	};
+
+	/**
+	 * True if ids and slots match the bitmap, false otherwise
+	 */
+	bool compacted = true;
+
+public:
+
+	/**
+	 * An iterator over the ids of the active nodes, in increasing order.
+	 */
+	typedef std::vector<int>::const_iterator const_iterator;
+
+	/**
+	 * Constructor
+	 * @param numNodes the number of nodes in the grid
+	 */
+	ActiveNodeSet(const int & numNodes = 0);
+
+	/**
+	 * This operation resizes the set for a grid with a different number of
+	 * nodes. All nodes are made inactive.
+	 * @param numNodes the number of nodes in the grid
+	 */
+	void resize(const int & numNodes);
+
+	/**
+	 * This operation makes all of the nodes inactive.
+	 */
+	void clear();
+
+	/**
+	 * This operation replaces the contents of the set with the nodes in a
+	 * std::set. The grid is resized to fit the largest node if needed and the
+	 * set is compacted.
+	 * @param nodeSet the nodes
+	 */
+	void assign(const std::set<int> & nodeSet);
+
+	/**
+	 * This operation marks a node as active.
+	 * @param nodeId the id of the node
+	 */
+	void insert(const int & nodeId) {
+		bits[storeWord(nodeId)] |= (uint64_t(1) << (nodeId & 63));
+		compacted = false;
+	};
+
+	/**
+	 * This operation marks a node as inactive.
+	 * @param nodeId the id of the node
+	 */
+	void erase(const int & nodeId) {
+		int word = wordTable.find(nodeId >> 6);
+		if (word >= 0) {
+			bits[word] &= ~(uint64_t(1) << (nodeId & 63));
+			compacted = false;
+		}
+	};
+
+	/**
+	 * This operation returns true if a node is active.
+	 * @param nodeId the id of the node
+	 * @return true if the node is active, false if it is not or if it is not
+	 * in the grid
+	 */
+	bool contains(const int & nodeId) const {
+		if (nodeId < 0 || nodeId >= numNodes) {
+			return false;
+		}
+		int word = wordTable.find(nodeId >> 6);
+		return word >= 0 && (bits[word] >> (nodeId & 63)) & 1;
+	};
+
+	/**
+	 * The same as contains(), but with the std::set interface.
+	 * @param nodeId the id of the node
+	 * @return 1 if the node is active, 0 otherwise
+	 */
+	int count(const int & nodeId) const {
+		return contains(nodeId) ? 1 : 0;
+	};
+
+	/**
+	 * This operation rebuilds the compact array of active nodes and their
+	 * slots from the bitmap if the set changed since the last call. Words
+	 * without active nodes are dropped, and the cost follows the number of
+	 * stored words.
+	 */
+	void compact();
+
+	/**
+	 * This operation returns true if the compact array and the slots are
+	 * current.
+	 * @return true if compacted, false otherwise
+	 */
+	bool isCompacted() const;
+
+	/**
+	 * This operation returns the number of active nodes.
+	 * @return the number of active nodes
+	 */
+	int size() const;
+
+	/**
+	 * This operation returns true if there are no active nodes.
+	 * @return true if empty, false otherwise
+	 */
+	bool empty() const;
+
+	/**
+	 * This operation returns the number of nodes in the grid.
+	 * @return the number of nodes
+	 */
+	int capacity() const;
+
+	/**
+	 * This operation returns an iterator to the first active node.
+	 * @return the iterator
+	 */
+	const_iterator begin() const;
+
+	/**
+	 * This operation returns an iterator past the last active node.
+	 * @return the iterator
+	 */
+	const_iterator end() const;
+
+	/**
+	 * This operation finds an active node.
+	 * @param nodeId the id of the node
+	 * @return an iterator to the node or end() if the node is not active
+	 */
+	const_iterator find(const int & nodeId) const;
+
+	/**
+	 * This operation returns the id of the active node in a slot.
+	 * @param slot the slot, 0 to size() - 1
+	 * @return the id of the node
+	 */
+	const int & operator[](const int & slot) const {
+		return ids[slot];
+	};
+
+	/**
+	 * This operation returns the slot of a node.
+	 * @param nodeId the id of the node
+	 * @return the slot or -1 if the node is not active or not in the grid
+	 */
+	int slot(const int & nodeId) const {
+		if (nodeId < 0 || nodeId >= numNodes) {
+			return -1;
+		}
+		int word = wordTable.find(nodeId >> 6);
+		if (word < 0 || !((bits[word] >> (nodeId & 63)) & 1)) {
+			return -1;
+		}
+		uint64_t before = (uint64_t(1) << (nodeId & 63)) - 1;
+		return bases[word] + countBits(bits[word] & before);
+	};
+
+	/**
+	 * This operation returns the compact array of active node ids.
+	 * @return the ids, size() entries in increasing order
+	 */
+	const int * data() const;
+
+	/**
+	 * This operator returns true if both sets have the same active nodes.
+	 * @param other the other set
+	 * @return true if the active nodes are the same, false otherwise
+	 */
+	bool operator==(const ActiveNodeSet & other) const;
+
+	/**
+	 * This operator returns true if the sets have different active nodes.
+	 * @param other the other set
+	 * @return true if the active nodes differ, false otherwise
+	 */
+	bool operator!=(const ActiveNodeSet & other) const;
+
+};
+
+} /* namespace Kelvin */
+
+#endif /* SRC_ACTIVENODESET_H_ */
@@ -0,0 +1,106 @@
+/**----------------------------------------------------------------------------
+ Copyright  2018-, UT-Battelle, LLC
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ Author(s): Jay Jay Billings (billingsjj <at> ornl <dot> gov)
+ -----------------------------------------------------------------------------*/
+#include <BackgroundWriter.h>
+
+using namespace std;
+
+namespace Kelvin {
+
+BackgroundWriter::BackgroundWriter() {
+	_thread = thread(&BackgroundWriter::run, this);
+}
+
+BackgroundWriter::~BackgroundWriter() {
+	{
+		lock_guard<mutex> lock(_mutex);
+		_stop = true;
+	}
+	_condition.notify_all();
+	// The thread finishes the queued write before it exits
+	_thread.join();
+}
+
+void BackgroundWriter::run() {
+
+	unique_lock<mutex> lock(_mutex);
+	while (true) {
+		_condition.wait(lock, [this]{ return _pending || _stop; });
+		if (!_pending) {
+			break;
+		}
+		function<void()> write = move(_pending);
+		_pending = nullptr;
+		// Write without the lock so that the caller can keep going
+		lock.unlock();
+		const char * error = nullptr;
+		try {
+			write();
+		} catch (const char * e) {
+			error = e;
+		} catch (...) {
+			error = "Unable to write the output file.";
+		}
+		lock.lock();
+		if (error && !_error) {
+			_error = error;
+		}
+		_busy = false;
+		_condition.notify_all();
+	}
+
+	return;
+}
+
+void BackgroundWriter::waitForThread(std::unique_lock<std::mutex> & lock) {
+	_condition.wait(lock, [this]{ return !_busy; });
+	if (_error) {
+		const char * error = _error;
+		_error = nullptr;
+		throw error;
+	}
+}
+
+void BackgroundWriter::submit(std::function<void()> write) {
+	unique_lock<mutex> lock(_mutex);
+	waitForThread(lock);
+	_pending = move(write);
+	_busy = true;
+	lock.unlock();
+	_condition.notify_all();
+}
+
+void BackgroundWriter::wait() {
+	unique_lock<mutex> lock(_mutex);
+	waitForThread(lock);
+}
+
+} /* namespace Kelvin */
@@ -0,0 +1,132 @@
+/**----------------------------------------------------------------------------
+ Copyright  2018-, UT-Battelle, LLC
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ Author(s): Jay Jay Billings (billingsjj <at> ornl <dot> gov)
+ -----------------------------------------------------------------------------*/
+#ifndef SRC_BACKGROUNDWRITER_H_
+#define SRC_BACKGROUNDWRITER_H_
+
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace Kelvin {
+
+/**
+ * This class runs file writes on a background thread, one at a time. A
+ * write is queued with submit(), which first waits for the previous write
+ * to finish, so the writes are done in order and the caller knows that
+ * everything that the previous write used is free again once submit()
+ * returns.
+ *
+ * Errors thrown by a write, as C strings, are reported by the next call to
+ * submit() or wait().
+ */
+class BackgroundWriter {
+protected:
+
+	/**
+	 * The write that the thread should run next, or empty
+	 */
+	std::function<void()> _pending;
+
+	/**
+	 * True while the thread has a write that is not finished
+	 */
+	bool _busy = false;
+
+	/**
+	 * True when the thread should exit
+	 */
+	bool _stop = false;
+
+	/**
+	 * The error from the last write, or null if there was none
+	 */
+	const char * _error = nullptr;
+
+	/**
+	 * The lock for the state shared with the thread
+	 */
+	std::mutex _mutex;
+
+	/**
+	 * The condition that signals changes of the shared state
+	 */
+	std::condition_variable _condition;
+
+	/**
+	 * The writer thread
+	 */
+	std::thread _thread;
+
+	/**
+	 * This operation is the loop of the writer thread.
+	 */
+	void run();
+
+	/**
+	 * This operation waits until the thread is idle and throws its error if
+	 * it had one.
+	 * @param lock the lock on the shared state, which must be held
+	 */
+	void waitForThread(std::unique_lock<std::mutex> & lock);
+
+public:
+
+	/**
+	 * Constructor. Starts the thread.
+	 */
+	BackgroundWriter();
+
+	/**
+	 * Destructor. Finishes the queued write and stops the thread.
+	 */
+	~BackgroundWriter();
+
+	BackgroundWriter(const BackgroundWriter &) = delete;
+	BackgroundWriter & operator=(const BackgroundWriter &) = delete;
+
+	/**
+	 * This operation waits for the previous write and queues the next one.
+	 * @param write the write to run on the thread
+	 */
+	void submit(std::function<void()> write);
+
+	/**
+	 * This operation waits for the queued write to finish.
+	 */
+	void wait();
+
+};
+
+} /* namespace Kelvin */
+
+#endif /* SRC_BACKGROUNDWRITER_H_ */
@@ -31,7 +31,7 @@
  -----------------------------------------------------------------------------*/
 #include <BasicMFEMGridMapper.h>
 #include <Grid.h>
-#include <cmath>
+#include <array>
 
 using namespace Kelvin;
 using namespace std;
@@ -48,115 +48,165 @@ BasicMFEMGridMapper::~BasicMFEMGridMapper() {
 	// TODO Auto-generated destructor stub
 }
 
-void BasicMFEMGridMapper::updateParticleAccelerations(const Kelvin::Grid & grid,
-		std::vector<Kelvin::MaterialPoint> & particles) const {
-
-	// Create the H1 field
-	int dim = _mesh.Dimension();
-	H1_FECollection accCol(1,dim);
-	FiniteElementSpace accSpace(&_mesh,&accCol,dim,Ordering::byVDIM);
-	// Create and fill the grid function
-	GridFunction accGf(&accSpace);
-	auto & nodes = grid.nodes();
-	for (int i = 0; i < nodes.size(); i++) {
-		auto & nodeAcc = nodes[i].acc;
-		for (int j = 0; j < dim; j++) {
-			accGf[i*dim+j] = nodeAcc[j];
-		}
+void BasicMFEMGridMapper::checkStencils(const Kelvin::Grid & grid,
+		const int & numParticles) const {
+	// The stencils must have been computed for this particle list
+	if (grid.stencils().size() != numParticles) {
+		throw "Grid stencils and particle list size mismatch (unequal).";
 	}
+}
 
-    int id = 0;
-	// Map the grid accelerations to the particles
-	mfem::IntegrationPoint intPoint;
-	Vector acc(dim);
-	for (int i = 0; i < particles.size(); i++) {
-		auto & mPoint = particles[i];
-		id = grid.getElementId(mPoint);
-		intPoint.Set(mPoint.pos.data(),dim);
-		accGf.GetVectorValue(id,intPoint,acc);
-		// Write the acceleration data back to the point
-		for (int j = 0; j < dim; j++) {
-			mPoint.acc[j] = acc[j];
+template<int Dim>
+void BasicMFEMGridMapper::interpolate(const Kelvin::Grid & grid,
+		const double * (NodeBlocks::*field)() const, double * values) const {
+
+	auto & blocks = grid.nodeBlocks();
+	const double * nodeValues = (blocks.*field)();
+	auto & stencils = grid.stencils();
+	int numParticles = stencils.size();
+
+	// u_p = \sum_i N_i(x_p) u_i. Each particle only writes its own values, so
+	// the particles can be mapped in parallel.
+	#pragma omp parallel for schedule(static)
+	for (int i = 0; i < numParticles; i++) {
+		auto & stencil = stencils[i];
+		double * value = &values[i*Dim];
+		for (int j = 0; j < Dim; j++) {
+			value[j] = 0.0;
+		}
+		for (int k = 0; k < stencil.numNodes; k++) {
+			const double * nodeValue =
+					nodeValues + blocks.index(stencil.nodeIds[k])*Dim;
+			for (int j = 0; j < Dim; j++) {
+				value[j] += stencil.weights[k]*nodeValue[j];
+			}
 		}
 	}
 
 	return;
 }
 
-void BasicMFEMGridMapper::updateParticleVelocities(const Kelvin::Grid & grid,
-		std::vector<Kelvin::MaterialPoint> & particles) const {
-
-	// Create the H1 field
-	int dim = _mesh.Dimension();
-	H1_FECollection velCol(1,dim);
-	FiniteElementSpace velSpace(&_mesh,&velCol,dim,Ordering::byVDIM);
-	// Create and fill the grid function
-	GridFunction velGf(&velSpace);
-	auto & nodes = grid.nodes();
-	for (int i = 0; i < nodes.size(); i++) {
-		auto & nodeVel = nodes[i].vel;
-		for (int j = 0; j < dim; j++) {
-			velGf[i*dim+j] = nodeVel[j];
-		}
-	}
-
-    // Find the point quickly since the background mesh is known to be a cube.
-    int id = 0;
-
-	// Map the grid velocities to the particles
-	mfem::IntegrationPoint intPoint;
-	Vector vel(dim);
-	for (int i = 0; i < particles.size(); i++) {
-		auto & mPoint = particles[i];
-		id = grid.getElementId(mPoint);
-		intPoint.Set(mPoint.pos.data(),dim);
-		velGf.GetVectorValue(id,intPoint,vel);
-		// Write the velocity data back to the point
-		for (int j = 0; j < dim; j++) {
-			mPoint.vel[j] = vel[j];
-		}
+void BasicMFEMGridMapper::interpolate(const Kelvin::Grid & grid,
+		const int & numParticles, const double * (NodeBlocks::*field)() const,
+		double * values) const {
+
+	checkStencils(grid,numParticles);
+	// Dispatch to the kernel for the dimension so that the inner loops have
+	// fixed lengths.
+	switch (_mesh.Dimension()) {
+	case 2:
+		interpolate<2>(grid,field,values);
+		break;
+	case 3:
+		interpolate<3>(grid,field,values);
+		break;
+	default:
+		throw "Unsupported grid dimension. Only 2D and 3D grids are supported.";
 	}
 
 	return;
+}
+
+void BasicMFEMGridMapper::updateParticleAccelerations(const Kelvin::Grid & grid,
+		ParticleSet & particles) const {
+	// Map the grid accelerations to the particles
+	interpolate(grid,particles.size(),&NodeBlocks::accelerations,
+			particles.acc(0));
+}
 
+void BasicMFEMGridMapper::updateParticleVelocities(const Kelvin::Grid & grid,
+		ParticleSet & particles) const {
+	// Map the grid velocities to the particles
+	interpolate(grid,particles.size(),&NodeBlocks::velocities,
+			particles.vel(0));
 }
 
 void BasicMFEMGridMapper::updateParticleVelocities(const Kelvin::Grid & grid,
-		const std::vector<Kelvin::MaterialPoint> & particles,
+		const ParticleSet & particles,
 		std::vector<double> & velocities) const {
+	// Map the grid velocities to the storage vector
+	interpolate(grid,particles.size(),&NodeBlocks::velocities,
+			velocities.data());
+}
 
-	// Create the H1 field
-	int dim = _mesh.Dimension();
-	H1_FECollection velCol(1, dim);
-	FiniteElementSpace velSpace(&_mesh, &velCol, dim, Ordering::byVDIM);
-	// Create and fill the grid function
-	GridFunction velGf(&velSpace);
-	auto & nodes = grid.nodes();
-	for (int i = 0; i < nodes.size(); i++) {
-		auto & nodeVel = nodes[i].vel;
-		for (int j = 0; j < dim; j++) {
-			velGf[i * dim + j] = nodeVel[j];
+template<int Dim>
+void BasicMFEMGridMapper::interpolateKinematics(const Kelvin::Grid & grid,
+		double * acc, double * vel, double * velGrad) const {
+
+	auto & blocks = grid.nodeBlocks();
+	const double * nodeAccs = blocks.accelerations();
+	const double * nodeVels = blocks.velocities();
+	auto & stencils = grid.stencils();
+	int numParticles = stencils.size();
+
+	// a_p = \sum_i N_i(x_p) a_i, v_p = \sum_i N_i(x_p) v_i and
+	// dv_p/dx = \sum_i v_i (dN_i(x_p)/dx)^T from a single walk of the stencil
+	#pragma omp parallel for schedule(static)
+	for (int i = 0; i < numParticles; i++) {
+		auto & stencil = stencils[i];
+		std::array<double,Dim> pAcc{}, pVel{};
+		std::array<std::array<double,Dim>,Dim> pVelGrad{};
+		for (int k = 0; k < stencil.numNodes; k++) {
+			int offset = blocks.index(stencil.nodeIds[k])*Dim;
+			const double * nodeAcc = nodeAccs + offset;
+			const double * nodeVel = nodeVels + offset;
+			double weight = stencil.weights[k];
+			auto & grad = stencil.gradients[k];
+			for (int j = 0; j < Dim; j++) {
+				pAcc[j] += weight*nodeAcc[j];
+				pVel[j] += weight*nodeVel[j];
+				for (int l = 0; l < Dim; l++) {
+					pVelGrad[j][l] += nodeVel[j]*grad[l];
+				}
+			}
+		}
+		// Write everything back
+		for (int j = 0; j < Dim; j++) {
+			acc[i*Dim+j] = pAcc[j];
+			vel[i*Dim+j] = pVel[j];
+		}
+		if (velGrad) {
+			for (int j = 0; j < Dim; j++) {
+				for (int l = 0; l < Dim; l++) {
+					velGrad[(i*Dim+j)*Dim+l] = pVelGrad[j][l];
+				}
+			}
 		}
 	}
 
+	return;
+}
 
-    int id = 0;
-	// Map the grid velocities to the storage vector
-	mfem::IntegrationPoint intPoint;
-	Vector vel(dim);
-	for (int i = 0; i < particles.size(); i++) {
-		auto & mPoint = particles[i];
-		id = grid.getElementId(mPoint);
-		intPoint.Set(mPoint.pos.data(), dim);
-		velGf.GetVectorValue(id, intPoint, vel);
-		// Write the velocity data back to the storage vector
-		for (int j = 0; j < dim; j++) {
-			velocities[i*dim+j] = vel[j];
-		}
+void BasicMFEMGridMapper::interpolateKinematics(const Kelvin::Grid & grid,
+		ParticleSet & particles, std::vector<double> & velocities,
+		double * velGrad) const {
+
+	checkStencils(grid,particles.size());
+	switch (_mesh.Dimension()) {
+	case 2:
+		interpolateKinematics<2>(grid,particles.acc(0),velocities.data(),
+				velGrad);
+		break;
+	case 3:
+		interpolateKinematics<3>(grid,particles.acc(0),velocities.data(),
+				velGrad);
+		break;
+	default:
+		throw "Unsupported grid dimension. Only 2D and 3D grids are supported.";
 	}
 
 	return;
+}
+
+void BasicMFEMGridMapper::updateParticleKinematics(const Kelvin::Grid & grid,
+		ParticleSet & particles, std::vector<double> & velocities) const {
+	interpolateKinematics(grid,particles,velocities,NULL);
+}
 
+void BasicMFEMGridMapper::updateParticleKinematics(const Kelvin::Grid & grid,
+		ParticleSet & particles, std::vector<double> & velocities,
+		std::vector<double> & velocityGradients) const {
+	interpolateKinematics(grid,particles,velocities,velocityGradients.data());
 }
 
 } /* namespace Kelvin */
@@ -38,12 +38,70 @@
 namespace Kelvin {
 
 /**
- * This is a GridMapper that uses MFEM to map grid properties to the particles.
+ * This is a GridMapper that maps grid properties to the particles using the
+ * shapes stored in the particle stencils of the grid. The grid must have
+ * been updated with the same particle list so that the stencils are current.
+ *
+ * The mapper holds no finite element spaces or grid functions and does not
+ * search for elements, since the stencils already store the nodes and shapes
+ * of each particle's element.
  */
 class BasicMFEMGridMapper: public GridMapper {
 
 	mfem::Mesh & _mesh;
 
+	/**
+	 * This operation throws an exception if the number of stencils on the
+	 * grid does not match the number of particles.
+	 */
+	void checkStencils(const Kelvin::Grid & grid,
+			const int & numParticles) const;
+
+	/**
+	 * This operation interpolates a nodal field, such as the velocity, to the
+	 * particles using the stencil weights. The dimension is a template
+	 * parameter so that the loops over components are unrolled.
+	 * @param grid the grid
+	 * @param field the array of the nodal field in the node blocks,
+	 * &NodeBlocks::accelerations or &NodeBlocks::velocities
+	 * @param values the output array with Dim entries per particle
+	 */
+	template<int Dim>
+	void interpolate(const Kelvin::Grid & grid,
+			const double * (NodeBlocks::*field)() const, double * values) const;
+
+	/**
+	 * This operation checks the stencils and dispatches to interpolate<Dim>()
+	 * for the dimension of the mesh.
+	 * @param grid the grid
+	 * @param numParticles the number of particles
+	 * @param field the array of the nodal field in the node blocks
+	 * @param values the output array with dimension entries per particle
+	 */
+	void interpolate(const Kelvin::Grid & grid, const int & numParticles,
+			const double * (NodeBlocks::*field)() const, double * values) const;
+
+	/**
+	 * This operation computes the accelerations, velocities and, optionally,
+	 * the velocity gradients at the particles in one pass over the stencils.
+	 * @param grid the grid
+	 * @param acc the output accelerations with Dim entries per particle
+	 * @param vel the output velocities with Dim entries per particle
+	 * @param velGrad the output velocity gradients with Dim x Dim entries per
+	 * particle, or null if they should not be computed
+	 */
+	template<int Dim>
+	void interpolateKinematics(const Kelvin::Grid & grid, double * acc,
+			double * vel, double * velGrad) const;
+
+	/**
+	 * This operation checks the stencils and dispatches to
+	 * interpolateKinematics<Dim>() for the dimension of the mesh.
+	 */
+	void interpolateKinematics(const Kelvin::Grid & grid,
+			ParticleSet & particles, std::vector<double> & velocities,
+			double * velGrad) const;
+
 public:
 
 	/**
@@ -56,15 +114,27 @@ public:
 	 */
 	virtual ~BasicMFEMGridMapper();
 
+	// Pull in the adapters for lists of material points
+	using GridMapper::updateParticleAccelerations;
+	using GridMapper::updateParticleVelocities;
+
 	void updateParticleAccelerations(const Kelvin::Grid & grid,
-			std::vector<Kelvin::MaterialPoint> & particles) const;
+			ParticleSet & particles) const;
 
 	void updateParticleVelocities(const Kelvin::Grid & grid,
-			std::vector<Kelvin::MaterialPoint> & particles) const;
+			ParticleSet & particles) const;
 
 	void updateParticleVelocities(const Kelvin::Grid & grid,
-			const std::vector<Kelvin::MaterialPoint> & particles,
+			const ParticleSet & particles,
+			std::vector<double> & velocities) const;
+
+	void updateParticleKinematics(const Kelvin::Grid & grid,
+			ParticleSet & particles,
 			std::vector<double> & velocities) const;
+
+	void updateParticleKinematics(const Kelvin::Grid & grid,
+			ParticleSet & particles, std::vector<double> & velocities,
+			std::vector<double> & velocityGradients) const;
 };
 
 } /* namespace Kelvin */
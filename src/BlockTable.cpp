@@ -0,0 +1,123 @@
+/**----------------------------------------------------------------------------
+ Copyright  2018-, UT-Battelle, LLC
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ Author(s): Jay Jay Billings (billingsjj <at> ornl <dot> gov)
+ -----------------------------------------------------------------------------*/
+#include <BlockTable.h>
+
+namespace Kelvin {
+
+/**
+ * The number of bits of the bucket index of an empty table.
+ */
+static const int minBits = 4;
+
+BlockTable::BlockTable() {
+	clear();
+}
+
+void BlockTable::rehash(const int & numBits) {
+
+	std::vector<int> oldKeys(1 << numBits,-1), oldValues(1 << numBits);
+	oldKeys.swap(keys);
+	oldValues.swap(values);
+	bits = numBits;
+	mask = (1 << bits) - 1;
+	numKeys = 0;
+	int numBuckets = oldKeys.size();
+	for (int b = 0; b < numBuckets; b++) {
+		if (oldKeys[b] >= 0) {
+			insert(oldKeys[b],oldValues[b]);
+		}
+	}
+
+	return;
+}
+
+void BlockTable::insert(const int & key, const int & value) {
+
+	// Grow the table before it is more than half full
+	if (2*(numKeys + 1) > capacity()) {
+		rehash(bits + 1);
+	}
+	int b = home(key);
+	while (keys[b] >= 0) {
+		b = (b + 1) & mask;
+	}
+	keys[b] = key;
+	values[b] = value;
+	numKeys++;
+
+	return;
+}
+
+void BlockTable::erase(const int & key) {
+
+	// Find the bucket of the key
+	int b = home(key);
+	while (keys[b] != key) {
+		if (keys[b] < 0) {
+			return;
+		}
+		b = (b + 1) & mask;
+	}
+
+	// Shift the following keys of the run back into the hole if that doesn't
+	// move them in front of their home buckets, so that no search stops early.
+	for (int next = (b + 1) & mask; keys[next] >= 0; next = (next + 1) & mask) {
+		int nextHome = home(keys[next]);
+		if (((next - nextHome) & mask) >= ((next - b) & mask)) {
+			keys[b] = keys[next];
+			values[b] = values[next];
+			b = next;
+		}
+	}
+	keys[b] = -1;
+	numKeys--;
+
+	return;
+}
+
+void BlockTable::clear() {
+	bits = minBits;
+	mask = (1 << bits) - 1;
+	keys.assign(1 << bits,-1);
+	values.assign(1 << bits,0);
+	numKeys = 0;
+}
+
+int BlockTable::size() const {
+	return numKeys;
+}
+
+int BlockTable::capacity() const {
+	return keys.size();
+}
+
+} /* namespace Kelvin */
@@ -0,0 +1,151 @@
+/**----------------------------------------------------------------------------
+ Copyright  2018-, UT-Battelle, LLC
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ Author(s): Jay Jay Billings (billingsjj <at> ornl <dot> gov)
+ -----------------------------------------------------------------------------*/
+#ifndef SRC_BLOCKTABLE_H_
+#define SRC_BLOCKTABLE_H_
+
+#include <cstdint>
+#include <vector>
+
+namespace Kelvin {
+
+/**
+ * This class maps the ids of the blocks of a sparse grid, which are
+ * non-negative, to the indices of their storage. It is an open addressing
+ * hash table with linear probing, so its size follows the number of blocks
+ * that are stored instead of the size of the grid and a lookup only probes
+ * one array. The table is kept at most half full.
+ *
+ * Read-only access is safe from multiple threads at once.
+ */
+class BlockTable {
+protected:
+
+	/**
+	 * The key in each bucket, or -1 if the bucket is empty.
+	 */
+	std::vector<int> keys;
+
+	/**
+	 * The value in each bucket.
+	 */
+	std::vector<int> values;
+
+	/**
+	 * The number of bits of the bucket index. The table has 2^bits buckets.
+	 */
+	int bits = 0;
+
+	/**
+	 * The number of buckets minus one.
+	 */
+	int mask = 0;
+
+	/**
+	 * The number of keys in the table.
+	 */
+	int numKeys = 0;
+
+	/**
+	 * This operation returns the bucket at which the search for a key
+	 * starts. The key is scrambled by Fibonacci hashing so that consecutive
+	 * ids are spread over the table.
+	 * @param key the key
+	 * @return the bucket
+	 */
+	int home(const int & key) const {
+		return (int) ((uint32_t(key)*2654435769u) >> (32 - bits));
+	}
+
+	/**
+	 * This operation rebuilds the table with a number of buckets.
+	 * @param numBits the number of bits of the new bucket index
+	 */
+	void rehash(const int & numBits);
+
+public:
+
+	/**
+	 * Constructor
+	 */
+	BlockTable();
+
+	/**
+	 * This operation returns the value of a key.
+	 * @param key the key
+	 * @return the value or -1 if the key is not in the table
+	 */
+	int find(const int & key) const {
+		for (int b = home(key); ; b = (b + 1) & mask) {
+			int bucketKey = keys[b];
+			if (bucketKey == key) {
+				return values[b];
+			} else if (bucketKey < 0) {
+				return -1;
+			}
+		}
+	}
+
+	/**
+	 * This operation adds a key that is not in the table yet.
+	 * @param key the key
+	 * @param value the value of the key
+	 */
+	void insert(const int & key, const int & value);
+
+	/**
+	 * This operation removes a key from the table if it is there.
+	 * @param key the key
+	 */
+	void erase(const int & key);
+
+	/**
+	 * This operation removes all of the keys and shrinks the table.
+	 */
+	void clear();
+
+	/**
+	 * This operation returns the number of keys in the table.
+	 * @return the number of keys
+	 */
+	int size() const;
+
+	/**
+	 * This operation returns the number of buckets in the table.
+	 * @return the number of buckets
+	 */
+	int capacity() const;
+
+};
+
+} /* namespace Kelvin */
+
+#endif /* SRC_BLOCKTABLE_H_ */
@@ -0,0 +1,396 @@
+/**----------------------------------------------------------------------------
+ Copyright  2018-, UT-Battelle, LLC
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ Author(s): Jay Jay Billings (billingsjj <at> ornl <dot> gov)
+ -----------------------------------------------------------------------------*/
+#include <CartesianMesh.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace Kelvin {
+
+constexpr double CartesianMesh::tolerance;
+
+CartesianMesh::CartesianMesh(mfem::Mesh & mesh,
+		const mfem::FiniteElementCollection & collection) : mesh(mesh),
+		dim(mesh.Dimension()) {
+
+	cartesian = build(collection);
+	latticeOrdered = cartesian && checkVertexOrder();
+	// Don't hold on to a partial lattice if the mesh isn't Cartesian
+	if (!cartesian) {
+		cellElements.clear();
+		cellElements.shrink_to_fit();
+		elementOrientations.clear();
+		elementOrientations.shrink_to_fit();
+		orientations.clear();
+	}
+}
+
+bool CartesianMesh::build(const mfem::FiniteElementCollection & collection) {
+
+	int numElements = mesh.GetNE();
+	if (numElements == 0 || (dim != 2 && dim != 3)
+			|| mesh.SpaceDimension() != dim || mesh.GetNodes() != nullptr) {
+		return false;
+	}
+
+	// All of the elements must be linear quadrilaterals or hexahedra
+	int geometry = (dim == 2) ? mfem::Geometry::SQUARE : mfem::Geometry::CUBE;
+	numCorners = (dim == 2) ? 4 : 8;
+	for (int i = 0; i < numElements; i++) {
+		if (mesh.GetElement(i)->GetGeometryType() != geometry) {
+			return false;
+		}
+	}
+	auto * fElement = collection.FiniteElementForGeometry(geometry);
+	if (fElement == nullptr || fElement->GetDof() != numCorners) {
+		return false;
+	}
+
+	// Get the corners of the reference element and find the corners at the
+	// end of each reference direction from the first one.
+	auto * refVertices = mfem::Geometries.GetVertices(geometry);
+	for (int i = 0; i < numCorners; i++) {
+		auto & vertex = refVertices->IntPoint(i);
+		double coords[3] = {vertex.x,vertex.y,vertex.z};
+		for (int k = 0; k < dim; k++) {
+			cornerCoords[i][k] = (int) std::lround(coords[k]);
+		}
+	}
+	std::array<int,3> edgeCorners{{-1,-1,-1}};
+	for (int i = 0; i < numCorners; i++) {
+		int sum = 0, last = -1;
+		for (int k = 0; k < dim; k++) {
+			sum += cornerCoords[i][k];
+			last = (cornerCoords[i][k] == 1) ? k : last;
+		}
+		if (sum == 0 && i != 0) {
+			return false;
+		} else if (sum == 1) {
+			edgeCorners[last] = i;
+		}
+	}
+
+	// The lattice spans the bounding box of the mesh with cells the size of
+	// the first element.
+	std::array<double,3> upper{};
+	for (int j = 0; j < dim; j++) {
+		lower[j] = std::numeric_limits<double>::max();
+		upper[j] = std::numeric_limits<double>::lowest();
+	}
+	for (int i = 0; i < mesh.GetNV(); i++) {
+		const double * vertex = mesh.GetVertex(i);
+		for (int j = 0; j < dim; j++) {
+			lower[j] = std::min(lower[j],vertex[j]);
+			upper[j] = std::max(upper[j],vertex[j]);
+		}
+	}
+	const int * firstIds = mesh.GetElement(0)->GetVertices();
+	long totalCells = 1;
+	for (int j = 0; j < dim; j++) {
+		double minCoord = std::numeric_limits<double>::max();
+		double maxCoord = std::numeric_limits<double>::lowest();
+		for (int c = 0; c < numCorners; c++) {
+			minCoord = std::min(minCoord,mesh.GetVertex(firstIds[c])[j]);
+			maxCoord = std::max(maxCoord,mesh.GetVertex(firstIds[c])[j]);
+		}
+		spacing[j] = maxCoord - minCoord;
+		if (!(spacing[j] > 0.0)) {
+			return false;
+		}
+		inverseSpacing[j] = 1.0/spacing[j];
+		double exactCells = (upper[j] - lower[j])*inverseSpacing[j];
+		numCells[j] = (int) std::lround(exactCells);
+		if (std::abs(exactCells - numCells[j]) > tolerance*exactCells) {
+			return false;
+		}
+		padding[j] = tolerance*numCells[j];
+		totalCells *= numCells[j];
+	}
+	// A lattice that is much bigger than the mesh means that the mesh isn't
+	// a box, so it is left to the general routines.
+	if (totalCells > 2L*numElements) {
+		return false;
+	}
+
+	// Put every element in its cell and work out its orientation
+	cellElements.assign(totalCells,-1);
+	elementOrientations.resize(numElements);
+	for (int i = 0; i < numElements; i++) {
+		// Get the lattice coordinates of the vertices
+		const int * vertexIds = mesh.GetElement(i)->GetVertices();
+		std::array<std::array<int,3>,ParticleStencil::maxNodes> nodes{};
+		std::array<int,3> cell{{0,0,0}};
+		for (int c = 0; c < numCorners; c++) {
+			const double * vertex = mesh.GetVertex(vertexIds[c]);
+			for (int j = 0; j < dim; j++) {
+				double exact = (vertex[j] - lower[j])*inverseSpacing[j];
+				nodes[c][j] = (int) std::lround(exact);
+				if (std::abs(exact - nodes[c][j])
+						> tolerance*std::max(1.0,exact)) {
+					return false;
+				}
+				cell[j] = (c == 0) ? nodes[c][j] : std::min(cell[j],nodes[c][j]);
+			}
+		}
+		// Each reference direction must run along a different axis
+		Orientation orientation;
+		std::array<bool,3> usedAxes{{false,false,false}};
+		for (int k = 0; k < dim; k++) {
+			int axis = -1;
+			for (int j = 0; j < dim; j++) {
+				int step = nodes[edgeCorners[k]][j] - nodes[0][j];
+				if (step == 0) {
+					continue;
+				} else if (axis != -1 || std::abs(step) != 1) {
+					return false;
+				}
+				axis = j;
+				orientation.flip[k] = (step < 0);
+			}
+			if (axis == -1 || usedAxes[axis]) {
+				return false;
+			}
+			usedAxes[axis] = true;
+			orientation.axis[k] = axis;
+		}
+		// Every vertex must sit on the corner of the cell given by its
+		// reference coordinates, otherwise the element isn't a box.
+		for (int c = 0; c < numCorners; c++) {
+			for (int k = 0; k < dim; k++) {
+				int axis = orientation.axis[k];
+				int offset = nodes[c][axis] - cell[axis];
+				int expected = orientation.flip[k] ?
+						1 - cornerCoords[c][k] : cornerCoords[c][k];
+				if (offset != expected) {
+					return false;
+				}
+			}
+		}
+		// Claim the cell. Two elements in one cell means the mesh overlaps.
+		for (int j = 0; j < dim; j++) {
+			if (cell[j] < 0 || cell[j] >= numCells[j]) {
+				return false;
+			}
+		}
+		long index = cell[0] + numCells[0]*(cell[1] + (long) numCells[1]*cell[2]);
+		if (cellElements[index] != -1) {
+			return false;
+		}
+		cellElements[index] = i;
+		auto found = std::find(orientations.begin(),orientations.end(),
+				orientation);
+		elementOrientations[i] = found - orientations.begin();
+		if (found == orientations.end()) {
+			orientations.push_back(orientation);
+		}
+	}
+
+	return matchesMFEM(*fElement);
+}
+
+bool CartesianMesh::matchesMFEM(const mfem::FiniteElement & fElement) {
+
+	// Use a point with different coordinates in each direction so that a
+	// permutation of the nodes would not go unnoticed.
+	double coords[3] = {0.2,0.3,0.7};
+	mfem::IntegrationPoint intPoint;
+	intPoint.Set(coords,dim);
+	mfem::IsoparametricTransformation transformation;
+	mesh.GetElementTransformation(0,&transformation);
+	transformation.SetIntPoint(&intPoint);
+	mfem::Vector shapes(numCorners);
+	mfem::DenseMatrix gradients(numCorners,dim);
+	fElement.CalcShape(intPoint,shapes);
+	fElement.CalcPhysDShape(transformation,gradients);
+
+	// Compare the shapes and gradients
+	ParticleStencil stencil;
+	computeStencil(0,intPoint,stencil);
+	double maxGradient = 0.0;
+	for (int j = 0; j < dim; j++) {
+		maxGradient = std::max(maxGradient,inverseSpacing[j]);
+	}
+	for (int i = 0; i < numCorners; i++) {
+		if (std::abs(stencil.weights[i] - shapes[i]) > tolerance) {
+			return false;
+		}
+		for (int j = 0; j < dim; j++) {
+			if (std::abs(stencil.gradients[i][j] - gradients(i,j))
+					> tolerance*maxGradient) {
+				return false;
+			}
+		}
+	}
+
+	// Make sure that the point maps back to the same reference coordinates
+	mfem::Vector point;
+	transformation.Transform(intPoint,point);
+	mfem::IntegrationPoint located;
+	if (locate(point.GetData(),located) != 0) {
+		return false;
+	}
+	double locatedCoords[3] = {located.x,located.y,located.z};
+	for (int k = 0; k < dim; k++) {
+		if (std::abs(locatedCoords[k] - coords[k]) > tolerance) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool CartesianMesh::checkVertexOrder() const {
+
+	// There must be exactly one vertex on every point of the lattice
+	int numVertices = mesh.GetNV();
+	long latticeVertices = 1;
+	for (int j = 0; j < dim; j++) {
+		latticeVertices *= numCells[j] + 1;
+	}
+	if (numVertices != latticeVertices) {
+		return false;
+	}
+
+	// Compare the id of each vertex to the one given by its lattice point
+	for (int i = 0; i < numVertices; i++) {
+		const double * vertex = mesh.GetVertex(i);
+		long id = 0, stride = 1;
+		for (int j = 0; j < dim; j++) {
+			long coord = std::lround((vertex[j] - lower[j])*inverseSpacing[j]);
+			id += stride*coord;
+			stride *= numCells[j] + 1;
+		}
+		if (id != i) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool CartesianMesh::isCartesian() const {
+	return cartesian;
+}
+
+bool CartesianMesh::hasLatticeVertexOrder() const {
+	return latticeOrdered;
+}
+
+int CartesianMesh::locate(const double * point,
+		mfem::IntegrationPoint & intPoint) const {
+
+	// Find the cell from the integer part of the lattice coordinates. Points
+	// on the upper boundary of the lattice belong to the last cell.
+	std::array<int,3> cell{{0,0,0}};
+	std::array<double,3> fraction{};
+	for (int j = 0; j < dim; j++) {
+		double exact = (point[j] - lower[j])*inverseSpacing[j];
+		if (!(exact >= -padding[j] && exact <= numCells[j] + padding[j])) {
+			return -1;
+		}
+		cell[j] = std::min(std::max((int) std::floor(exact),0),numCells[j]-1);
+		fraction[j] = std::min(std::max(exact - cell[j],0.0),1.0);
+	}
+	int elemId = cellElements[cell[0]
+			+ numCells[0]*(cell[1] + (long) numCells[1]*cell[2])];
+
+	// Orient the fractions to get the reference coordinates
+	if (elemId > -1) {
+		auto & orientation = orientations[elementOrientations[elemId]];
+		double coords[3];
+		for (int k = 0; k < dim; k++) {
+			double value = fraction[orientation.axis[k]];
+			coords[k] = orientation.flip[k] ? 1.0 - value : value;
+		}
+		intPoint.Set(coords,dim);
+	}
+
+	return elemId;
+}
+
+void CartesianMesh::computeStencil(const int & elemId,
+		const mfem::IntegrationPoint & intPoint,
+		ParticleStencil & stencil) const {
+
+	stencil.elementId = elemId;
+	stencil.numNodes = 0;
+	if (elemId < 0) {
+		return;
+	}
+
+	// The shapes are products of the 1D linear shapes in each reference
+	// direction. Get both 1D shapes and their derivatives with respect to the
+	// physical coordinate along that direction.
+	auto & orientation = orientations[elementOrientations[elemId]];
+	double coords[3] = {intPoint.x,intPoint.y,intPoint.z};
+	double factors[3][2], slopes[3][2];
+	for (int k = 0; k < dim; k++) {
+		double scale = inverseSpacing[orientation.axis[k]];
+		scale = orientation.flip[k] ? -scale : scale;
+		factors[k][0] = 1.0 - coords[k];
+		factors[k][1] = coords[k];
+		slopes[k][0] = -scale;
+		slopes[k][1] = scale;
+	}
+
+	// Multiply them out for each node
+	const int * vertexIds = mesh.GetElement(elemId)->GetVertices();
+	for (int i = 0; i < numCorners; i++) {
+		auto & corner = cornerCoords[i];
+		double weight = 1.0;
+		for (int k = 0; k < dim; k++) {
+			weight *= factors[k][corner[k]];
+		}
+		stencil.nodeIds[i] = vertexIds[i];
+		stencil.weights[i] = weight;
+		for (int k = 0; k < dim; k++) {
+			double gradient = slopes[k][corner[k]];
+			for (int m = 0; m < dim; m++) {
+				gradient *= (m == k) ? 1.0 : factors[m][corner[m]];
+			}
+			stencil.gradients[i][orientation.axis[k]] = gradient;
+		}
+	}
+	stencil.numNodes = numCorners;
+
+	return;
+}
+
+int CartesianMesh::cells(const int & direction) const {
+	return numCells[direction];
+}
+
+double CartesianMesh::cellWidth(const int & direction) const {
+	return spacing[direction];
+}
+
+} /* namespace Kelvin */
@@ -0,0 +1,257 @@
+/**----------------------------------------------------------------------------
+ Copyright  2018-, UT-Battelle, LLC
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ Author(s): Jay Jay Billings (billingsjj <at> ornl <dot> gov)
+ -----------------------------------------------------------------------------*/
+#ifndef SRC_CARTESIANMESH_H_
+#define SRC_CARTESIANMESH_H_
+
+#include <mfem.hpp>
+#include <array>
+#include <vector>
+#include <KelvinBaseTypes.h>
+
+namespace Kelvin {
+
+/**
+ * This class provides a fast path for point location and shape functions on
+ * structured, axis-aligned meshes of linear quadrilaterals or hexahedra, such
+ * as the background meshes created by PMGen.
+ *
+ * The mesh is checked on construction. It is Cartesian if every element is a
+ * single cell of one uniform lattice of boxes and the finite elements are
+ * the usual bilinear or trilinear ones. In that case a point is located by
+ * computing its integer cell coordinates directly from its position, and the
+ * shapes and their physical gradients are evaluated in closed form, so
+ * neither the Newton iteration of the inverse transformation nor MFEM's
+ * virtual shape functions are needed.
+ *
+ * The elements do not need to be numbered in any particular order and their
+ * vertices may be in any orientation. The reference coordinates that are
+ * computed are exactly those of the element in MFEM, so they can be mixed
+ * with calls to MFEM. Points on shared faces are assigned to the cell above
+ * them, which is the same choice as ElementLocator for elements with the
+ * usual orientation.
+ *
+ * Clients must check isCartesian() and use the general MFEM routines when it
+ * returns false. The class does not modify the mesh and can be used from
+ * multiple threads at once.
+ */
+class CartesianMesh {
+protected:
+
+	/**
+	 * The orientation of an element in the lattice. Reference direction k of
+	 * the element runs along physical axis axis[k], backwards if flip[k] is
+	 * true.
+	 */
+	struct Orientation {
+		std::array<int,3> axis{{0,1,2}};
+		std::array<bool,3> flip{{false,false,false}};
+		bool operator==(const Orientation & other) const {
+			return axis == other.axis && flip == other.flip;
+		}
+	};
+
+	/**
+	 * The mesh
+	 */
+	mfem::Mesh & mesh;
+
+	/**
+	 * The spatial dimension of the mesh
+	 */
+	int dim;
+
+	/**
+	 * The number of vertices of each element, 2^dim.
+	 */
+	int numCorners = 0;
+
+	/**
+	 * True if the mesh is a Cartesian grid, false otherwise.
+	 */
+	bool cartesian = false;
+
+	/**
+	 * True if the vertex ids run along the lattice, false otherwise.
+	 */
+	bool latticeOrdered = false;
+
+	/**
+	 * The lower corner of the lattice
+	 */
+	std::array<double,3> lower{};
+
+	/**
+	 * The width of a cell in each direction
+	 */
+	std::array<double,3> spacing{{1.0,1.0,1.0}};
+
+	/**
+	 * The inverse of the width of a cell in each direction
+	 */
+	std::array<double,3> inverseSpacing{{1.0,1.0,1.0}};
+
+	/**
+	 * The distance in cells that a point may be outside of the lattice and
+	 * still be considered on its boundary.
+	 */
+	std::array<double,3> padding{};
+
+	/**
+	 * The number of cells in each direction
+	 */
+	std::array<int,3> numCells{{1,1,1}};
+
+	/**
+	 * The id of the element in each cell of the lattice, ordered along x
+	 * first, or -1 if the cell has no element.
+	 */
+	std::vector<int> cellElements;
+
+	/**
+	 * The distinct orientations of the elements in the mesh
+	 */
+	std::vector<Orientation> orientations;
+
+	/**
+	 * The index of the orientation of each element in orientations
+	 */
+	std::vector<unsigned char> elementOrientations;
+
+	/**
+	 * The coordinates of the vertices of the reference element, which are
+	 * all zero or one. cornerCoords[i][k] is coordinate k of vertex i.
+	 */
+	std::array<std::array<int,3>,ParticleStencil::maxNodes> cornerCoords{};
+
+	/**
+	 * This operation checks if the mesh is a Cartesian grid and sets up the
+	 * lattice if it is.
+	 * @param collection the finite element collection used on the mesh
+	 * @return true if the mesh is Cartesian, false otherwise
+	 */
+	bool build(const mfem::FiniteElementCollection & collection);
+
+	/**
+	 * This operation compares the closed form shapes and gradients to those
+	 * computed by MFEM for one element as a final check of the assumptions
+	 * about the ordering of the degrees of freedom.
+	 * @param fElement the finite element for the elements of the mesh
+	 * @return true if the shapes and gradients agree, false otherwise
+	 */
+	bool matchesMFEM(const mfem::FiniteElement & fElement);
+
+	/**
+	 * This operation checks if the vertex ids of a Cartesian mesh run along
+	 * the lattice, x first, then y, then z.
+	 * @return true if the vertex ids run along the lattice, false otherwise
+	 */
+	bool checkVertexOrder() const;
+
+public:
+
+	/**
+	 * The relative tolerance used to decide if vertices are on the lattice
+	 * and if points are in the lattice.
+	 */
+	static constexpr double tolerance = 1.0e-10;
+
+	/**
+	 * Constructor. The mesh is checked and the lattice is built here.
+	 * @param mesh the mesh
+	 * @param collection the finite element collection used on the mesh
+	 */
+	CartesianMesh(mfem::Mesh & mesh,
+			const mfem::FiniteElementCollection & collection);
+
+	/**
+	 * This operation returns true if the mesh is a Cartesian grid that can
+	 * use the closed form operations in this class.
+	 * @return true if the mesh is Cartesian, false otherwise
+	 */
+	bool isCartesian() const;
+
+	/**
+	 * This operation returns true if the mesh is Cartesian and the id of
+	 * every vertex is i + n_x*(j + n_y*k) for the vertex at lattice point
+	 * (i,j,k), where n_x and n_y are the numbers of vertices in the x and y
+	 * directions. This is the numbering of the meshes from MFEM's Cartesian
+	 * constructors, such as the background meshes created by PMGen, and it
+	 * lets the lattice coordinates of a vertex be computed from its id.
+	 * @return true if the vertex ids run along the lattice, false otherwise
+	 */
+	bool hasLatticeVertexOrder() const;
+
+	/**
+	 * This operation finds the element that contains a point and the
+	 * coordinates of the point in the reference space of that element. It
+	 * may only be called if isCartesian() is true.
+	 * @param point the point, with dimension entries
+	 * @param intPoint the reference coordinates of the point if it was found
+	 * @return the id of the element or -1 if the point is not in the mesh
+	 */
+	int locate(const double * point, mfem::IntegrationPoint & intPoint) const;
+
+	/**
+	 * This operation computes the stencil of a point in an element: the ids
+	 * of the element's nodes and the values and physical gradients of their
+	 * shape functions at the point. It may only be called if isCartesian()
+	 * is true.
+	 * @param elemId the id of the element that contains the point
+	 * @param intPoint the reference coordinates of the point in the element
+	 * @param stencil the stencil that will be filled. If the element id is
+	 * invalid the stencil will have no nodes.
+	 */
+	void computeStencil(const int & elemId,
+			const mfem::IntegrationPoint & intPoint,
+			ParticleStencil & stencil) const;
+
+	/**
+	 * This operation returns the number of cells in one direction of the
+	 * lattice.
+	 * @param direction the direction, 0 to dimension - 1
+	 * @return the number of cells
+	 */
+	int cells(const int & direction) const;
+
+	/**
+	 * This operation returns the width of the cells in one direction of the
+	 * lattice.
+	 * @param direction the direction, 0 to dimension - 1
+	 * @return the width of a cell
+	 */
+	double cellWidth(const int & direction) const;
+
+};
+
+} /* namespace Kelvin */
+
+#endif /* SRC_CARTESIANMESH_H_ */
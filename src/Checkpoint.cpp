@@ -0,0 +1,220 @@
+/**----------------------------------------------------------------------------
+ Copyright  2018-, UT-Battelle, LLC
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ Author(s): Jay Jay Billings (billingsjj <at> ornl <dot> gov)
+ -----------------------------------------------------------------------------*/
+#include <Checkpoint.h>
+#include <algorithm>
+#include <fstream>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+namespace Kelvin {
+
+/**
+ * The magic string at the start of checkpoints
+ */
+static const char checkpointMagic[8] = {'K','E','L','V','I','N','C','K'};
+
+/**
+ * This function flushes a file or directory to the disk.
+ * @param path the path of the file or directory
+ * @return true if it was flushed, false otherwise
+ */
+static bool syncToDisk(const std::string & path) {
+	int descriptor = open(path.c_str(), O_RDONLY);
+	if (descriptor < 0) {
+		return false;
+	}
+	bool synced = fsync(descriptor) == 0;
+	close(descriptor);
+	return synced;
+}
+
+void Checkpoint::write(const std::string & filename) const {
+
+	string tempFilename = filename + ".tmp";
+	ofstream stream(tempFilename, ios::out | ios::binary | ios::trunc);
+	if (!stream) {
+		throw "Unable to open the checkpoint file.";
+	}
+
+	// Header
+	int dim = particles.dimension();
+	int numParticles = particles.size();
+	const int32_t header32[2] = {version, dim};
+	const int64_t header64[2] = {numParticles, step};
+	stream.write(checkpointMagic, sizeof(checkpointMagic));
+	writeLittleEndian(stream, header32, 2);
+	writeLittleEndian(stream, header64, 2);
+	writeLittleEndian(stream, &time, 1);
+
+	// Particle arrays. The accessors need at least one particle.
+	if (numParticles > 0) {
+		size_t vectorSize = dim*numParticles;
+		size_t tensorSize = dim*vectorSize;
+		writeLittleEndian(stream, particles.pos(0), vectorSize);
+		writeLittleEndian(stream, particles.vel(0), vectorSize);
+		writeLittleEndian(stream, particles.acc(0), vectorSize);
+		writeLittleEndian(stream, particles.bodyForce(0), vectorSize);
+		writeLittleEndian(stream, particles.stress(0), tensorSize);
+		writeLittleEndian(stream, particles.strain(0), tensorSize);
+		writeLittleEndian(stream, &particles.mass(0), numParticles);
+		writeLittleEndian(stream, &particles.volume(0), numParticles);
+		vector<int32_t> ids(numParticles);
+		for (int i = 0; i < numParticles; i++) {
+			ids[i] = particles.materialId(i);
+		}
+		writeLittleEndian(stream, ids.data(), ids.size());
+		for (int i = 0; i < numParticles; i++) {
+			ids[i] = particles.id(i);
+		}
+		writeLittleEndian(stream, ids.data(), ids.size());
+	}
+
+	// The data must be on the disk before the rename, or a crash could
+	// leave the new name pointing at an incomplete file.
+	stream.close();
+	if (!stream || !syncToDisk(tempFilename)) {
+		remove(tempFilename.c_str());
+		throw "Unable to write the checkpoint file.";
+	}
+
+	// Replace the last checkpoint in one step and flush the directory so
+	// that the rename itself survives a crash. Not every file system can
+	// flush a directory, and the checkpoint is complete either way, so that
+	// is not an error.
+	if (rename(tempFilename.c_str(), filename.c_str()) != 0) {
+		remove(tempFilename.c_str());
+		throw "Unable to replace the checkpoint file.";
+	}
+	size_t separator = filename.find_last_of('/');
+	syncToDisk(separator == string::npos ? string(".")
+			: filename.substr(0, max(separator, (size_t) 1)));
+
+	return;
+}
+
+void Checkpoint::read(const std::string & filename) {
+
+	ifstream stream(filename, ios::in | ios::binary);
+	if (!stream) {
+		throw "Unable to open the checkpoint file.";
+	}
+
+	// Header
+	char magic[sizeof(checkpointMagic)];
+	int32_t header32[2];
+	int64_t header64[2];
+	stream.read(magic, sizeof(magic));
+	if (!stream || memcmp(magic, checkpointMagic, sizeof(magic))) {
+		throw "The file is not a Kelvin checkpoint.";
+	}
+	readLittleEndian(stream, header32, 2);
+	readLittleEndian(stream, header64, 2);
+	readLittleEndian(stream, &time, 1);
+	if (!stream || header32[0] != version) {
+		throw "Unsupported checkpoint version.";
+	}
+	int dim = header32[1];
+	int numParticles = (int) header64[0];
+	step = (int) header64[1];
+	if (dim < 1 || dim > 3 || numParticles < 0) {
+		throw "Invalid checkpoint header.";
+	}
+
+	// Particle arrays. The accessors need at least one particle.
+	particles = ParticleSet(dim, numParticles);
+	if (numParticles > 0) {
+		size_t vectorSize = dim*numParticles;
+		size_t tensorSize = dim*vectorSize;
+		readLittleEndian(stream, particles.pos(0), vectorSize);
+		readLittleEndian(stream, particles.vel(0), vectorSize);
+		readLittleEndian(stream, particles.acc(0), vectorSize);
+		readLittleEndian(stream, particles.bodyForce(0), vectorSize);
+		readLittleEndian(stream, particles.stress(0), tensorSize);
+		readLittleEndian(stream, particles.strain(0), tensorSize);
+		readLittleEndian(stream, &particles.mass(0), numParticles);
+		readLittleEndian(stream, &particles.volume(0), numParticles);
+		vector<int32_t> materialIds(numParticles), ids(numParticles);
+		readLittleEndian(stream, materialIds.data(), materialIds.size());
+		readLittleEndian(stream, ids.data(), ids.size());
+		if (!stream) {
+			throw "The checkpoint file is truncated.";
+		}
+		for (int i = 0; i < numParticles; i++) {
+			particles.materialId(i) = materialIds[i];
+			particles.id(i) = ids[i];
+		}
+	}
+
+	return;
+}
+
+bool Checkpoint::exists(const std::string & filename) {
+	ifstream stream(filename, ios::in | ios::binary);
+	return (bool) stream;
+}
+
+CheckpointWriter::CheckpointWriter(const std::string & filename) :
+		_filename(filename) {
+}
+
+const std::string & CheckpointWriter::filename() const {
+	return _filename;
+}
+
+void CheckpointWriter::write(const ParticleSet & particles, const int & step,
+		const double & time) {
+
+	// The last checkpoint in this buffer was finished before the other
+	// buffer was queued, so it is free to fill.
+	Checkpoint & checkpoint = _buffers[_next];
+	checkpoint.particles = particles;
+	checkpoint.step = step;
+	checkpoint.time = time;
+	_writer.submit([this,&checkpoint]() {
+		checkpoint.write(_filename);
+	});
+	_next = 1 - _next;
+
+	return;
+}
+
+void CheckpointWriter::flush() {
+	_writer.wait();
+}
+
+} /* namespace Kelvin */
@@ -0,0 +1,161 @@
+/**----------------------------------------------------------------------------
+ Copyright  2018-, UT-Battelle, LLC
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ Author(s): Jay Jay Billings (billingsjj <at> ornl <dot> gov)
+ -----------------------------------------------------------------------------*/
+#ifndef SRC_CHECKPOINT_H_
+#define SRC_CHECKPOINT_H_
+
+#include <ParticleSet.h>
+#include <BackgroundWriter.h>
+#include <string>
+
+namespace Kelvin {
+
+/**
+ * This is the state that an MPM simulation needs to resume: the particles
+ * and the clock. The grid is rebuilt from the particles at the start of
+ * every step, so it is not stored.
+ *
+ * The file is a 40 byte header - the 8 characters "KELVINCK", the format
+ * version and the dimension as 32-bit integers, the number of particles and
+ * the last finished step as 64-bit integers and the time at the end of that
+ * step as a double - followed by the arrays of the ParticleSet in its own
+ * layout and order: position, velocity, acceleration, body force, stress,
+ * strain, mass and volume as doubles, then the material ids and particle ids
+ * as 32-bit integers. Every value is little-endian.
+ */
+struct Checkpoint {
+
+	/**
+	 * The version of the checkpoint format
+	 */
+	static const int version = 1;
+
+	/**
+	 * The last step that was finished
+	 */
+	int step = -1;
+
+	/**
+	 * The simulation time at the end of the step
+	 */
+	double time = 0.0;
+
+	/**
+	 * The particles at the end of the step
+	 */
+	ParticleSet particles;
+
+	/**
+	 * This operation writes the checkpoint. It is written to filename.tmp
+	 * and flushed to the disk first and then renamed, so filename always
+	 * holds a complete checkpoint, even after a crash.
+	 * @param filename the name of the file
+	 */
+	void write(const std::string & filename) const;
+
+	/**
+	 * This operation reads a checkpoint.
+	 * @param filename the name of the file
+	 */
+	void read(const std::string & filename);
+
+	/**
+	 * This operation returns true if the checkpoint file exists.
+	 * @param filename the name of the file
+	 * @return true if the file can be opened, false otherwise
+	 */
+	static bool exists(const std::string & filename);
+
+};
+
+/**
+ * This class writes checkpoints on a background thread. Like ParticleWriter,
+ * the state is copied into one of two buffers while the other buffer is
+ * written, so a checkpoint only costs the step the time of the copy.
+ */
+class CheckpointWriter {
+protected:
+
+	/**
+	 * The name of the checkpoint file
+	 */
+	std::string _filename;
+
+	/**
+	 * The checkpoint buffers, one filled by write() while the other is
+	 * written
+	 */
+	Checkpoint _buffers[2];
+
+	/**
+	 * The index of the buffer that the next call to write() fills
+	 */
+	int _next = 0;
+
+	/**
+	 * The writer thread. It is declared last so that it finishes before the
+	 * buffers are destroyed.
+	 */
+	BackgroundWriter _writer;
+
+public:
+
+	/**
+	 * Constructor
+	 * @param filename the name of the checkpoint file
+	 */
+	CheckpointWriter(const std::string & filename = "kelvin_checkpoint.bin");
+
+	/**
+	 * This operation returns the name of the checkpoint file.
+	 */
+	const std::string & filename() const;
+
+	/**
+	 * This operation copies the state and queues it to replace the
+	 * checkpoint file. It returns as soon as the copy is done.
+	 * @param particles the particles
+	 * @param step the last step that was finished
+	 * @param time the simulation time at the end of the step
+	 */
+	void write(const ParticleSet & particles, const int & step,
+			const double & time);
+
+	/**
+	 * This operation waits for the queued checkpoint to be written.
+	 */
+	void flush();
+
+};
+
+} /* namespace Kelvin */
+
+#endif /* SRC_CHECKPOINT_H_ */
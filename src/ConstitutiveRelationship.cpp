@@ -0,0 +1,68 @@
+/**----------------------------------------------------------------------------
+ Copyright  2018-, UT-Battelle, LLC
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ Author(s): Jay Jay Billings (billingsjj <at> ornl <dot> gov)
+ -----------------------------------------------------------------------------*/
+#include <ConstitutiveRelationship.h>
+
+namespace Kelvin {
+
+void ConstitutiveRelationship::updateStrainRate(const Kelvin::Grid & grid,
+		ParticleSet & particles, const int & begin, const int & end) {
+	for (int i = begin; i < end; i++) {
+		updateStrainRate(grid,particles,i);
+	}
+}
+
+void ConstitutiveRelationship::updateStress(const Kelvin::Grid & grid,
+		ParticleSet & particles, const int & begin, const int & end) {
+	for (int i = begin; i < end; i++) {
+		updateStress(grid,particles,i);
+	}
+}
+
+void ConstitutiveRelationship::updateStrainRate(const Kelvin::Grid & grid,
+		Kelvin::MaterialPoint & matPoint) {
+	ParticleSet particles(matPoint.dimension());
+	particles.push_back(matPoint);
+	beginStep(grid);
+	updateStrainRate(grid,particles,0);
+	particles.get(0,matPoint);
+}
+
+void ConstitutiveRelationship::updateStress(const Kelvin::Grid & grid,
+		Kelvin::MaterialPoint & matPoint) {
+	ParticleSet particles(matPoint.dimension());
+	particles.push_back(matPoint);
+	beginStep(grid);
+	updateStress(grid,particles,0);
+	particles.get(0,matPoint);
+}
+
+} /* namespace Kelvin */
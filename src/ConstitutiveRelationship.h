@@ -33,6 +33,7 @@
 #define SRC_CONSTITUTIVERELATIONSHIP_H_
 
 #include <MaterialPoint.h>
+#include <ParticleSet.h>
 #include <Grid.h>
 #include <map>
 
@@ -53,22 +54,91 @@ public:
 	virtual ~ConstitutiveRelationship() {};
 
 	/**
-	 * This operation updates the strain rate at the material points.
+	 * This operation is called once at the start of the material point
+	 * updates for each time step, after the nodal quantities on the grid
+	 * have been updated. Relationships that need grid state should take a
+	 * snapshot of it here instead of reading the full grid for every
+	 * material point. The default implementation does nothing.
 	 * @param grid the computational grid on which nodal quantities are
 	 * defined.
-	 * @param the material point at which the strains should be updated.
+	 */
+	virtual void beginStep(const Kelvin::Grid & grid) {};
+
+	/**
+	 * This operation updates the strain rate at a material point.
+	 * @param grid the computational grid on which nodal quantities are
+	 * defined.
+	 * @param particles the particle set that holds the material point
+	 * @param index the index of the material point at which the strain rate
+	 * should be updated
 	 */
 	virtual void updateStrainRate(const Kelvin::Grid & grid,
-			Kelvin::MaterialPoint & matPoint) = 0;
+			ParticleSet & particles, const int & index) = 0;
 
 	/**
-	 * This operation updates the stress at the material points.
+	 * This operation updates the stress at a material point.
 	 * @param grid the computational grid on which nodal quantities are
 	 * defined.
-	 * @param the material point at which the strains should be updated.
+	 * @param particles the particle set that holds the material point
+	 * @param index the index of the material point at which the stress
+	 * should be updated
 	 */
 	virtual void updateStress(const Kelvin::Grid & grid,
-			Kelvin::MaterialPoint & matPoint) = 0;
+			ParticleSet & particles, const int & index) = 0;
+
+	/**
+	 * This operation updates the strain rate for a contiguous range of
+	 * material points, [begin,end), that all have a material id that maps to
+	 * this relationship. The default implementation calls
+	 * updateStrainRate(const Kelvin::Grid &, ParticleSet &, const int &) for
+	 * each point, but subclasses can override it to hoist constants out of
+	 * the loop and vectorize across the points.
+	 * @param grid the computational grid on which nodal quantities are
+	 * defined.
+	 * @param particles the particle set that holds the material points
+	 * @param begin the index of the first material point in the range
+	 * @param end the index one past the last material point in the range
+	 */
+	virtual void updateStrainRate(const Kelvin::Grid & grid,
+			ParticleSet & particles, const int & begin, const int & end);
+
+	/**
+	 * This operation updates the stress for a contiguous range of material
+	 * points, [begin,end), that all have a material id that maps to this
+	 * relationship. The default implementation calls
+	 * updateStress(const Kelvin::Grid &, ParticleSet &, const int &) for
+	 * each point.
+	 * @param grid the computational grid on which nodal quantities are
+	 * defined.
+	 * @param particles the particle set that holds the material points
+	 * @param begin the index of the first material point in the range
+	 * @param end the index one past the last material point in the range
+	 */
+	virtual void updateStress(const Kelvin::Grid & grid,
+			ParticleSet & particles, const int & begin, const int & end);
+
+	/**
+	 * This operation updates the strain rate at the material points. The
+	 * material point is copied into a particle set and back. Since single
+	 * points are not updated as part of a time step, beginStep() is called
+	 * first.
+	 * @param grid the computational grid on which nodal quantities are
+	 * defined.
+	 * @param the material point at which the strains should be updated.
+	 */
+	void updateStrainRate(const Kelvin::Grid & grid,
+			Kelvin::MaterialPoint & matPoint);
+
+	/**
+	 * This operation updates the stress at the material points. The material
+	 * point is copied into a particle set and back. Since single points are
+	 * not updated as part of a time step, beginStep() is called first.
+	 * @param grid the computational grid on which nodal quantities are
+	 * defined.
+	 * @param the material point at which the strains should be updated.
+	 */
+	void updateStress(const Kelvin::Grid & grid,
+			Kelvin::MaterialPoint & matPoint);
 
 };
 
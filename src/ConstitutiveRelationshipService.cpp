@@ -65,4 +65,10 @@ ConstitutiveRelationship &
 	return *_relationships[id];
 }
 
+void ConstitutiveRelationshipService::beginStep(const Kelvin::Grid & grid) {
+	for (auto & relationship : _relationships) {
+		relationship.second->beginStep(grid);
+	}
+}
+
 } /* namespace Kelvin */
@@ -76,6 +76,15 @@ public:
 	 */
 	static ConstitutiveRelationship & get(const int & id);
 
+	/**
+	 * This operation calls beginStep() on every registered constitutive
+	 * relationship. It should be called once per time step after the grid
+	 * has been updated and before any material points are updated.
+	 * @param grid the computational grid on which nodal quantities are
+	 * defined.
+	 */
+	static void beginStep(const Kelvin::Grid & grid);
+
 	/**
 	 * Destructor
 	 */
@@ -0,0 +1,217 @@
+/**----------------------------------------------------------------------------
+ Copyright  2018-, UT-Battelle, LLC
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ Author(s): Jay Jay Billings (billingsjj <at> ornl <dot> gov)
+ -----------------------------------------------------------------------------*/
+#include <ElementLocator.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace Kelvin {
+
+constexpr double ElementLocator::tolerance;
+
+ElementLocator::ElementLocator(mfem::Mesh & mesh) : mesh(mesh),
+		dim(mesh.Dimension()) {
+
+	int numElements = mesh.GetNE();
+
+	// Compute the bounding box of every element from its vertices and the
+	// bounding box of the mesh from those.
+	std::vector<double> boxes(numElements*2*dim);
+	for (int j = 0; j < dim; j++) {
+		lower[j] = std::numeric_limits<double>::max();
+		upper[j] = std::numeric_limits<double>::lowest();
+	}
+	mfem::Array<int> vertexIds;
+	for (int i = 0; i < numElements; i++) {
+		double * boxLower = &boxes[i*2*dim];
+		double * boxUpper = boxLower + dim;
+		std::fill(boxLower,boxUpper,std::numeric_limits<double>::max());
+		std::fill(boxUpper,boxUpper+dim,std::numeric_limits<double>::lowest());
+		mesh.GetElementVertices(i,vertexIds);
+		for (int k = 0; k < vertexIds.Size(); k++) {
+			const double * vertex = mesh.GetVertex(vertexIds[k]);
+			for (int j = 0; j < dim; j++) {
+				boxLower[j] = std::min(boxLower[j],vertex[j]);
+				boxUpper[j] = std::max(boxUpper[j],vertex[j]);
+			}
+		}
+		for (int j = 0; j < dim; j++) {
+			lower[j] = std::min(lower[j],boxLower[j]);
+			upper[j] = std::max(upper[j],boxUpper[j]);
+		}
+	}
+	if (numElements == 0) {
+		bucketOffsets.assign(2,0);
+		return;
+	}
+
+	// Pick a bucket width so that there is about one element per bucket,
+	// based on the volume of the mesh's bounding box. Flat directions get a
+	// single bucket.
+	double volume = 1.0;
+	int numWideDims = 0;
+	for (int j = 0; j < dim; j++) {
+		double width = upper[j] - lower[j];
+		if (width > 0.0) {
+			volume *= width;
+			numWideDims++;
+		}
+	}
+	double bucketWidth = (numWideDims > 0) ?
+			std::pow(volume/numElements,1.0/numWideDims) : 1.0;
+	int totalBuckets = 1;
+	for (int j = 0; j < dim; j++) {
+		double width = upper[j] - lower[j];
+		numBuckets[j] = (width > 0.0) ?
+				std::max(1,(int) std::ceil(width/bucketWidth)) : 1;
+		inverseWidth[j] = (width > 0.0) ? numBuckets[j]/width : 0.0;
+		totalBuckets *= numBuckets[j];
+	}
+
+	// Count the elements in each bucket, then fill the lists. The elements
+	// are visited in order, so each list is sorted by id.
+	std::vector<std::array<int,3>> first(numElements), last(numElements);
+	bucketOffsets.assign(totalBuckets+1,0);
+	for (int pass = 0; pass < 2; pass++) {
+		std::vector<int> fill;
+		if (pass == 1) {
+			for (int b = 0; b < totalBuckets; b++) {
+				bucketOffsets[b+1] += bucketOffsets[b];
+			}
+			bucketElements.resize(bucketOffsets[totalBuckets]);
+			fill.assign(bucketOffsets.begin(),bucketOffsets.end()-1);
+		}
+		for (int i = 0; i < numElements; i++) {
+			auto & lo = first[i];
+			auto & hi = last[i];
+			if (pass == 0) {
+				// Pad the box a little so that points on its faces are found
+				double * boxLower = &boxes[i*2*dim];
+				double * boxUpper = boxLower + dim;
+				std::array<double,3> paddedLower{}, paddedUpper{};
+				for (int j = 0; j < dim; j++) {
+					double pad = tolerance*std::max(1.0,upper[j]-lower[j]);
+					paddedLower[j] = boxLower[j] - pad;
+					paddedUpper[j] = boxUpper[j] + pad;
+				}
+				bucketIndex(paddedLower.data(),lo);
+				bucketIndex(paddedUpper.data(),hi);
+			}
+			for (int z = lo[2]; z <= hi[2]; z++) {
+				for (int y = lo[1]; y <= hi[1]; y++) {
+					for (int x = lo[0]; x <= hi[0]; x++) {
+						int b = x + numBuckets[0]*(y + numBuckets[1]*z);
+						if (pass == 0) {
+							bucketOffsets[b+1]++;
+						} else {
+							bucketElements[fill[b]++] = i;
+						}
+					}
+				}
+			}
+		}
+	}
+
+}
+
+void ElementLocator::bucketIndex(const double * point,
+		std::array<int,3> & index) const {
+	index = {0,0,0};
+	for (int j = 0; j < dim; j++) {
+		int k = (int) std::floor((point[j] - lower[j])*inverseWidth[j]);
+		index[j] = std::min(std::max(k,0),numBuckets[j]-1);
+	}
+}
+
+int ElementLocator::locate(const double * point,
+		mfem::IntegrationPoint & intPoint) const {
+
+	// Points outside of the bounding box can't be in the mesh
+	for (int j = 0; j < dim; j++) {
+		double pad = tolerance*std::max(1.0,upper[j]-lower[j]);
+		if (point[j] < lower[j] - pad || point[j] > upper[j] + pad) {
+			return -1;
+		}
+	}
+
+	// Each thread gets its own scratch transformation since the one cached by
+	// the mesh is shared.
+	static thread_local mfem::IsoparametricTransformation transformation;
+	static thread_local mfem::Vector pointVec;
+	pointVec.SetSize(dim);
+	for (int j = 0; j < dim; j++) {
+		pointVec[j] = point[j];
+	}
+
+	// Check each element in the bucket
+	std::array<int,3> index;
+	bucketIndex(point,index);
+	int b = index[0] + numBuckets[0]*(index[1] + numBuckets[1]*index[2]);
+	int found = -1;
+	mfem::IntegrationPoint candidatePoint;
+	for (int k = bucketOffsets[b]; k < bucketOffsets[b+1]; k++) {
+		int elemId = bucketElements[k];
+		mesh.GetElementTransformation(elemId,&transformation);
+		int result = transformation.TransformBack(pointVec,candidatePoint);
+		if (result != mfem::InverseElementTransformation::Inside) {
+			continue;
+		}
+		// Prefer the element for which the point is not on an upper face.
+		// Otherwise keep the first element found in case there is no better
+		// one, such as on the upper boundary of the mesh.
+		double coords[3] = {candidatePoint.x,candidatePoint.y,candidatePoint.z};
+		bool onUpperFace = false;
+		for (int j = 0; j < dim; j++) {
+			onUpperFace = onUpperFace || (coords[j] > 1.0 - tolerance);
+		}
+		if (found == -1 || !onUpperFace) {
+			found = elemId;
+			intPoint = candidatePoint;
+		}
+		if (!onUpperFace) {
+			break;
+		}
+	}
+
+	return found;
+}
+
+int ElementLocator::locate(const double * point) const {
+	mfem::IntegrationPoint intPoint;
+	return locate(point,intPoint);
+}
+
+int ElementLocator::size() const {
+	return bucketOffsets.size() - 1;
+}
+
+} /* namespace Kelvin */
@@ -0,0 +1,155 @@
+/**----------------------------------------------------------------------------
+ Copyright  2018-, UT-Battelle, LLC
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ Author(s): Jay Jay Billings (billingsjj <at> ornl <dot> gov)
+ -----------------------------------------------------------------------------*/
+#ifndef SRC_ELEMENTLOCATOR_H_
+#define SRC_ELEMENTLOCATOR_H_
+
+#include <mfem.hpp>
+#include <array>
+#include <vector>
+
+namespace Kelvin {
+
+/**
+ * This class finds the element of a mesh that contains a point. It works on
+ * any mesh, including meshes that are not uniform, not aligned with the axes
+ * or not anchored at the origin.
+ *
+ * The bounding box of the mesh is divided into a uniform grid of buckets
+ * with about one element per bucket, and every element is listed in each
+ * bucket that its bounding box overlaps. A point is located by computing its
+ * bucket directly from its coordinates and then transforming it into the
+ * reference space of each element in that bucket until it is found inside of
+ * one, so the cost of a lookup does not depend on the size of the mesh.
+ *
+ * Points on a face that is shared by two elements are assigned to the
+ * element for which they are not on an upper face of the reference element
+ * (where a reference coordinate is 1). On a regular grid this is the element
+ * to the right, just like with the floor of the coordinates.
+ *
+ * The locator does not modify the mesh and can be used from multiple threads
+ * at once.
+ */
+class ElementLocator {
+protected:
+
+	/**
+	 * The mesh
+	 */
+	mfem::Mesh & mesh;
+
+	/**
+	 * The spatial dimension of the mesh
+	 */
+	int dim;
+
+	/**
+	 * The lower corner of the bucket grid
+	 */
+	std::array<double,3> lower{};
+
+	/**
+	 * The upper corner of the bucket grid
+	 */
+	std::array<double,3> upper{};
+
+	/**
+	 * The inverse of the width of a bucket in each direction
+	 */
+	std::array<double,3> inverseWidth{};
+
+	/**
+	 * The number of buckets in each direction
+	 */
+	std::array<int,3> numBuckets{{1,1,1}};
+
+	/**
+	 * The offset of the list of each bucket in bucketElements. The elements
+	 * of bucket b are bucketElements[bucketOffsets[b]] to
+	 * bucketElements[bucketOffsets[b+1]-1], in order of increasing id.
+	 */
+	std::vector<int> bucketOffsets;
+
+	/**
+	 * The ids of the elements in each bucket
+	 */
+	std::vector<int> bucketElements;
+
+	/**
+	 * This operation computes the index of the bucket in each direction for a
+	 * point, clamped to the bucket grid.
+	 * @param point the point
+	 * @param index the bucket index in each direction
+	 */
+	void bucketIndex(const double * point, std::array<int,3> & index) const;
+
+public:
+
+	/**
+	 * The relative tolerance used to decide if a point is inside of a bucket
+	 * or an element.
+	 */
+	static constexpr double tolerance = 1.0e-12;
+
+	/**
+	 * Constructor. The buckets are built here.
+	 * @param mesh the mesh
+	 */
+	ElementLocator(mfem::Mesh & mesh);
+
+	/**
+	 * This operation finds the element that contains a point and the
+	 * coordinates of the point in the reference space of that element.
+	 * @param point the point, with dimension entries
+	 * @param intPoint the reference coordinates of the point if it was found
+	 * @return the id of the element or -1 if the point is not in the mesh
+	 */
+	int locate(const double * point, mfem::IntegrationPoint & intPoint) const;
+
+	/**
+	 * The same as locate(const double *, mfem::IntegrationPoint &), but for
+	 * when only the element id is needed.
+	 * @param point the point, with dimension entries
+	 * @return the id of the element or -1 if the point is not in the mesh
+	 */
+	int locate(const double * point) const;
+
+	/**
+	 * This operation returns the number of buckets in the index.
+	 * @return the number of buckets
+	 */
+	int size() const;
+
+};
+
+} /* namespace Kelvin */
+
+#endif /* SRC_ELEMENTLOCATOR_H_ */
@@ -30,17 +30,25 @@
  Author(s): Jay Jay Billings (billingsjj <at> ornl <dot> gov)
  -----------------------------------------------------------------------------*/
 #include <Grid.h>
+#include <Profiler.h>
 #include <memory>
 #include <limits>
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 using namespace mfem;
 using namespace std;
 
 namespace Kelvin {
 
-Grid::Grid(MeshContainer & meshContainer) : _meshContainer(meshContainer){
-	// TODO Auto-generated constructor stub
-
+Grid::Grid(MeshContainer & meshContainer, const bool & sparse) :
+		_sparse(sparse), _meshContainer(meshContainer) {
+	// Hold the floor still until told otherwise
+	_boundaryConditions.emplace_back("floor","noSlip",dimension());
 }
 
 Grid::~Grid() {
@@ -63,17 +71,15 @@ void Grid::setForceVectorNodeIds() {
 	_internalForces.resize(numForces,emptyForceWithCorrectDimensionality);
 	_externalForces.resize(numForces,emptyForceWithCorrectDimensionality);
 	// Set the force node ids
-	set<int>::iterator it;
-	int index = 0;
-	for (it = _nodeSet.begin(); it != _nodeSet.end(); it++) {
-		_internalForces[index].nodeId = *it;
-		_externalForces[index].nodeId = *it;
-		index++;
+	for (int i = 0; i < numForces; i++) {
+		_internalForces[i].nodeId = _nodeSet[i];
+		_externalForces[i].nodeId = _nodeSet[i];
 	}
+	_nodeSetChanged = false;
 
 }
 
-void Grid::assemble(const std::vector<Kelvin::MaterialPoint> & particles) {
+void Grid::assemble(const ParticleSet & particles) {
 
 	// FIXME! This could just be a constructor!
 
@@ -82,6 +88,11 @@ void Grid::assemble(const std::vector<Kelvin::MaterialPoint> & particles) {
 	int numVerts = mesh.GetNV();
 	double * mcCoords;
 	int dim = _meshContainer.dimension();
+	_numNodes = numVerts;
+	// Sparse grids only store the nodes near particles, in the blocks
+	if (_sparse) {
+		numVerts = 0;
+	}
 	for (int i = 0; i < numVerts; i++) {
 		mcCoords = mesh.GetVertex(i);
 		Point point(dim);
@@ -95,66 +106,333 @@ void Grid::assemble(const std::vector<Kelvin::MaterialPoint> & particles) {
 		_nodes.push_back(point);
 	}
 
-	// Update the shape matrix
-	updateShapeMatrix(particles);
-
 	// Construct the mass matrix associated with the grid nodes
 	_massMatrix = make_unique<MassMatrix>(particles);
 
+	// Update the shape matrix. The new mass matrix has no nodes yet, so the
+	// shapes are built from scratch.
+	_stencils.clear();
+	updateShapeMatrix(particles);
+
 	// Resize the internal and external force vectors
 	setForceVectorNodeIds();
 
+	// Find the nodes on the boundaries
+	setupBoundaryNodes(_boundaryConditions);
+
 	return;
 }
 
-void Grid::updateShapeMatrix(
-		const std::vector<Kelvin::MaterialPoint> & particles) {
+void Grid::assemble(const std::vector<Kelvin::MaterialPoint> & particles) {
+	_particleAdapter.assign(particles);
+	assemble(_particleAdapter);
+}
 
-	// The shape matrix is very sparse, so this computation exploits that by only
-	// adding shape values for nodes that exist for the given particle.
-	_nodeSet.clear();
-	_gradientMap.clear();
+void Grid::updateShapeMatrix(const ParticleSet & particles) {
+
+	KELVIN_PROFILE_SCOPE("shapeUpdate");
+
+	// Each particle only touches the nodes of its own element, so the shapes
+	// and gradients are stored in a fixed size stencil per particle. The
+	// stencil list is only reallocated if the number of particles grows.
 	int numParticles = particles.size();
-	// Re-initialize the shape matrix
-	_shapeMatrix = make_unique<SparseMatrix>(numParticles,_nodes.size());
-	for (int i = 0; i < numParticles; i++) {
-		auto & matPoint = particles[i];
-		// Get the shape
-		auto id = getElementId(matPoint);
-		auto nodeIds = _meshContainer.getSurroundingNodeIds(matPoint.pos,id);
-		auto shape = _meshContainer.getNodalShapes(matPoint.pos,id);
-		for (int j = 0; j < shape.size(); j++) {
-			_shapeMatrix->Set(i,nodeIds[j],shape[j]);
-			_nodeSet.insert(nodeIds[j]);
+	int dim = _meshContainer.dimension();
+
+	// Use the cached locations of the particles if they are current.
+	// Otherwise locate them into scratch space since the set can't be changed
+	// here.
+	const int * elementIds = NULL;
+	const double * referencePos = NULL;
+	if (numParticles > 0) {
+		elementIds = &particles.elementId(0);
+		referencePos = particles.referencePos(0);
+		if (!particles.locationsAreCurrent()) {
+			_elementIds.resize(numParticles);
+			_referencePos.resize(numParticles*dim);
+			_meshContainer.locate(numParticles,particles.pos(0),
+					_elementIds.data(),_referencePos.data());
+			elementIds = _elementIds.data();
+			referencePos = _referencePos.data();
+		}
+	}
+
+	// The existing stencils can be updated in place if they belong to the
+	// same number of particles. Only particles that changed elements have
+	// different nodes, so take their old nodes out of the counts.
+	bool incremental = ((int) _stencils.size() == numParticles)
+			&& (_nodeSet.capacity() == _numNodes);
+	_migratedParticles.clear();
+	if (incremental) {
+		for (int i = 0; i < numParticles; i++) {
+			if (elementIds[i] != _stencils[i].elementId) {
+				_migratedParticles.push_back(i);
+				removeFromNodeCounts(_stencils[i]);
+			}
+		}
+	} else {
+		_stencils.resize(numParticles);
+		_nodeSet.resize(_numNodes);
+		_nodeBlocks.resize(_numNodes,dim,_sparse);
+		// Use tiles of the vertex lattice as blocks on Cartesian meshes so
+		// that the nodes of a stencil usually share a block.
+		auto & cartesianMesh = _meshContainer.getCartesianMesh();
+		if (cartesianMesh.hasLatticeVertexOrder()) {
+			std::array<int,3> latticeNodes{{1,1,1}};
+			for (int j = 0; j < dim; j++) {
+				latticeNodes[j] = cartesianMesh.cells(j) + 1;
+			}
+			_nodeBlocks.setLattice(latticeNodes);
+		}
+		_nodeSetChanged = true;
+	}
+
+	// Get the shapes and gradients without transforming the particles again.
+	// Stencils of particles that stayed in their element keep their nodes and
+	// only get new weights.
+	if (numParticles > 0) {
+		_meshContainer.computeStencils(numParticles,elementIds,referencePos,
+				_stencils.data());
+	}
+
+	// Add the new nodes of the particles that changed elements, or of every
+	// particle if the stencils were rebuilt.
+	if (incremental) {
+		for (int i : _migratedParticles) {
+			addToNodeCounts(_stencils[i]);
+		}
+	} else {
+		for (int i = 0; i < numParticles; i++) {
+			addToNodeCounts(_stencils[i]);
+			_migratedParticles.push_back(i);
+		}
+	}
+
+	// Point the mass matrix at the new shapes and mark the lumped masses as
+	// out of date. The node set is only compacted if it changed.
+	if (!incremental || !_nodeSet.isCompacted()) {
+		_nodeSet.compact();
+		_massMatrix->assemble(particles,_stencils,_nodeSet);
+	} else {
+		_massMatrix->updateShapes(particles);
+	}
+	_lumpedMassIsCurrent = false;
+	_transferIsCurrent = false;
+	_stencilGeneration = particles.generation();
+}
+
+void Grid::addToNodeCounts(const ParticleStencil & stencil) {
+	for (int k = 0; k < stencil.numNodes; k++) {
+		int nodeId = stencil.nodeIds[k];
+		if (_nodeBlocks.activate(nodeId)) {
+			_nodeSet.insert(nodeId);
+			_nodeSetChanged = true;
+		}
+	}
+}
+
+void Grid::removeFromNodeCounts(const ParticleStencil & stencil) {
+	for (int k = 0; k < stencil.numNodes; k++) {
+		int nodeId = stencil.nodeIds[k];
+		if (_nodeBlocks.deactivate(nodeId)) {
+			_nodeSet.erase(nodeId);
+			_nodeSetChanged = true;
 		}
-		// Get the gradients associated with the particle
-		auto gradients = _meshContainer.getNodalGradients(matPoint.pos,id);
-		_gradientMap[i] = gradients;
 	}
-	_shapeMatrix->Finalize();
-	_shapeMatrix->SortColumnIndices();
+}
+
+int Grid::numMigratedParticles() const {
+	return _migratedParticles.size();
 }
 
 void Grid::update() {
 
-	// Get the diagonalized form of the mass matrix
-	auto diagonalMassMatrix = _massMatrix->lump();
+	// Bring the diagonalized form of the mass matrix up to date
+	lumpedMass();
 
 }
 
-const std::map<int,std::vector<Gradient>> & Grid::gradients() const {
-	return _gradientMap;
+const std::vector<double> & Grid::lumpedMass() {
+	// Only lump the mass matrix if the shapes changed since the last call
+	if (!_lumpedMassIsCurrent) {
+		_massMatrix->lump(_lumpedMass);
+		_lumpedMassIsCurrent = true;
+	}
+	return _lumpedMass;
 }
 
+const std::vector<ParticleStencil> & Grid::stencils() const {
+	return _stencils;
+}
+
+bool Grid::hasStencilsFor(const ParticleSet & particles) const {
+	return _stencilGeneration == particles.generation();
+}
 
-void Grid::computeVectorMatrixProduct(const std::vector<double> & vec,
-		const std::vector<std::vector<double>> & matrix,
-		std::vector<double> & resultVec) {
 
-	int dim = vec.size();
-	for (int i = 0; i < dim; i++) {
-		for (int j = 0; j < dim; j++) {
-			resultVec[i] += vec[j]*matrix[j][i];
+template<int Dim>
+void Grid::scatterInternalForces(const ParticleSet & particles,
+		const int & begin, const int & end, double * force) const {
+	for (int i = begin; i < end; i++) {
+		const double * stress = particles.stress(i);
+		double negMass = -particles.mass(i);
+		auto & stencil = _stencils[i];
+		for (int k = 0; k < stencil.numNodes; k++) {
+			auto & grad = stencil.gradients[k];
+			double * nodeForce = force
+					+ _nodeBlocks.index(stencil.nodeIds[k])*Dim;
+			// f_l += -m_p * \sum_j dN/dx_j * stress_jl
+			for (int l = 0; l < Dim; l++) {
+				double gradDotStress = 0.0;
+				for (int j = 0; j < Dim; j++) {
+					gradDotStress += grad[j]*stress[j*Dim+l];
+				}
+				nodeForce[l] += negMass*gradDotStress;
+			}
+		}
+	}
+}
+
+template<int Dim>
+void Grid::computeNodalAccelerations() {
+	int numNodes = _nodeSet.size();
+	#pragma omp parallel for schedule(static)
+	for (int k = 0; k < numNodes; k++) {
+		int index = _nodeBlocks.index(_nodeSet[k]);
+		double * nodalAcc = _nodeBlocks.accelerations() + index*Dim;
+		const double * force = _nodeBlocks.forces() + index*Dim;
+		double mass = _nodeBlocks.masses()[index];
+		for (int j = 0; j < Dim; j++) {
+			nodalAcc[j] = force[j]/mass;
+		}
+	}
+}
+
+template<int Dim>
+void Grid::computeNodalVelocitiesFromMomenta() {
+	// Only compute the velocity for the nodes that have mass
+	int numNodes = _nodeSet.size();
+	#pragma omp parallel for schedule(static)
+	for (int k = 0; k < numNodes; k++) {
+		int index = _nodeBlocks.index(_nodeSet[k]);
+		double * nodalVel = _nodeBlocks.velocities() + index*Dim;
+		const double * momentum = _nodeBlocks.momenta() + index*Dim;
+		double mass = _nodeBlocks.masses()[index];
+		for (int j = 0; j < Dim; j++) {
+			nodalVel[j] = momentum[j] / mass;
+		}
+	}
+}
+
+template<int Dim>
+void Grid::integrateNodalVelocities(const double & timeStep) {
+	int numNodes = _nodeSet.size();
+	#pragma omp parallel for schedule(static)
+	for (int k = 0; k < numNodes; k++) {
+		int index = _nodeBlocks.index(_nodeSet[k]);
+		double * nodalVel = _nodeBlocks.velocities() + index*Dim;
+		const double * nodalAcc = _nodeBlocks.accelerations() + index*Dim;
+		for (int j = 0; j < Dim; j++) {
+			nodalVel[j] += timeStep*nodalAcc[j];
+		}
+	}
+}
+
+template<int Dim>
+void Grid::scatterExternalForces(const ParticleSet & particles,
+		const int & begin, const int & end, double * force) const {
+	for (int i = begin; i < end; i++) {
+		auto & stencil = _stencils[i];
+		double mass = particles.mass(i);
+		const double * bodyForce = particles.bodyForce(i);
+		for (int k = 0; k < stencil.numNodes; k++) {
+			double weightedMass = stencil.weights[k] * mass;
+			double * nodeForce = force
+					+ _nodeBlocks.index(stencil.nodeIds[k])*Dim;
+			for (int l = 0; l < Dim; l++) {
+				nodeForce[l] += weightedMass * bodyForce[l];
+			}
+		}
+	}
+}
+
+template<int Dim>
+void Grid::scatterToGrid(const ParticleSet & particles, const int & begin,
+		const int & end, double * mass, double * momentum,
+		double * force) const {
+	for (int i = begin; i < end; i++) {
+		auto & stencil = _stencils[i];
+		double particleMass = particles.mass(i);
+		const double * vel = particles.vel(i);
+		const double * bodyForce = particles.bodyForce(i);
+		const double * stress = particles.stress(i);
+		for (int k = 0; k < stencil.numNodes; k++) {
+			auto & grad = stencil.gradients[k];
+			double weightedMass = stencil.weights[k] * particleMass;
+			int index = _nodeBlocks.index(stencil.nodeIds[k]);
+			double * nodeMomentum = momentum + index*Dim;
+			double * nodeForce = force + index*Dim;
+			mass[index] += weightedMass;
+			// f_l += m_p * N * b_l - m_p * \sum_j dN/dx_j * stress_jl
+			for (int l = 0; l < Dim; l++) {
+				double gradDotStress = 0.0;
+				for (int j = 0; j < Dim; j++) {
+					gradDotStress += grad[j]*stress[j*Dim+l];
+				}
+				nodeMomentum[l] += weightedMass * vel[l];
+				nodeForce[l] += weightedMass * bodyForce[l]
+						- particleMass * gradDotStress;
+			}
+		}
+	}
+}
+
+template<int NumOutputs, typename Kernel>
+void Grid::scatterParticles(const int & numParticles,
+		const std::array<double *,NumOutputs> & outputs,
+		const std::array<int,NumOutputs> & sizes, Kernel kernel) {
+
+	int numBlocks = maxThreads();
+	// Don't bother with private buffers if there is only one thread or too
+	// few particles to go around.
+	if (numBlocks == 1 || numParticles < numBlocks) {
+		kernel(0,numParticles,outputs);
+		return;
+	}
+
+	// Give each block a private copy of each output, one after the other
+	std::array<long,NumOutputs> offsets;
+	long blockSize = 0;
+	for (int o = 0; o < NumOutputs; o++) {
+		offsets[o] = blockSize;
+		blockSize += sizes[o];
+	}
+	_threadBuffers.assign(numBlocks*blockSize,0.0);
+	double * buffers = _threadBuffers.data();
+
+	#pragma omp parallel
+	{
+		// Scatter the blocks. The blocks are fixed by the thread count, so
+		// any thread can handle any block.
+		#pragma omp for schedule(static)
+		for (int b = 0; b < numBlocks; b++) {
+			int begin = (int) (((long) numParticles*b)/numBlocks);
+			int end = (int) (((long) numParticles*(b+1))/numBlocks);
+			std::array<double *,NumOutputs> blockOutputs;
+			for (int o = 0; o < NumOutputs; o++) {
+				blockOutputs[o] = buffers + b*blockSize + offsets[o];
+			}
+			kernel(begin,end,blockOutputs);
+		}
+		// Sum the blocks in order so that the result is deterministic
+		for (int o = 0; o < NumOutputs; o++) {
+			double * output = outputs[o];
+			const double * blockOutput = buffers + offsets[o];
+			#pragma omp for schedule(static)
+			for (int i = 0; i < sizes[o]; i++) {
+				for (int b = 0; b < numBlocks; b++) {
+					output[i] += blockOutput[b*blockSize+i];
+				}
+			}
 		}
 	}
 
@@ -162,242 +440,556 @@ void Grid::computeVectorMatrixProduct(const std::vector<double> & vec,
 }
 
 const std::vector<ForceVector> & Grid::internalForces(
-		const std::vector<Kelvin::MaterialPoint> & particles) {
+		const ParticleSet & particles) {
 
 	/**
 	 * This operation computes the internal forces according to Sulsky's 1994
 	 * paper:
 	 * f = -\sum_p M_p * G_ip^T * stress_p
+	 *
+	 * The sum is computed as a particle-major scatter: each particle walks
+	 * its own stencil of gradients exactly once and accumulates its
+	 * contribution into a nodal buffer, so the cost is proportional to
+	 * the number of particles times the stencil size instead of the number
+	 * of massive nodes times the number of particles.
 	 */
 
-	// Compute the forces
-	int numForces = _internalForces.size();
 	int dim = _meshContainer.dimension();
+	// The force vectors only need new node ids if the massive node set
+	// changed.
+	if (_nodeSetChanged) {
+		setForceVectorNodeIds();
+	}
+	// Clear the buffer. It covers the node blocks so that it is indexed the
+	// same way.
+	int bufferSize = _nodeBlocks.capacity()*dim;
+	_nodalForceBuffer.assign(bufferSize,0.0);
+	// Dispatch to the kernel for the dimension so that the inner loops have
+	// fixed lengths.
 	int numParticles = particles.size();
+	std::array<double *,1> outputs{{_nodalForceBuffer.data()}};
+	std::array<int,1> sizes{{bufferSize}};
+	switch (dim) {
+	case 2:
+		scatterParticles<1>(numParticles,outputs,sizes,
+				[&](int begin, int end, const std::array<double *,1> & out) {
+			scatterInternalForces<2>(particles,begin,end,out[0]);
+		});
+		break;
+	case 3:
+		scatterParticles<1>(numParticles,outputs,sizes,
+				[&](int begin, int end, const std::array<double *,1> & out) {
+			scatterInternalForces<3>(particles,begin,end,out[0]);
+		});
+		break;
+	default:
+		throw "Unsupported grid dimension. Only 2D and 3D grids are supported.";
+	}
+
+	// Gather the massive nodes out of the buffer into the force vectors,
+	// which are ordered the same way as the massive node set.
+	int numForces = _internalForces.size();
 	for (int i = 0; i < numForces; i++) {
 		auto & forceVector = _internalForces[i];
-		forceVector.clear();
-		int forceNodeId = forceVector.nodeId;
-		// Computer the component of the force due to each particle. The
-		// gradient map contains the gradients for each particle for each
-		// surrounding node, so we need to look to see if the node id
-		// of any of those gradients matches the node id of force vector.
-		for (int j = 0; j < numParticles; j++) {
-			auto & mPoint = particles[j];
-			auto & gradients = _gradientMap[j];
-			auto numGrads = gradients.size();
-			// Compute the component due to each gradient vector
-			for (int k = 0; k < numGrads; k++) {
-				auto & grad = gradients[k];
-				int nodeId = grad.nodeId;
-				// ... iff the node is near the particle
-				if (nodeId == forceNodeId) {
-					// Compute the product of the gradient vector and stress
-					// tensor. It is easiest to compute it in the place of the
-					// force vector, then multiply the force vector by the
-					// -1.0*m_p to get the correct result.
-					computeVectorMatrixProduct(grad.values,mPoint.stress,
-							forceVector.values);
-					// Need to compute it over all dimensions
-					for (int l = 0; l < dim; l++) {
-						forceVector.values[l] *= -mPoint.mass;
-					}
-				}
-			}
+		const double * force =
+				&_nodalForceBuffer[_nodeBlocks.index(forceVector.nodeId)*dim];
+		for (int l = 0; l < dim; l++) {
+			forceVector.values[l] = force[l];
 		}
 	}
 
 	return _internalForces;
 }
 
-const std::vector<ForceVector> & Grid::externalForces(
+const std::vector<ForceVector> & Grid::internalForces(
 		const std::vector<Kelvin::MaterialPoint> & particles) {
+	_particleAdapter.assign(particles);
+	return internalForces(_particleAdapter);
+}
+
+const std::vector<ForceVector> & Grid::externalForces(
+		const ParticleSet & particles) {
 
 	/**
-	 * This operation computes the internal forces according to Sulsky's 1994
+	 * This operation computes the external forces according to Sulsky's 1994
 	 * paper:
 	 * f = \sum_p M_p * S_ip^T * bodyForces_p
+	 *
+	 * Like the internal forces, this is a particle-major scatter over the
+	 * particle stencils into a nodal buffer.
 	 */
 
-	Vector rowI;
-	Array<int> colsI;
-
-	// Compute the forces
-	int numForces = _externalForces.size();
 	int dim = _meshContainer.dimension();
+	if (_nodeSetChanged) {
+		setForceVectorNodeIds();
+	}
+	int bufferSize = _nodeBlocks.capacity()*dim;
+	_nodalForceBuffer.assign(bufferSize,0.0);
 	int numParticles = particles.size();
+	std::array<double *,1> outputs{{_nodalForceBuffer.data()}};
+	std::array<int,1> sizes{{bufferSize}};
+	switch (dim) {
+	case 2:
+		scatterParticles<1>(numParticles,outputs,sizes,
+				[&](int begin, int end, const std::array<double *,1> & out) {
+			scatterExternalForces<2>(particles,begin,end,out[0]);
+		});
+		break;
+	case 3:
+		scatterParticles<1>(numParticles,outputs,sizes,
+				[&](int begin, int end, const std::array<double *,1> & out) {
+			scatterExternalForces<3>(particles,begin,end,out[0]);
+		});
+		break;
+	default:
+		throw "Unsupported grid dimension. Only 2D and 3D grids are supported.";
+	}
+
+	// Gather the external forces at the massive nodes
+	int numForces = _externalForces.size();
 	for (int i = 0; i < numForces; i++) {
 		auto & forceVector = _externalForces[i];
-		forceVector.clear();
-		int forceNodeId = forceVector.nodeId;
-		// Compute the component of the force due to each particle. The shape
-		// matrix contains all the shapes and the nodeset describes which nodes
-		// are massive.
-		for (int j = 0; j < numParticles; j++) {
-			auto & mPoint = particles[j];
-			_shapeMatrix->GetRow(j, colsI, rowI);
-			int colI = colsI.Find(forceNodeId);
-			// Must confirm that the particle is near the node, which means
-			// checking the placement in the columns array.
-			if (colI >= 0) {
-				// Compute over all dimensions.
-				for (int l = 0; l < dim; l++) {
-					forceVector.values[l] += rowI[colI] * mPoint.mass
-							* mPoint.bodyForce[l];
-				}
-			}
+		const double * force =
+				&_nodalForceBuffer[_nodeBlocks.index(forceVector.nodeId)*dim];
+		for (int l = 0; l < dim; l++) {
+			forceVector.values[l] = force[l];
 		}
 	}
 
 	return _externalForces;
 }
 
-MassMatrix & Grid::massMatrix(
+const std::vector<ForceVector> & Grid::externalForces(
 		const std::vector<Kelvin::MaterialPoint> & particles) {
-	_massMatrix->assemble(*_shapeMatrix,_nodeSet);
+	_particleAdapter.assign(particles);
+	return externalForces(_particleAdapter);
+}
+
+MassMatrix & Grid::massMatrix(const ParticleSet & particles) {
+	_massMatrix->assemble(particles,_stencils,_nodeSet);
 	return *_massMatrix;
 }
 
+MassMatrix & Grid::massMatrix(
+		const std::vector<Kelvin::MaterialPoint> & particles) {
+	_particleAdapter.assign(particles);
+	return massMatrix(_particleAdapter);
+}
+
 MassMatrix & Grid::massMatrix() {
 	return *_massMatrix;
 }
 
 const std::vector<Point> & Grid::nodes() const {
+	if (_sparse) {
+		throw "Sparse grids do not store the nodes as Points. Use nodalVelocity() and nodalAcceleration() instead.";
+	}
 	return _nodes;
 }
 
-void Grid::updateNodalAccelerations(const double & timeStep,
-		const std::vector<Kelvin::MaterialPoint> & particles) {
+void Grid::accumulateNodalQuantities(const ParticleSet & particles) {
+
+	/**
+	 * This is the whole particle-to-grid transfer of Sulsky's 1994 paper in
+	 * one particle-major scatter:
+	 * m_i = \sum_p M_p * S_ip (the lumped mass, steps 8 & 10)
+	 * p_i = \sum_p M_p * S_ip * v_p (step 11)
+	 * f_i = \sum_p M_p * S_ip * b_p - \sum_p M_p * G_ip^T * stress_p (step 9)
+	 *
+	 * The three quantities go into separate arrays in the node blocks, so
+	 * each is contiguous for the nodal updates that read it, and only the
+	 * blocks near particles are cleared and summed.
+	 */
+	KELVIN_PROFILE_SCOPE("particleToGrid");
+	KELVIN_PROFILE_COUNT("massiveNodes",_nodeSet.size());
 
 	int dim = _meshContainer.dimension();
-	// Update the shape matrix
+	int numNodes = _nodeBlocks.capacity();
+	int bufferSize = numNodes*dim;
+	_nodeBlocks.clearTransfer();
+	int numParticles = particles.size();
+	std::array<double *,3> outputs{{_nodeBlocks.masses(),
+		_nodeBlocks.momenta(),_nodeBlocks.forces()}};
+	std::array<int,3> sizes{{numNodes,bufferSize,bufferSize}};
+	switch (dim) {
+	case 2:
+		scatterParticles<3>(numParticles,outputs,sizes,
+				[&](int begin, int end, const std::array<double *,3> & out) {
+			scatterToGrid<2>(particles,begin,end,out[0],out[1],out[2]);
+		});
+		break;
+	case 3:
+		scatterParticles<3>(numParticles,outputs,sizes,
+				[&](int begin, int end, const std::array<double *,3> & out) {
+			scatterToGrid<3>(particles,begin,end,out[0],out[1],out[2]);
+		});
+		break;
+	default:
+		throw "Unsupported grid dimension. Only 2D and 3D grids are supported.";
+	}
+
+	// The lumped masses are the nodal masses, so there is no need to lump the
+	// mass matrix separately.
+	int numMassiveNodes = _nodeSet.size();
+	_lumpedMass.resize(numMassiveNodes);
+	for (int k = 0; k < numMassiveNodes; k++) {
+		_lumpedMass[k] = _nodeBlocks.mass(_nodeSet[k]);
+	}
+	_lumpedMassIsCurrent = true;
+	_transferIsCurrent = true;
+
+	return;
+}
+
+void Grid::transferParticlesToGrid(const ParticleSet & particles) {
 	updateShapeMatrix(particles);
-	// Compute the mass matrix (Sulsky steps 8 & 10a)
-	auto & massMat = massMatrix(particles);
-	// Lump the mass matrix (Sulsky step 10b)
-	auto lumpedMassMat = massMat.lump();
-	// Compute the forces (Sulsky step 9)
-	setForceVectorNodeIds();
-	auto & intForces = internalForces(particles);
-	auto & exForces = externalForces(particles);
-	// I'm making an assumption here that the node sets for the internal and
-	// external forces match. That's reasonable given the implementation of the
-	// base class, but may not be in the case of a subclass.
-
-	// Only proceed if the sizes of these systems match. If they do not, this
-	// is a critical error, so it should be checked regularly.
-	bool sizesMatch = (intForces.size() == exForces.size())
-			&& (lumpedMassMat.size() == intForces.size());
-	if (sizesMatch) {
-		// Compute the acceleration and update the grid (Sulsky step 1)
-		int numNodes = _nodeSet.size();
-		// a_i = (f^int_i + f^ex_i)/m_i
-		for (int i = 0; i < numNodes; i++) {
-			auto & intForceVec = intForces[i];
-			auto & exForceVec = exForces[i];
-			// Under the nodeset assumption above, just get the node id from
-			// the internal force vector
-			int nodeId = intForceVec.nodeId;
-			for (int j = 0; j < dim; j++) {
-				// Note that the mass is non-dimensional (thus i, not j)
-				_nodes[nodeId].acc[j] = (intForceVec.values[j]
-						+ exForceVec.values[j])/lumpedMassMat[i];
-			}
+	accumulateNodalQuantities(particles);
+}
+
+const NodeBlocks & Grid::nodeBlocks() const {
+	return _nodeBlocks;
+}
+
+bool Grid::isSparse() const {
+	return _sparse;
+}
+
+int Grid::numNodes() const {
+	return _numNodes;
+}
+
+void Grid::syncNodes() {
+
+	if (_sparse) {
+		return;
+	}
+
+	int dim = _meshContainer.dimension();
+	int numNodes = _nodeSet.size();
+	#pragma omp parallel for schedule(static)
+	for (int k = 0; k < numNodes; k++) {
+		int nodeId = _nodeSet[k];
+		auto & node = _nodes[nodeId];
+		const double * vel = _nodeBlocks.velocity(nodeId);
+		const double * acc = _nodeBlocks.acceleration(nodeId);
+		for (int j = 0; j < dim; j++) {
+			node.vel[j] = vel[j];
+			node.acc[j] = acc[j];
 		}
-	} else {
-		throw "Mass matrix diagonal and force vector size mismatch (unequal).";
 	}
 
 	return;
 }
 
+void Grid::updateNodalAccelerations(const double & timeStep,
+		const ParticleSet & particles) {
+
+	// Update the shapes and compute the masses and forces (Sulsky steps 8-10)
+	transferParticlesToGrid(particles);
+	KELVIN_PROFILE_SCOPE("nodalUpdate");
+
+	// Compute the acceleration and update the grid (Sulsky step 1)
+	// a_i = (f^int_i + f^ex_i)/m_i
+	switch (_meshContainer.dimension()) {
+	case 2:
+		computeNodalAccelerations<2>();
+		break;
+	case 3:
+		computeNodalAccelerations<3>();
+		break;
+	default:
+		throw "Unsupported grid dimension. Only 2D and 3D grids are supported.";
+	}
+	syncNodes();
+
+	return;
+}
+
+void Grid::updateNodalAccelerations(const double & timeStep,
+		const std::vector<Kelvin::MaterialPoint> & particles) {
+	_particleAdapter.assign(particles);
+	updateNodalAccelerations(timeStep,_particleAdapter);
+}
+
+void Grid::updateNodalVelocitiesFromMomenta(const ParticleSet & particles) {
+	// Recompute the momenta with the present shapes since the particles may
+	// have changed since they were last transferred.
+	accumulateNodalQuantities(particles);
+	updateNodalVelocitiesFromMomenta();
+}
+
 void Grid::updateNodalVelocitiesFromMomenta(
 		const std::vector<Kelvin::MaterialPoint> & particles) {
+	_particleAdapter.assign(particles);
+	updateNodalVelocitiesFromMomenta(_particleAdapter);
+}
+
+void Grid::updateNodalVelocitiesFromMomenta() {
+
+	KELVIN_PROFILE_SCOPE("nodalUpdate");
 
 	// Update the nodal velocities based on particle momenta, Sulsky step 11.
 	// v_i = (\sum_p N_i(x_p) M_p v_p)/m_i
-	Vector rowI;
-	Array<int> colsI;
-	int dim = _meshContainer.dimension();
-	int k = 0;
-	auto & massMat = massMatrix();
-	auto lumpedMassMat = massMat.lump();
-	set<int>::iterator nodeIt;
-	int numParticles = particles.size();
-	// Only compute the velocity for the nodes that have mass
-	for (nodeIt = _nodeSet.begin(); nodeIt != _nodeSet.end(); nodeIt++) {
-		auto & nodalVel = _nodes[*nodeIt].vel;
-		// Clear the old values
-		nodalVel.clear();
-		// Compute the momentum due to each particle
-		for (int i = 0; i < numParticles; i++) {
-			auto & mPoint = particles[i];
-			// Get the shape
-			_shapeMatrix->GetRow(i, colsI, rowI);
-			int colI = colsI.Find(*nodeIt);
-			// Must confirm that the particle is near the node, which means
-			// checking the placement in the columns array.
-			if (colI >= 0) {
-				for (int j = 0; j < dim; j++) {
-					nodalVel[j] += (rowI[colI] * mPoint.mass * mPoint.vel[j])
-							/ lumpedMassMat[k];
-				}
-			}
-		}
-		k++;
+	if (!_transferIsCurrent) {
+		throw "The particles must be transferred to the grid before the nodal velocities can be computed from the momenta.";
+	}
+	switch (_meshContainer.dimension()) {
+	case 2:
+		computeNodalVelocitiesFromMomenta<2>();
+		break;
+	case 3:
+		computeNodalVelocitiesFromMomenta<3>();
+		break;
+	default:
+		throw "Unsupported grid dimension. Only 2D and 3D grids are supported.";
 	}
+	syncNodes();
 
 	return;
 }
 
-void Grid::updateNodalVelocities(const double & timeStep,
-		const std::vector<Kelvin::MaterialPoint> & particles) {
+void Grid::updateNodalVelocities(const double & timeStep) {
+
+	KELVIN_PROFILE_SCOPE("nodalUpdate");
 
 	// Update the velocities with a simple Euler update. Sulsky step 2.
-	Vector rowI;
-	Array<int> colsI;
-	int dim = _meshContainer.dimension();
-	set<int>::iterator nodeIt;
-	int numParticles = particles.size();
-	for (nodeIt = _nodeSet.begin(); nodeIt != _nodeSet.end(); nodeIt++) {
-		auto & nodalVel = _nodes[*nodeIt].vel;
-		auto & nodalAcc = _nodes[*nodeIt].acc;
-		for (int j = 0; j < dim; j++) {
-			nodalVel[j] += timeStep*nodalAcc[j];
-		}
+	switch (_meshContainer.dimension()) {
+	case 2:
+		integrateNodalVelocities<2>(timeStep);
+		break;
+	case 3:
+		integrateNodalVelocities<3>(timeStep);
+		break;
+	default:
+		throw "Unsupported grid dimension. Only 2D and 3D grids are supported.";
 	}
+	syncNodes();
 
 	return;
 }
 
-const std::set<int> & Grid::massiveNodeSet() {
+const ActiveNodeSet & Grid::massiveNodeSet() const {
 	return _nodeSet;
 }
 
-void Grid::applyNoSlipBoundaryConditions() {
-	int numNodes = _nodes.size();
+/**
+ * This function returns true if the name is a side that boundary conditions
+ * can be set on for a grid with the given dimension.
+ */
+static bool isBoundarySide(const std::string & name, const int & dim) {
+	// Mesh boundary attributes, side1, side2, etc.
+	if (name.size() > 4 && name.compare(0,4,"side") == 0) {
+		return std::all_of(name.begin() + 4,name.end(),::isdigit);
+	}
+	// Bounding box planes, xMin through zMax
+	if (name.size() == 4 && name[0] >= 'x' && name[0] < 'x' + dim) {
+		auto plane = name.substr(1);
+		return plane == "Min" || plane == "Max";
+	}
+	return false;
+}
+
+void Grid::setBoundaryConditions(
+		const std::map<std::string,std::string> & properties) {
+
+	int dim = dimension();
+	std::vector<VelocityBoundaryCondition> conditions;
+	for (auto & property : properties) {
+		if (isBoundarySide(property.first,dim)) {
+			conditions.emplace_back(property.first,property.second,dim);
+		}
+	}
+	// Keep the default if no sides were given
+	if (conditions.empty()) {
+		return;
+	}
+
+	// Free slip first, then no slip, then fixed velocities, so that a node on
+	// a free slip side and a no slip side is held still.
+	std::stable_sort(conditions.begin(),conditions.end(),
+			[](const VelocityBoundaryCondition & a,
+					const VelocityBoundaryCondition & b) {
+		return a.getType() < b.getType();
+	});
+	// Find the nodes now if the grid was already assembled
+	if (_numNodes > 0) {
+		setupBoundaryNodes(conditions);
+	}
+	_boundaryConditions = conditions;
+
+	return;
+}
+
+const std::vector<VelocityBoundaryCondition> & Grid::boundaryConditions()
+		const {
+	return _boundaryConditions;
+}
+
+void Grid::findBoundaryNodes(const std::string & side,
+		std::vector<int> & nodeIds, std::vector<double> & normals) const {
+
 	int dim = dimension();
-	double dz = 0.0;
-
-	// Do a node search for all nodes at z = 0 in 3D or y = 0 in 2D (so
-	// pos[dim-1]), then set the nodal velocities and accelerations equal to
-	// zero to impose the no slip condition.
-	for (int i =  0; i < numNodes; i++) {
-		auto & node = _nodes[i];
-		dz = node.pos[dim-1] - 0.0;
-		if (dz < numeric_limits<double>::epsilon()) {
+	int numNodes = _numNodes;
+	auto & mesh = _meshContainer.getMesh();
+	nodeIds.clear();
+	normals.clear();
+
+	// The floor, z = 0 in 3D or y = 0 in 2D (so pos[dim-1])
+	if (side == "floor") {
+		for (int i = 0; i < numNodes; i++) {
+			if (mesh.GetVertex(i)[dim-1] < numeric_limits<double>::epsilon()) {
+				nodeIds.push_back(i);
+				normals.resize(nodeIds.size()*dim,0.0);
+				normals[(nodeIds.size()-1)*dim + dim-1] = -1.0;
+			}
+		}
+		return;
+	}
+
+	// A plane of the bounding box
+	if (side.compare(0,4,"side") != 0) {
+		int axis = side[0] - 'x';
+		bool isMax = side.compare(1,3,"Max") == 0;
+		double lower = numeric_limits<double>::max();
+		double upper = numeric_limits<double>::lowest();
+		for (int i = 0; i < numNodes; i++) {
+			lower = std::min(lower,mesh.GetVertex(i)[axis]);
+			upper = std::max(upper,mesh.GetVertex(i)[axis]);
+		}
+		double plane = (isMax) ? upper : lower;
+		double tolerance = 1.0e-10*std::max(upper - lower,1.0);
+		for (int i = 0; i < numNodes; i++) {
+			if (std::fabs(mesh.GetVertex(i)[axis] - plane) <= tolerance) {
+				nodeIds.push_back(i);
+				normals.resize(nodeIds.size()*dim,0.0);
+				normals[(nodeIds.size()-1)*dim + axis] = (isMax) ? 1.0 : -1.0;
+			}
+		}
+		return;
+	}
+
+	// The boundary elements of the mesh with the attribute of the side. The
+	// normals of the elements are accumulated at their vertices, which are
+	// the grid nodes.
+	int attribute = std::stoi(side.substr(4));
+	std::vector<double> nodeNormals(numNodes*dim,0.0);
+	std::vector<char> onSide(numNodes,0);
+	mfem::Array<int> vertices;
+	int numBdrElements = mesh.GetNBE();
+	for (int i = 0; i < numBdrElements; i++) {
+		if (mesh.GetBdrAttribute(i) != attribute) {
+			continue;
+		}
+		mesh.GetBdrElementVertices(i,vertices);
+		// The normal of a segment is its tangent turned by 90 degrees, and
+		// the normal of a triangle or quadrilateral is the cross product of
+		// two of its edges or its diagonals.
+		double normal[3] = {0.0,0.0,0.0};
+		const double * v0 = mesh.GetVertex(vertices[0]);
+		const double * v1 = mesh.GetVertex(vertices[1]);
+		if (dim == 2) {
+			normal[0] = v1[1] - v0[1];
+			normal[1] = -(v1[0] - v0[0]);
+		} else {
+			const double * a = v0, * b = v1, * c = v0,
+					* d = mesh.GetVertex(vertices[2]);
+			if (vertices.Size() > 3) {
+				a = v0; b = mesh.GetVertex(vertices[2]);
+				c = v1; d = mesh.GetVertex(vertices[3]);
+			}
+			double e1[3], e2[3];
+			for (int j = 0; j < 3; j++) {
+				e1[j] = b[j] - a[j];
+				e2[j] = d[j] - c[j];
+			}
+			normal[0] = e1[1]*e2[2] - e1[2]*e2[1];
+			normal[1] = e1[2]*e2[0] - e1[0]*e2[2];
+			normal[2] = e1[0]*e2[1] - e1[1]*e2[0];
+		}
+		for (int k = 0; k < vertices.Size(); k++) {
+			int nodeId = vertices[k];
+			double * nodeNormal = &nodeNormals[nodeId*dim];
+			// Boundary elements aren't always oriented the same way, so flip
+			// the normal to agree with what is already at the node.
+			double dot = 0.0;
+			for (int j = 0; j < dim; j++) {
+				dot += nodeNormal[j]*normal[j];
+			}
+			double sign = (dot < 0.0) ? -1.0 : 1.0;
 			for (int j = 0; j < dim; j++) {
-				node.vel[j] = 0.0;
-				node.acc[j] = 0.0;
+				nodeNormal[j] += sign*normal[j];
 			}
+			onSide[nodeId] = 1;
 		}
 	}
+	for (int i = 0; i < numNodes; i++) {
+		if (onSide[i]) {
+			nodeIds.push_back(i);
+			normals.insert(normals.end(),&nodeNormals[i*dim],
+					&nodeNormals[i*dim] + dim);
+		}
+	}
+
+	return;
+}
+
+void Grid::setupBoundaryNodes(
+		std::vector<VelocityBoundaryCondition> & conditions) const {
+
+	std::vector<int> nodeIds;
+	std::vector<double> normals;
+	for (auto & condition : conditions) {
+		findBoundaryNodes(condition.getSide(),nodeIds,normals);
+		// The floor is the default and may well be missing from the mesh, but
+		// a side that was asked for should be there.
+		if (nodeIds.empty() && condition.getSide() != "floor") {
+			throw "No grid nodes were found on a side with a boundary condition.";
+		}
+		condition.setNodes(nodeIds,normals);
+	}
+
+	return;
+}
+
+void Grid::applyBoundaryConditions() {
+	KELVIN_PROFILE_SCOPE("boundaryConditions");
+	// Only the boundary nodes are touched
+	for (auto & condition : _boundaryConditions) {
+		condition.apply(_nodeBlocks);
+	}
+	syncNodes();
+	return;
+}
+
+void Grid::applyNoSlipBoundaryConditions() {
+	applyBoundaryConditions();
+}
+
+void Grid::locateParticles(ParticleSet & particles) const {
+
+	if (particles.locationsAreCurrent()) {
+		return;
+	}
+	KELVIN_PROFILE_SCOPE("locate");
+
+	// Locate all of the particles straight into the cache in one batch
+	int numParticles = particles.size();
+	if (numParticles > 0) {
+		_meshContainer.locate(numParticles,particles.pos(0),
+				&particles.elementId(0),particles.referencePos(0));
+	}
+	particles.validateLocations();
 
 	return;
 }
 
 int Grid::getElementId(const Kelvin::MaterialPoint & point) const {
-	return _meshContainer.getElementIdFromHexMesh(point.pos);
+	return _meshContainer.getElementId(point.pos.data());
+}
+
+int Grid::getElementId(const ParticleSet & particles,
+		const int & index) const {
+	return _meshContainer.getElementId(particles.pos(index));
 }
 
 } /* namespace Kelvin */
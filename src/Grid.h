@@ -33,13 +33,19 @@
 #define SRC_GRID_H_
 
 #include <MaterialPoint.h>
+#include <ParticleSet.h>
 #include <mfem.hpp>
 #include <set>
 #include <MassMatrix.h>
 #include <MeshContainer.h>
 #include <KelvinBaseTypes.h>
+#include <ActiveNodeSet.h>
+#include <NodeBlocks.h>
+#include <VelocityBoundaryCondition.h>
 #include <functional>
+#include <array>
 #include <map>
+#include <string>
 
 namespace Kelvin {
 
@@ -48,9 +54,16 @@ namespace Kelvin {
 * stores the raw mesh (through the meshContainer), velocity, acceleration,
 * mass, stress, strain, gradients of these quantities, etc.
 *
-* Nodes are stored as Points, which have position, velocity, and
-* acceleration. Accessing these quantities should be done by pulling and
-* indexing the list of nodes through the nodes() operation.
+* The state of the nodes is stored in NodeBlocks, which only allocates
+* storage for the blocks of nodes near particles. The velocity and
+* acceleration of a massive node can be read with nodalVelocity() and
+* nodalAcceleration().
+*
+* Unless the grid is sparse, every node is also stored as a Point, which has
+* position, velocity, and acceleration, and the velocities and accelerations
+* of the massive nodes are copied to the Points after every update. These
+* can be read by pulling and indexing the list of nodes through the nodes()
+* operation.
 * @code
 * auto & nodes = grid.nodes();
 * auto & pos5 = nodes[4].pos;
@@ -58,20 +71,58 @@ namespace Kelvin {
 * auto & acc5 = nodes[4].acc;
 * ...
 * @endcode
+*
+* Sparse grids skip the Points, so that memory and the time spent on the
+* nodes follow the number of nodes near particles instead of the size of the
+* background mesh.
 */
 class Grid {
 
 protected:
 
 	/**
-	 * Nodal positions
+	 * Nodal positions, velocities and accelerations as Points. These are
+	 * not created for sparse grids.
 	 */
 	std::vector<Point> _nodes;
 
 	/**
-	 * The list of massive nodes
+	 * The number of nodes in the grid, which is zero until the grid is
+	 * assembled.
+	 */
+	int _numNodes = 0;
+
+	/**
+	 * True if the grid is sparse, false otherwise.
+	 */
+	bool _sparse;
+
+	/**
+	 * The mass, momentum, force, velocity and acceleration of the nodes,
+	 * stored only for blocks of nodes near particles. The blocks also count
+	 * the particle stencils that include each node. A node is in the massive
+	 * node set exactly when its count is non-zero, so the set can be updated
+	 * by delta when particles change elements.
+	 */
+	NodeBlocks _nodeBlocks;
+
+	/**
+	 * True if the nodal masses and momenta are from a transfer with the
+	 * present shapes, false otherwise. Cleared by updateShapeMatrix().
 	 */
-	std::set<int> _nodeSet;
+	bool _transferIsCurrent = false;
+
+	/**
+	 * This operation copies the velocities and accelerations of the massive
+	 * nodes to their Points, unless the grid is sparse.
+	 */
+	void syncNodes();
+
+	/**
+	 * The massive nodes. Per-node quantities such as the lumped masses and
+	 * the force vectors are stored in the order of its slots.
+	 */
+	ActiveNodeSet _nodeSet;
 
 	/**
 	 * The mesh container that holds the original finite element mesh.
@@ -79,14 +130,40 @@ protected:
 	MeshContainer & _meshContainer;
 
 	/**
-	 * The shape/mapping matrix
+	 * The particle stencils holding the node ids, shapes and gradients for
+	 * each particle, in the same order as the particle list.
 	 */
-	std::unique_ptr<mfem::SparseMatrix> _shapeMatrix;
+	std::vector<ParticleStencil> _stencils;
 
 	/**
-	 * A map representing a sparse matrix holding the shape function gradients.
+	 * The generation of the particle set that the stencils were computed
+	 * for, or -1 if they have not been computed.
 	 */
-	std::map<int,std::vector<Gradient>> _gradientMap;
+	long _stencilGeneration = -1;
+
+	/**
+	 * The particles that moved to a different element during the last shape
+	 * update. Kept between steps to avoid reallocating it.
+	 */
+	std::vector<int> _migratedParticles;
+
+	/**
+	 * True if the massive node set changed since the force vectors were last
+	 * set up, false otherwise.
+	 */
+	bool _nodeSetChanged = true;
+
+	/**
+	 * Scratch space for the element ids of the particles, used by
+	 * updateShapeMatrix() when the cached locations are out of date.
+	 */
+	std::vector<int> _elementIds;
+
+	/**
+	 * Scratch space for the reference coordinates of the particles, used
+	 * with _elementIds.
+	 */
+	std::vector<double> _referencePos;
 
 	/**
 	 * The mass matrix that shows the amount of mass shared between nodes due
@@ -95,11 +172,43 @@ protected:
 	std::unique_ptr<MassMatrix> _massMatrix;
 
 	/**
-	 * This private operation updates the state of the shape matrix and the
-	 * gradient shape matrix.
+	 * The lumped/diagonal mass matrix entries for the massive nodes, in the
+	 * same order as the massive node set.
 	 */
-	void updateShapeMatrix(
-			const std::vector<Kelvin::MaterialPoint> & particles);
+	std::vector<double> _lumpedMass;
+
+	/**
+	 * True if _lumpedMass was computed from the present stencils, false if
+	 * it must be recomputed. Cleared by updateShapeMatrix().
+	 */
+	bool _lumpedMassIsCurrent = false;
+
+	/**
+	 * This private operation updates the particle stencils, which hold the
+	 * shapes and the shape gradients, and the massive node set. The cached
+	 * particle locations are used if they are current.
+	 *
+	 * The update is incremental if the number of particles has not changed:
+	 * the weights and gradients are rewritten in place, and only particles
+	 * that moved to a different element change the massive node set. The
+	 * force vectors and the node list of the mass matrix are only rebuilt if
+	 * the massive node set actually changed.
+	 */
+	void updateShapeMatrix(const ParticleSet & particles);
+
+	/**
+	 * This operation adds a stencil to the node counts, inserting nodes into
+	 * the massive node set when they gain their first particle.
+	 * @param stencil the stencil
+	 */
+	void addToNodeCounts(const ParticleStencil & stencil);
+
+	/**
+	 * This operation removes a stencil from the node counts, erasing nodes
+	 * from the massive node set when they lose their last particle.
+	 * @param stencil the stencil
+	 */
+	void removeFromNodeCounts(const ParticleStencil & stencil);
 
 	/**
 	 * This operation sets the force vector node ids from the nodes set.
@@ -116,17 +225,150 @@ protected:
 	 */
     std::vector<ForceVector> _externalForces;
 
+	/**
+	 * This operation scatters the internal forces of the particles in
+	 * [begin,end) into a nodal force buffer. The dimension is a
+	 * template parameter so that the loops over components are unrolled.
+	 * @param particles the list of particles
+	 * @param begin the first particle to scatter
+	 * @param end one past the last particle to scatter
+	 * @param force the nodal force buffer, indexed like the node blocks
+	 */
+	template<int Dim>
+	void scatterInternalForces(const ParticleSet & particles,
+			const int & begin, const int & end, double * force) const;
+
+	/**
+	 * This operation computes the accelerations of the massive nodes from
+	 * their forces and masses. The dimension is a template parameter so that
+	 * the loops over components are unrolled.
+	 */
+	template<int Dim>
+	void computeNodalAccelerations();
+
+	/**
+	 * This operation computes the velocities of the massive nodes from their
+	 * momenta and masses.
+	 */
+	template<int Dim>
+	void computeNodalVelocitiesFromMomenta();
+
+	/**
+	 * This operation advances the velocities of the massive nodes by their
+	 * accelerations over a time step.
+	 * @param timeStep the time step
+	 */
+	template<int Dim>
+	void integrateNodalVelocities(const double & timeStep);
+
+	/**
+	 * This operation scatters the external forces of the particles in
+	 * [begin,end) into a nodal force buffer.
+	 * @param particles the list of particles
+	 * @param begin the first particle to scatter
+	 * @param end one past the last particle to scatter
+	 * @param force the nodal force buffer, indexed like the node blocks
+	 */
+	template<int Dim>
+	void scatterExternalForces(const ParticleSet & particles,
+			const int & begin, const int & end, double * force) const;
+
+	/**
+	 * This operation scatters the mass, momentum and total force of the
+	 * particles in [begin,end) into buffers laid out like the arrays of
+	 * _nodeBlocks. Each particle is read exactly once and its stencil is
+	 * walked once for all three quantities.
+	 * @param particles the list of particles
+	 * @param begin the first particle to scatter
+	 * @param end one past the last particle to scatter
+	 * @param mass the nodal mass buffer
+	 * @param momentum the nodal momentum buffer
+	 * @param force the nodal force buffer, which receives the sum of the
+	 * internal and external forces
+	 */
+	template<int Dim>
+	void scatterToGrid(const ParticleSet & particles, const int & begin,
+			const int & end, double * mass, double * momentum,
+			double * force) const;
+
+	/**
+	 * This operation runs a particle-to-grid scatter kernel over all of the
+	 * particles. With one thread the kernel writes directly into the output
+	 * buffers. With more, the particles are split into one fixed block per
+	 * thread, each block is scattered into its own private copy of the
+	 * buffers, and the copies are summed into the outputs in block order.
+	 * The result is race-free and does not depend on how the blocks were
+	 * scheduled, so it is the same on every run with the same thread count.
+	 * @param numParticles the number of particles
+	 * @param outputs the nodal output buffers, already cleared
+	 * @param sizes the number of entries in each output buffer
+	 * @param kernel a callable kernel(begin,end,outputs) that writes into the
+	 * buffers that it is given, in the same order as outputs
+	 */
+	template<int NumOutputs, typename Kernel>
+	void scatterParticles(const int & numParticles,
+			const std::array<double *,NumOutputs> & outputs,
+			const std::array<int,NumOutputs> & sizes, Kernel kernel);
+
+	/**
+	 * This operation scatters the masses, momenta and forces of the particles
+	 * to the grid with scatterToGrid() using the present stencils, and sets
+	 * the lumped masses of the massive nodes from the nodal masses.
+	 * @param particles the list of particles
+	 */
+	void accumulateNodalQuantities(const ParticleSet & particles);
+
+
+	/**
+	 * Private nodal buffers for each thread block used by scatterParticles().
+	 */
+	std::vector<double> _threadBuffers;
+
     /**
-     * This is a utility operation for computing vector matrix multiply. It
-     * does not do deep bounds checking because the bounds are presumably
-     * either checked or required to be equal in the client caller.
-     * @param vec the input vector
-     * @param matrix the input matrix
-     * @param vec*matrix
+     * A scratch buffer of nodal forces with dimension entries for every node
+     * in the node blocks, stored node-major in the order of
+     * NodeBlocks::index(). Particle-to-grid scatters accumulate into this buffer in a
+     * single pass over the particles before the results are copied into the
+     * sparse ForceVector lists.
      */
-    void computeVectorMatrixProduct(const std::vector<double> & vec,
-    		const std::vector<std::vector<double>> & matrix,
-    		std::vector<double> & resultVec);
+    std::vector<double> _nodalForceBuffer;
+
+    /**
+     * The velocity boundary conditions, ordered so that the most restrictive
+     * conditions are applied last and win at nodes shared by several sides.
+     */
+    std::vector<VelocityBoundaryCondition> _boundaryConditions;
+
+    /**
+     * This operation finds the grid nodes on a side of the boundary and the
+     * normals of the boundary at those nodes.
+     * @param side the side. This is either "side<n>" for the boundary
+     * elements of the mesh with attribute n, one of the planes of the
+     * bounding box of the grid - xMin, xMax, yMin, yMax, zMin or zMax - or
+     * "floor" for the plane at z = 0 in 3D or y = 0 in 2D.
+     * @param nodeIds the ids of the nodes on the side, in increasing order
+     * @param normals the outward normals at the nodes, node-major. The
+     * normals at nodes shared by boundary elements with different normals
+     * are averaged.
+     */
+    void findBoundaryNodes(const std::string & side,
+    		std::vector<int> & nodeIds, std::vector<double> & normals) const;
+
+    /**
+     * This operation finds the nodes of every boundary condition in a list.
+     * The nodes don't move, so this is only needed once the nodes are
+     * created.
+     * @param conditions the conditions
+     */
+    void setupBoundaryNodes(
+    		std::vector<VelocityBoundaryCondition> & conditions) const;
+
+    /**
+     * A particle set used to adapt lists of material points to the operations
+     * that work on particle sets. The material points are copied into it on
+     * every call that takes a list of them.
+     */
+    ParticleSet _particleAdapter;
 
 public:
 
@@ -134,8 +376,10 @@ public:
 	 * Constructor. Requires a mesh container as input to extract nodal and
 	 * gradient information.
 	 * @param meshContainer the finite element mesh used to create the grid
+	 * @param sparse true if the nodes should only be stored near particles
+	 * and not as Points, false otherwise
 	 */
-	Grid(MeshContainer & meshContainer);
+	Grid(MeshContainer & meshContainer, const bool & sparse = false);
 
 	/**
 	 * Destructor
@@ -154,6 +398,13 @@ public:
 	 * @param particles the particle list that represent a mass distributed
 	 * across the grid. Used to create shape and mass matrices.
 	 */
+	void assemble(const ParticleSet & particles);
+
+	/**
+	 * The same as assemble(const ParticleSet &), but for a list of material
+	 * points. The points are copied into a particle set owned by the grid.
+	 * @param particles the particle list
+	 */
 	void assemble(const std::vector<Kelvin::MaterialPoint> & particles);
 
 	/// Update kinematics, fields, etc.
@@ -164,6 +415,14 @@ public:
 	 * the mass matrix from the particle distribution.
 	 * @return the mass matrix
 	 */
+	MassMatrix & massMatrix(const ParticleSet & particles);
+
+	/**
+	 * The same as massMatrix(const ParticleSet &), but for a list of material
+	 * points.
+	 * @param particles the particle list
+	 * @return the mass matrix
+	 */
 	MassMatrix & massMatrix(
 			const std::vector<Kelvin::MaterialPoint> & particles);
 
@@ -175,15 +434,39 @@ public:
 	MassMatrix & massMatrix();
 
 	/**
-	 * This operation returns the gradients of the nodal shape functions for
-	 * the nodes that are near particles.
-	 * @return a map representing the matrix of gradients (technically a rank
-	 * 3 tensor). The map key represents the row id which is equal to the
-	 * particle id in the particles list provided to assemble(), and the value
-	 * set contains the Gradients and represents the columns assigned to that
-	 * row.
+	 * This operation returns the lumped mass matrix entries for the massive
+	 * nodes, in the same order as the massive node set. The entries are
+	 * cached and only recomputed after the shape matrix is updated, so
+	 * changes to particle masses between shape updates are not picked up.
+	 * @return the lumped masses
+	 */
+	const std::vector<double> & lumpedMass();
+
+	/**
+	 * This operation returns the particle stencils, which hold the ids,
+	 * shapes and shape gradients of the nodes near each particle.
+	 * @return the stencils. Entry i corresponds to particle i in the
+	 * particles list provided to assemble().
+	 */
+	const std::vector<ParticleStencil> & stencils() const;
+
+	/**
+	 * This operation returns true if the stencils were computed for a
+	 * particle set in its present order, so entry i of stencils() is the
+	 * stencil of particle i of the set.
+	 * @param particles the particle set
+	 * @return true if the stencils belong to the set, false otherwise
 	 */
-	const std::map<int,std::vector<Gradient>> & gradients() const;
+	bool hasStencilsFor(const ParticleSet & particles) const;
+
+	/**
+	 * This operation returns the number of particles that moved to a
+	 * different element during the last update of the shapes. Only these
+	 * particles can change the massive node set.
+	 * @return the number of particles that changed elements, or the number
+	 * of particles if the shapes were rebuilt from scratch
+	 */
+	int numMigratedParticles() const;
 
 	/**
 	 * This operation computes and returns the internal forces at the massive
@@ -192,6 +475,15 @@ public:
 	 * that passed to assemble().
 	 * @return the internal forces
 	 */
+	const std::vector<ForceVector> & internalForces(
+			const ParticleSet & particles);
+
+	/**
+	 * The same as internalForces(const ParticleSet &), but for a list of
+	 * material points.
+	 * @param particles the particle list
+	 * @return the internal forces
+	 */
 	const std::vector<ForceVector> & internalForces(
 			const std::vector<Kelvin::MaterialPoint> & particles);
 
@@ -201,17 +493,105 @@ public:
 	 * @param particles the list of particles. THis should be the same list as
 	 * that passed to assemble().
 	 */
+	const std::vector<ForceVector> & externalForces(
+			const ParticleSet & particles);
+
+	/**
+	 * The same as externalForces(const ParticleSet &), but for a list of
+	 * material points.
+	 * @param particles the particle list
+	 * @return the external forces
+	 */
 	const std::vector<ForceVector> & externalForces(
 			const std::vector<Kelvin::MaterialPoint> & particles);
 
 	/**
 	 * This operation returns the present kinematic information at the nodes
 	 * as Points with positions, velocities, and accelerations. This includes
-	 * the whole grid, not just the massive nodes.
+	 * the whole grid, not just the massive nodes, but only the massive nodes
+	 * are updated. It throws an exception if the grid is sparse.
 	 * @return the kinematic information of the nodes
 	 */
 	const std::vector<Point> & nodes() const;
 
+	/**
+	 * This operation transfers the particles to the grid. The shapes are
+	 * updated, and then each particle is read once and its mass, momentum and
+	 * total force are scattered to the nodes near it. The results are kept
+	 * with the other nodal quantities, see nodalMass(), nodalMomentum() and
+	 * nodalForce(), and the lumped masses are set from the nodal masses.
+	 * @param particles the present particle configuration on the grid
+	 */
+	void transferParticlesToGrid(const ParticleSet & particles);
+
+	/**
+	 * This operation returns the mass of a massive node from the last
+	 * transfer of the particles to the grid.
+	 * @param nodeId the id of the node, which must be in massiveNodeSet()
+	 * @return the mass
+	 */
+	double nodalMass(const int & nodeId) const {
+		return _nodeBlocks.mass(nodeId);
+	}
+
+	/**
+	 * This operation returns the momentum of a massive node from the last
+	 * transfer of the particles to the grid.
+	 * @param nodeId the id of the node, which must be in massiveNodeSet()
+	 * @return the dimension components of the momentum
+	 */
+	const double * nodalMomentum(const int & nodeId) const {
+		return _nodeBlocks.momentum(nodeId);
+	}
+
+	/**
+	 * This operation returns the total (internal plus external) force on a
+	 * massive node from the last transfer of the particles to the grid.
+	 * @param nodeId the id of the node, which must be in massiveNodeSet()
+	 * @return the dimension components of the force
+	 */
+	const double * nodalForce(const int & nodeId) const {
+		return _nodeBlocks.force(nodeId);
+	}
+
+	/**
+	 * This operation returns the velocity of a massive node.
+	 * @param nodeId the id of the node, which must be in massiveNodeSet()
+	 * @return the dimension components of the velocity
+	 */
+	const double * nodalVelocity(const int & nodeId) const {
+		return _nodeBlocks.velocity(nodeId);
+	}
+
+	/**
+	 * This operation returns the acceleration of a massive node.
+	 * @param nodeId the id of the node, which must be in massiveNodeSet()
+	 * @return the dimension components of the acceleration
+	 */
+	const double * nodalAcceleration(const int & nodeId) const {
+		return _nodeBlocks.acceleration(nodeId);
+	}
+
+	/**
+	 * This operation returns the block storage of the nodal quantities, for
+	 * kernels that read many nodes.
+	 * @return the node blocks
+	 */
+	const NodeBlocks & nodeBlocks() const;
+
+	/**
+	 * This operation returns true if the grid is sparse, in which case the
+	 * nodes are not stored as Points and nodes() can not be used.
+	 * @return true if the grid is sparse, false otherwise
+	 */
+	bool isSparse() const;
+
+	/**
+	 * This operation returns the number of nodes in the grid.
+	 * @return the number of nodes, or zero if the grid is not assembled
+	 */
+	int numNodes() const;
+
 	/**
 	 * This operation computes the acceleration at the nodes using the
 	 * internal and external forces, and the mass matrix. The result is stored
@@ -219,13 +599,24 @@ public:
 	 * use the time step since the acceleration is computed directly from the
 	 * equation of motion.
 	 *
-	 * Calling this operation forces an update of the nodal shape and gradient
-	 * matrices, and updates all force vector node ids.
+	 * Calling this operation transfers the particles to the grid with
+	 * transferParticlesToGrid(), which forces an update of the nodal shape
+	 * and gradient matrices. The momenta from the same transfer can be turned
+	 * into velocities with updateNodalVelocitiesFromMomenta().
 	 *
 	 * @param timeStep the amount of time that has passed between the present
 	 * and new values (which will be computed)
 	 * @param particles the present particle configuration on the grid
 	 */
+	void updateNodalAccelerations(const double & timeStep,
+			const ParticleSet & particles);
+
+	/**
+	 * The same as updateNodalAccelerations(const double &, const ParticleSet
+	 * &), but for a list of material points.
+	 * @param timeStep the time step
+	 * @param particles the particle list
+	 */
 	void updateNodalAccelerations(const double & timeStep,
 			const std::vector<Kelvin::MaterialPoint> & particles);
 
@@ -236,33 +627,93 @@ public:
 	 * updated. The mass matrix is not recomputed; the present mass matrix is
 	 * used.
 	 */
+	void updateNodalVelocitiesFromMomenta(const ParticleSet & particles);
+
+	/**
+	 * This operation updates the nodal velocities at the massive nodes from
+	 * the momenta and masses of the last transfer of the particles to the
+	 * grid, usually the one done by updateNodalAccelerations(). The particles
+	 * are not read again, so it must only be used if they have not changed
+	 * since that transfer.
+	 */
+	void updateNodalVelocitiesFromMomenta();
+
+	/**
+	 * The same as updateNodalVelocitiesFromMomenta(const ParticleSet &), but
+	 * for a list of material points.
+	 * @param particles the particle list
+	 */
 	void updateNodalVelocitiesFromMomenta(
 			const std::vector<Kelvin::MaterialPoint> & particles);
 
 	/**
-	 * This operation computes the acceleration at the nodes using the
-	 * internal and external forces, and the mass matrix. The result is stored
-	 * directly on the nodes() array. Only velocities at the massive nodes are
-	 * updated.
+	 * This operation advances the nodal velocities over a time step with the
+	 * present nodal accelerations. The result is stored directly on the
+	 * nodes() array. Only velocities at the massive nodes are updated.
 	 * @param timeStep the amount of time that has passed between the present
 	 * and new values (which will be computed)
-	 * @param particles the present particle configuration on the grid
 	 */
-	void updateNodalVelocities(const double & timeStep,
-			const std::vector<Kelvin::MaterialPoint> & particles);
+	void updateNodalVelocities(const double & timeStep);
 
 	/*
 	 * This operation returns the set of node ids representing the nodes on the
 	 * grid that have mass
-	 * @return the set of node ids
+	 * @return a read-only view of the node ids, which can be iterated in
+	 * increasing order like a std::set
 	 */
-	const std::set<int> & massiveNodeSet();
+	const ActiveNodeSet & massiveNodeSet() const;
 
 	/**
-	 * This operation applies the no slip boundary condition to the boundary at
-	 * the bottom of the grid.
+	 * This operation sets the velocity boundary conditions from a block of
+	 * properties, usually the mesh block of the input file. Every property
+	 * named for a side of the boundary is a condition. Sides are either
+	 * "side<n>" for the mesh boundary elements with attribute n or one of the
+	 * planes of the bounding box of the grid - xMin, xMax, yMin, yMax, zMin or
+	 * zMax. The value is "noSlip", "freeSlip" or "fixed" followed by one
+	 * velocity component per dimension. For example:
+	 *
+	 * side1 = noSlip
+	 * xMax = freeSlip
+	 * yMax = fixed 0.0 -1.0e-3
+	 *
+	 * Other properties are ignored. If no side is given, the nodes on the
+	 * plane at z = 0 in 3D or y = 0 in 2D are no slip nodes.
+	 *
+	 * The nodes on each side are found once, when the grid is assembled, so
+	 * applying the conditions only touches the boundary nodes.
+	 * @param properties the properties
 	 */
-	virtual void applyNoSlipBoundaryConditions();
+	void setBoundaryConditions(
+			const std::map<std::string,std::string> & properties);
+
+	/**
+	 * This operation returns the velocity boundary conditions.
+	 * @return the conditions, in the order they are applied
+	 */
+	const std::vector<VelocityBoundaryCondition> & boundaryConditions() const;
+
+	/**
+	 * This operation applies the velocity boundary conditions to the
+	 * velocities and accelerations of the boundary nodes.
+	 */
+	virtual void applyBoundaryConditions();
+
+	/**
+	 * This operation applies the velocity boundary conditions. It is the
+	 * same as applyBoundaryConditions(), which it calls, and is kept for
+	 * existing callers from when only the no slip floor was supported.
+	 */
+	void applyNoSlipBoundaryConditions();
+
+	/**
+	 * This operation fills the location cache of the particles - the id of
+	 * the element that contains each particle and its reference coordinates
+	 * in that element - if it is not already current. The cache is read by
+	 * the shape updates and by constitutive relationships, so each particle
+	 * is only located once per step. Particles are located in parallel.
+	 * @param particles the particles
+	 */
+	void locateParticles(ParticleSet & particles) const;
 
 	/**
 	 * This operation identifies and returns the element id of the point
@@ -270,6 +721,14 @@ public:
 	 */
 	int getElementId(const Kelvin::MaterialPoint & point) const;
 
+	/**
+	 * This operation identifies and returns the element id of the i-th
+	 * particle in the set or -1 if the element ID cannot be found.
+	 * @param particles the particle set
+	 * @param index the index of the particle in the set
+	 */
+	int getElementId(const ParticleSet & particles, const int & index) const;
+
 };
 
 } /* namespace Kelvin */
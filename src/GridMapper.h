@@ -33,6 +33,7 @@
 #define SRC_GRIDMAPPER_H_
 
 #include <Grid.h>
+#include <ParticleSet.h>
 
 namespace Kelvin {
 
@@ -57,7 +58,7 @@ public:
 	 * calculated
 	 */
 	virtual void updateParticleAccelerations(const Kelvin::Grid & grid,
-			std::vector<Kelvin::MaterialPoint> & particles) const = 0;
+			ParticleSet & particles) const = 0;
 
 	/**
 	 * This function maps the velocity on the grid nodes to particle
@@ -67,7 +68,7 @@ public:
 	 * calculated
 	 */
 	virtual void updateParticleVelocities(const Kelvin::Grid & grid,
-			std::vector<Kelvin::MaterialPoint> & particles) const = 0;
+			ParticleSet & particles) const = 0;
 
 	/**
 	 * This function maps the velocity on the grid nodes to particle
@@ -81,8 +82,66 @@ public:
 	 * dimensions
 	 */
 	virtual void updateParticleVelocities(const Kelvin::Grid & grid,
-			const std::vector<Kelvin::MaterialPoint> & particles,
+			const ParticleSet & particles,
+			std::vector<double> & velocities) const = 0;
+
+	/**
+	 * This function maps the acceleration and velocity on the grid nodes to
+	 * the particles in a single pass. The accelerations are updated in-place
+	 * and the velocities are stored out of place, as in
+	 * updateParticleVelocities(const Kelvin::Grid &, const ParticleSet &,
+	 * std::vector<double> &).
+	 * @param grid the grid where nodal accelerations and velocities are
+	 * stored
+	 * @param particles the material points
+	 * @param velocities a vector in which the velocities should be stored
+	 * with dimension entries per particle
+	 */
+	virtual void updateParticleKinematics(const Kelvin::Grid & grid,
+			ParticleSet & particles,
 			std::vector<double> & velocities) const = 0;
+
+	/**
+	 * The same as updateParticleKinematics(const Kelvin::Grid &,
+	 * ParticleSet &, std::vector<double> &), but the gradient of the
+	 * velocity is computed at the particles in the same pass too.
+	 * @param grid the grid where nodal accelerations and velocities are
+	 * stored
+	 * @param particles the material points
+	 * @param velocities a vector in which the velocities should be stored
+	 * with dimension entries per particle
+	 * @param velocityGradients a vector in which the velocity gradients
+	 * should be stored with dimension by dimension entries per particle in
+	 * row-major order, such that entry (j,k) is dv_j/dx_k
+	 */
+	virtual void updateParticleKinematics(const Kelvin::Grid & grid,
+			ParticleSet & particles, std::vector<double> & velocities,
+			std::vector<double> & velocityGradients) const = 0;
+
+	/**
+	 * The same as updateParticleAccelerations(const Kelvin::Grid &,
+	 * ParticleSet &), but for a list of material points. The points are
+	 * copied into a particle set and back.
+	 */
+	void updateParticleAccelerations(const Kelvin::Grid & grid,
+			std::vector<Kelvin::MaterialPoint> & particles) const;
+
+	/**
+	 * The same as updateParticleVelocities(const Kelvin::Grid &,
+	 * ParticleSet &), but for a list of material points. The points are
+	 * copied into a particle set and back.
+	 */
+	void updateParticleVelocities(const Kelvin::Grid & grid,
+			std::vector<Kelvin::MaterialPoint> & particles) const;
+
+	/**
+	 * The same as updateParticleVelocities(const Kelvin::Grid &,
+	 * const ParticleSet &, std::vector<double> &), but for a list of material
+	 * points. The points are copied into a particle set.
+	 */
+	void updateParticleVelocities(const Kelvin::Grid & grid,
+			const std::vector<Kelvin::MaterialPoint> & particles,
+			std::vector<double> & velocities) const;
 };
 
 } /* namespace Kelvin */
@@ -48,12 +48,12 @@ HydrostaticCR::~HydrostaticCR() {
 }
 
 void HydrostaticCR::updateStrainRate(const Kelvin::Grid & grid,
-		Kelvin::MaterialPoint & matPoints) {
+		ParticleSet & particles, const int & index) {
 
 }
 
 void HydrostaticCR::updateStress(const Kelvin::Grid & grid,
-		Kelvin::MaterialPoint & matPoints) {
+		ParticleSet & particles, const int & index) {
 
 }
 
@@ -41,21 +41,29 @@ public:
 	HydrostaticCR();
 	virtual ~HydrostaticCR();
 
+	// Pull in the adapters for single material points
+	using ConstitutiveRelationship::updateStrainRate;
+	using ConstitutiveRelationship::updateStress;
+
 	/**
 	 * This function computes the strain rate for a hydrostatic configuration.
 	 * @param grid the computational grid on which nodal quantities are defined.
-	 * @param the material point at which the strains should be updated.
+	 * @param particles the particle set that holds the material point
+	 * @param index the index of the material point at which the strains
+	 * should be updated.
 	 */
 	void updateStrainRate(const Kelvin::Grid & grid,
-			Kelvin::MaterialPoint & matPoints);
+			ParticleSet & particles, const int & index);
 
 	/**
 	 * This operation computes the hydrostatic stress.
 	 * @param grid the computational grid on which nodal quantities are defined.
-	 * @param the material point at which the strains should be updated.
+	 * @param particles the particle set that holds the material point
+	 * @param index the index of the material point at which the stress
+	 * should be updated.
 	 */
 	void updateStress(const Kelvin::Grid & grid,
-			Kelvin::MaterialPoint & matPoints);
+			ParticleSet & particles, const int & index);
 };
 
 } /* namespace Kelvin */
@@ -31,6 +31,11 @@
  -----------------------------------------------------------------------------*/
 #include <KelvinBaseTypes.h>
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace Kelvin {
 
@@ -59,4 +64,28 @@ void NodalValueVector::clear() {
 	fill(values.begin(),values.end(),0.0);
 }
 
+int maxThreads() {
+#ifdef _OPENMP
+	return omp_get_max_threads();
+#else
+	return 1;
+#endif
+}
+
+void setMaxThreads(const int & numThreads) {
+	if (numThreads < 1) {
+		throw "The number of threads must be greater than zero.";
+	}
+#ifdef _OPENMP
+	omp_set_num_threads(numThreads);
+#endif
+}
+
+bool isLittleEndian() {
+	const uint32_t one = 1;
+	unsigned char firstByte;
+	memcpy(&firstByte, &one, 1);
+	return firstByte == 1;
+}
+
 } /* namespace Kelvin */
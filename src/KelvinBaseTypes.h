@@ -33,9 +33,67 @@
 #define SRC_KELVINBASETYPES_H_
 
 #include <vector>
+#include <cstdlib>
+#include <cstddef>
+#include <new>
+#include <algorithm>
 
 namespace Kelvin {
 
+/**
+ * This is a minimal standard allocator that aligns its allocations on cache
+ * line boundaries. It is used for the contiguous particle and node arrays so
+ * that the start of every array can be loaded with aligned vector
+ * instructions and two arrays never share a cache line.
+ */
+template<typename T, std::size_t Alignment = 64>
+class AlignedAllocator {
+public:
+
+	using value_type = T;
+
+	template<typename U>
+	struct rebind {
+		using other = AlignedAllocator<U,Alignment>;
+	};
+
+	AlignedAllocator() = default;
+
+	template<typename U>
+	AlignedAllocator(const AlignedAllocator<U,Alignment> &) {};
+
+	T * allocate(std::size_t n) {
+		void * ptr = NULL;
+		if (posix_memalign(&ptr,Alignment,n*sizeof(T)) != 0) {
+			throw std::bad_alloc();
+		}
+		return static_cast<T *>(ptr);
+	}
+
+	void deallocate(T * ptr, std::size_t) {
+		free(ptr);
+	}
+
+};
+
+template<typename T, typename U, std::size_t Alignment>
+bool operator==(const AlignedAllocator<T,Alignment> &,
+		const AlignedAllocator<U,Alignment> &) {
+	return true;
+}
+
+template<typename T, typename U, std::size_t Alignment>
+bool operator!=(const AlignedAllocator<T,Alignment> &,
+		const AlignedAllocator<U,Alignment> &) {
+	return false;
+}
+
+/**
+ * A std::vector with cache line aligned storage.
+ */
+template<typename T>
+using AlignedVector = std::vector<T,AlignedAllocator<T>>;
+
 /**
  * This class represents a basic NodalValueVector. Its dimension is set on
  * creation, with a default value of n=3. NodalValueVectors should be used in
@@ -115,6 +173,136 @@ using Gradient = NodalValueVector;
  */
 using ForceVector = NodalValueVector;
 
+/**
+ * This class represents the stencil of a particle on the background grid:
+ * the ids of the nodes of the element that contains the particle, and the
+ * values and gradients of the nodal shape functions of those nodes evaluated
+ * at the particle's position.
+ *
+ * The values are stored in fixed-size arrays large enough for a linear
+ * hexahedral element, so a list of stencils is one contiguous block of memory
+ * that can be refilled every step without allocating. Only the first
+ * numNodes entries of each array are valid. Gradients are stored with three
+ * components regardless of the dimension, and only the first dim components
+ * are valid.
+ *
+ * This is a basic data class, so access to member variables is unrestricted.
+ */
+class ParticleStencil {
+public:
+
+	/**
+	 * The maximum number of nodes in a stencil, which is the number of nodes
+	 * in a linear hexahedron.
+	 */
+	static const int maxNodes = 8;
+
+	/**
+	 * The maximum number of gradient components.
+	 */
+	static const int maxDim = 3;
+
+	/**
+	 * The id of the element that contains the particle or -1 if the particle
+	 * is not in the mesh.
+	 */
+	int elementId = -1;
+
+	/**
+	 * The number of nodes in the stencil. Zero if the particle is not in the
+	 * mesh.
+	 */
+	int numNodes = 0;
+
+	/**
+	 * The node ids
+	 */
+	int nodeIds[maxNodes];
+
+	/**
+	 * The values of the nodal shape functions at the particle, N_i(x_p)
+	 */
+	double weights[maxNodes];
+
+	/**
+	 * The gradients of the nodal shape functions at the particle,
+	 * dN_i(x_p)/dx_j = gradients[i][j]
+	 */
+	double gradients[maxNodes][maxDim];
+
+};
+
+/**
+ * This function returns the number of threads that Kelvin's parallel loops
+ * will use. It is always 1 if Kelvin was built without OpenMP.
+ * @return the maximum number of threads
+ */
+int maxThreads();
+
+/**
+ * This function sets the number of threads that Kelvin's parallel loops will
+ * use. It does nothing if Kelvin was built without OpenMP.
+ * @param numThreads the number of threads, which must be greater than zero
+ */
+void setMaxThreads(const int & numThreads);
+
+/**
+ * This function returns true if the host stores values little-endian, which
+ * is the byte order of Kelvin's binary files.
+ * @return true on little-endian hosts, false otherwise
+ */
+bool isLittleEndian();
+
+/**
+ * This function converts an array of values between the host byte order and
+ * little-endian in place. It does nothing on little-endian hosts.
+ * @param values the values
+ * @param size the number of values
+ */
+template<typename T>
+void swapToLittleEndian(T * values, const std::size_t & size) {
+	if (!isLittleEndian()) {
+		char * bytes = reinterpret_cast<char *>(values);
+		for (std::size_t i = 0; i < size; i++) {
+			std::reverse(bytes + i*sizeof(T), bytes + (i+1)*sizeof(T));
+		}
+	}
+}
+
+/**
+ * This function writes an array of values to a binary stream in
+ * little-endian byte order.
+ * @param stream the output stream
+ * @param values the values
+ * @param size the number of values
+ */
+template<typename T, typename Stream>
+void writeLittleEndian(Stream & stream, const T * values,
+		const std::size_t & size) {
+	if (isLittleEndian()) {
+		stream.write(reinterpret_cast<const char *>(values), size*sizeof(T));
+	} else {
+		for (std::size_t i = 0; i < size; i++) {
+			T value = values[i];
+			swapToLittleEndian(&value, 1);
+			stream.write(reinterpret_cast<const char *>(&value), sizeof(T));
+		}
+	}
+}
+
+/**
+ * This function reads an array of little-endian values from a binary
+ * stream.
+ * @param stream the input stream
+ * @param values the values
+ * @param size the number of values
+ */
+template<typename T, typename Stream>
+void readLittleEndian(Stream & stream, T * values, const std::size_t & size) {
+	stream.read(reinterpret_cast<char *>(values), size*sizeof(T));
+	swapToLittleEndian(values, size);
+}
+
 } /* namespace Kelvin */
 
 #endif /* SRC_KELVINBASETYPES_H_ */
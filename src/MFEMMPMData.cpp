@@ -32,11 +32,11 @@
 #include <MFEMMPMData.h>
 #include <memory>
 #include <vector>
-#include <DelimitedTextParser.h>
+#include <ParticleFile.h>
+#include <StringCaster.h>
 #include <iostream>
 
 using namespace std;
-using namespace fire;
 
 namespace Kelvin {
 
@@ -55,41 +55,31 @@ void MFEMMPMData::load(const std::string & inputFile) {
 	// particle data
 	MFEMData::load(inputFile);
 
-	// Get the particles file
+	// Configure the data needed by the grid. Sparse grids only store the
+	// nodes near the particles.
+	auto & meshBlock = propertyParser.getPropertyBlock("mesh");
+	bool sparse = meshBlock.count("sparseGrid")
+			&& meshBlock.at("sparseGrid") == "true";
+	_grid = make_unique<Grid>(*mc,sparse);
+	// The velocity boundary conditions are set on the sides of the mesh
+	_grid->setBoundaryConditions(meshBlock);
+
+	// Load the particles straight into the particle set. The file is either
+	// binary or CSV with the first dim columns as the coordinates and the
+	// next as the material id.
 	auto & block = propertyParser.getPropertyBlock("particles");
 	auto & particlesFile = block.at("file");
-	// Load the particles
-	DelimitedTextParser<vector<vector<double>>,double> parser(",","#");
-	parser.setSource(particlesFile);
-	parser.parse();
-	shared_ptr<vector<vector<double>>> data = parser.getData();
+	ParticleFile::read(particlesFile,_grid->dimension(),_particles);
+	int numParticles = _particles.size();
 
-	cout << "Loaded " << data->size() << " particles from "
+	cout << "Loaded " << numParticles << " particles from "
 			<< particlesFile << endl;
 
-	// Configure the data needed by the grid
-	_grid = make_unique<Grid>(*mc);
-
 	// Compute and set the particle mass
 	double totalMass = fire::StringCaster<double>::cast(block.at("totalMass"));
-	double particleMass = totalMass/data->size();
-	// Load the first dim columns of the data file to convert to material
-	// points and pack the particles vector
-	int numCoords = _grid->dimension();
-	for (int i = 0; i < data->size(); i++) {
-		auto & rawData = data->at(i);
-		MaterialPoint point(numCoords);
-		// Set the position
-		for (int j = 0; j < numCoords; j++) {
-			point.pos[j] = rawData[j];
-		}
-		// Set the material type, which is the numCoords entry from the file
-		// since the arrays are zero indexed.
-		point.materialId = rawData[numCoords];
-		// Set the mass
-		point.mass = particleMass;
-		// Push the particle into the list
-		_particles.push_back(point);
+	double particleMass = totalMass/numParticles;
+	for (int i = 0; i < numParticles; i++) {
+		_particles.mass(i) = particleMass;
 	}
 
 	return;
@@ -100,7 +90,7 @@ Grid & MFEMMPMData::grid() {
 	return *_grid;
 }
 
-std::vector<MaterialPoint> & MFEMMPMData::particles() {
+ParticleSet & MFEMMPMData::particles() {
 	if (!loaded) throw "Data not loaded!";
 	return _particles;
 }
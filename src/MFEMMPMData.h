@@ -36,6 +36,7 @@
 #include <vector>
 #include <memory>
 #include <Grid.h>
+#include <ParticleSet.h>
 
 namespace Kelvin {
 
@@ -62,10 +63,10 @@ private:
 	std::unique_ptr<Grid> _grid;
 
 	/**
-	 * This vector contains the point particles read from input and associated
+	 * This set contains the point particles read from input and associated
 	 * with the mesh stored in the mesh container of this Data instance.
 	 */
-	std::vector<MaterialPoint> _particles;
+	ParticleSet _particles;
 
 public:
 	/**
@@ -83,7 +84,7 @@ public:
 	 * material points.
 	 * @return the set of Lagrangian Material Points.
 	 */
-	std::vector<MaterialPoint> & particles();
+	ParticleSet & particles();
 
 	/**
 	 * This operation returns the computational grid that defines the Eulerian
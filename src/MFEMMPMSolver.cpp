@@ -35,6 +35,10 @@
 #include <MassMatrix.h>
 #include <BasicMFEMGridMapper.h>
 #include <ConstitutiveRelationshipService.h>
+#include <ParticleSorter.h>
+#include <ParticleWriter.h>
+#include <Checkpoint.h>
+#include <Profiler.h>
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -56,47 +60,118 @@ MFEMMPMSolver::~MFEMMPMSolver() {
 	// TODO Auto-generated destructor stub
 }
 
-static void writeParticlePositions(MFEMMPMData & data,
-		double ts) {
-
-	string outputFSName = "kelvin_output_";
-	outputFSName += to_string(ts);
-	outputFSName += ".csv";
-	ofstream outputFS(outputFSName);
-	int dim = data.grid().dimension();
-	outputFS << fixed;
-	outputFS.precision(15);
+void MFEMMPMSolver::solve(MFEMMPMData & data) {
 
-	auto & particles = data.particles();
-	int numParticles = particles.size();
-	for (int i = 0; i < numParticles; i++) {
-		auto & mPoint = particles[i];
-		for (int j = 0; j < dim; j++) {
-			outputFS << mPoint.pos[j] << ", ";
-		}
-		outputFS << ts << endl;
+	// Dispatch on the dimension of the mesh, which is fixed once the data is
+	// loaded, so that the particle updates have fixed lengths.
+	switch (data.meshContainer().dimension()) {
+	case 2:
+		integrate<2>(data);
+		break;
+	case 3:
+		integrate<3>(data);
+		break;
+	default:
+		throw "Unsupported mesh dimension. Only 2D and 3D meshes are supported.";
 	}
 
-	outputFS.close();
+	return;
 }
 
-
-void MFEMMPMSolver::solve(MFEMMPMData & data) {
+template<int Dim>
+void MFEMMPMSolver::integrate(MFEMMPMData & data) {
 
 	// Get the properties
 	auto & propertiesParser = data.properties();
 	auto & properties = propertiesParser.getPropertyBlock("solver");
 
-	// Assemble the grid
+	// Set the number of threads if it was specified. Otherwise the OpenMP
+	// default, usually one per core or OMP_NUM_THREADS, is used.
+	if (properties.count("threads")) {
+		setMaxThreads(fire::StringCaster<int>::cast(properties.at("threads")));
+	}
+	cout << "Using " << maxThreads() << " thread(s)." << endl;
+
+	// Get the particle sorting frequency. Particles are always sorted before
+	// the first step. A frequency of zero turns off the later sorts.
+	int sortStepFrequency = 10;
+	if (properties.count("particleSortFrequency")) {
+		sortStepFrequency = fire::StringCaster<int>::cast(
+				properties.at("particleSortFrequency"));
+	}
+
+	// Get the output format. Snapshots are CSV unless binary is requested.
+	ParticleOutputFormat outputFormat = ParticleOutputFormat::CSV;
+	if (properties.count("outputFormat")) {
+		outputFormat = ParticleWriter::parseFormat(
+				properties.at("outputFormat"));
+	}
+	// Snapshots are written on a background thread
+	ParticleWriter writer(outputFormat);
+
+	// Get the checkpoint settings. Checkpoints are only written if a
+	// frequency is given, and on a background thread like the snapshots.
+	int checkpointStepFrequency = 0;
+	if (properties.count("checkpointStepFrequency")) {
+		checkpointStepFrequency = fire::StringCaster<int>::cast(
+				properties.at("checkpointStepFrequency"));
+	}
+	string checkpointFile = "kelvin_checkpoint.bin";
+	if (properties.count("checkpointFile")) {
+		checkpointFile = properties.at("checkpointFile");
+	}
+	CheckpointWriter checkpointer(checkpointFile);
+
+	// Resume from the last checkpoint if a restart was requested and there
+	// is one. The grid is rebuilt from the restored particles below.
 	auto & particles = data.particles();
+	bool restarted = false;
+	int firstStep = 0;
+	double restartTime = 0.0;
+	bool restart = properties.count("restart")
+			&& properties.at("restart") == "true";
+	if (restart && !Checkpoint::exists(checkpointFile)) {
+		cout << "A restart was requested, but there is no checkpoint at "
+				<< checkpointFile << ". Starting from the initial conditions."
+				<< endl;
+	} else if (restart) {
+		// Starting over would overwrite the checkpoint, so a bad one stops
+		// the run.
+		Checkpoint checkpoint;
+		try {
+			checkpoint.read(checkpointFile);
+		} catch (const char * error) {
+			cerr << "Unable to restart from the checkpoint at "
+					<< checkpointFile << ": " << error << endl;
+			throw;
+		}
+		if (checkpoint.particles.dimension() != Dim) {
+			throw "The checkpoint dimension does not match the mesh.";
+		}
+		particles = std::move(checkpoint.particles);
+		restarted = true;
+		firstStep = checkpoint.step + 1;
+		restartTime = checkpoint.time;
+		cout << "Restarting from " << checkpointFile << " after step "
+				<< checkpoint.step << ", t = " << restartTime << endl;
+	}
+
+	// Assemble the grid
 	auto & grid = data.grid();
+	// Store the particles of each material contiguously so that the
+	// constitutive relationships can update them in batches, and order each
+	// material along a space filling curve through the elements so that
+	// neighboring particles touch neighboring nodes.
+	ParticleSorter sorter(data.meshContainer());
+	grid.locateParticles(particles);
+	sorter.sort(grid, particles);
+	auto materialRanges = particles.materialRanges();
 	grid.assemble(particles);
 	// Setup a mapper for mapping from the grid to the material points
 	BasicMFEMGridMapper mapper(data.meshContainer().getMesh());
 	// Create a storage vector for velocities from the mapper
-	int dim = data.meshContainer().dimension();
 	int numParticles = particles.size();
-	std::vector<double> velUpdate(numParticles*dim);
+	std::vector<double> velUpdate(numParticles*Dim);
 
 	// Set basic start time parameters - FIXME! Will read from input
 	double tInit = fire::StringCaster<double>::cast(
@@ -105,14 +180,14 @@ void MFEMMPMSolver::solve(MFEMMPMData & data) {
 			properties.at("finalTime"));
 	double dt = fire::StringCaster<double>::cast(
 			properties.at("initialTimeStep"));
-	double t = tInit; // dtOverstep = tFinal % dt;
+	double t = restarted ? restartTime : tInit; // dtOverstep = tFinal % dt;
 	int numTimeSteps = (int) (tFinal/dt) + 1;
 	int printStepFrequency =  fire::StringCaster<int>::cast(
 			properties.at("outputStepFrequency"));
 
 	// Set the body forces on the particles
 	for (int i = 0; i < numParticles; i++) {
-		particles[i].bodyForce[dim-1] = -9.8;
+		particles.bodyForce(i)[Dim-1] = -9.8;
 	}
 
 	// FIXME! time stepping issues
@@ -121,50 +196,113 @@ void MFEMMPMSolver::solve(MFEMMPMData & data) {
 
 	// Integrate over time. At the moment this will not integrate correctly to
 	// tFinal. See time stepping issues above - just a placeholder for now.
-	for (int ts = 0; ts < numTimeSteps + 1; ts++) {
+	for (int ts = firstStep; ts < numTimeSteps + 1; ts++) {
+		KELVIN_PROFILE_SCOPE("step");
+		KELVIN_PROFILE_COUNT("steps",1);
 		t += dt;
-		// Compute the acceleration at the grid nodes
+		// Find the elements of the particles once for the whole step
+		grid.locateParticles(particles);
+		// Re-sort the particles as they move. The shapes are recomputed
+		// below, so nothing on the grid depends on the old order.
+		if (sortStepFrequency > 0 && ts > 0 && !(ts % sortStepFrequency)) {
+			KELVIN_PROFILE_SCOPE("sort");
+			if (sorter.sort(grid, particles)) {
+				KELVIN_PROFILE_COUNT("particleSorts",1);
+				materialRanges = particles.materialRanges();
+			}
+		}
+		// Transfer the particles to the grid and compute the acceleration at
+		// the grid nodes
 		grid.updateNodalAccelerations(dt, particles);
-		// Compute the initial velocity from the momenta
-		grid.updateNodalVelocitiesFromMomenta(particles);
+		// Compute the initial velocity from the momenta of the same transfer
+		grid.updateNodalVelocitiesFromMomenta();
 		// Apply boundary conditions
-		grid.applyNoSlipBoundaryConditions();
+		grid.applyBoundaryConditions();
 		// Compute the velocity update
-		grid.updateNodalVelocities(dt, particles);
+		grid.updateNodalVelocities(dt);
 
 		// Use mapping functions to compute the velocity and acceleration at
 		// the material points
-		mapper.updateParticleAccelerations(grid, particles);
-		mapper.updateParticleVelocities(grid, particles, velUpdate);
-
-		// Compute updates to the material point stresses and strains using the
-		// appropriate constitutive relationship. Update the positions and
-		// velocity using explicit integration. This is just a simple
-		// explicit Euler update.
-		for (int i = 0; i < numParticles; i++) {
-			auto & mPoint = particles[i];
-			// Get the constitutive equations
-			auto & conRel = ConstitutiveRelationshipService::get(
-					mPoint.materialId);
-			// Compute/update the stress at material points using the
-			// constitutive equation
-			conRel.updateStrainRate(grid, mPoint);
-			conRel.updateStress(grid, mPoint);
-			// Update the positions and velocities
-			for (int j = 0; j < dim; j++) {
-				mPoint.pos[j] += dt * velUpdate[i * dim + j];
-				mPoint.vel[j] += dt * mPoint.acc[j];
+		{
+			KELVIN_PROFILE_SCOPE("gridToParticle");
+			mapper.updateParticleKinematics(grid, particles, velUpdate);
+		}
+
+		{
+			KELVIN_PROFILE_SCOPE("constitutiveUpdate");
+			// Let the constitutive relationships snapshot the updated grid
+			// once instead of once per material point
+			ConstitutiveRelationshipService::beginStep(grid);
+
+			// Compute updates to the material point stresses and strains
+			// using the appropriate constitutive relationship for each
+			// material.
+			for (auto & range : materialRanges) {
+				// Get the constitutive equations
+				auto & conRel = ConstitutiveRelationshipService::get(
+						range.materialId);
+				// Compute/update the stress at material points using the
+				// constitutive equation
+				conRel.updateStrainRate(grid, particles, range.begin,
+						range.end);
+				conRel.updateStress(grid, particles, range.begin, range.end);
 			}
 		}
 
+		// Update the positions and velocity using explicit integration. This
+		// is just a simple explicit Euler update.
+		{
+			KELVIN_PROFILE_SCOPE("integration");
+			#pragma omp parallel for schedule(static)
+			for (int i = 0; i < numParticles; i++) {
+				// Update the positions and velocities
+				double * pos = particles.pos(i);
+				double * vel = particles.vel(i);
+				const double * acc = particles.acc(i);
+				for (int j = 0; j < Dim; j++) {
+					pos[j] += dt * velUpdate[i * Dim + j];
+					vel[j] += dt * acc[j];
+				}
+			}
+			// The particles moved, so they must be located again
+			particles.invalidateLocations();
+		}
+
 		// Print stepping information
 		if (!(ts % printStepFrequency)) {
+			KELVIN_PROFILE_SCOPE("output");
+			KELVIN_PROFILE_COUNT("snapshots",1);
 			cout << "dt = " << dt << ", ts = " << ts << ", t = "
 					<< (tInit + dt * ts) << endl;
-			writeParticlePositions(data, ts);
+			writer.write(particles, ts, tInit + dt * ts);
+		}
+
+		// Checkpoint the state at the end of the step
+		if (checkpointStepFrequency > 0
+				&& !((ts + 1) % checkpointStepFrequency)) {
+			KELVIN_PROFILE_SCOPE("checkpoint");
+			KELVIN_PROFILE_COUNT("checkpoints",1);
+			checkpointer.write(particles, ts, t);
 		}
 
 	}
+	// Wait for the last snapshot and checkpoint and report any errors from
+	// the writers
+	{
+		KELVIN_PROFILE_SCOPE("output");
+		writer.flush();
+		checkpointer.flush();
+	}
+
+	// Write the performance report if Kelvin was built with profiling
+	if (Profiler::enabled()) {
+		string profileFile = "kelvin_profile.json";
+		if (properties.count("profileFile")) {
+			profileFile = properties.at("profileFile");
+		}
+		Profiler::writeReport(profileFile);
+		cout << "Wrote the performance report to " << profileFile << endl;
+	}
 
 	return;
 }
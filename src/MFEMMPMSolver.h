@@ -45,6 +45,16 @@ namespace Kelvin {
  * Mech. Engrg. 118 (1994) 179-196.
  */
 class MFEMMPMSolver: public Solver<MFEMMPMData> {
+protected:
+
+	/**
+	 * This operation integrates the particles over time. The dimension of the
+	 * mesh is a template parameter so that the particle updates are unrolled.
+	 * @param data the data for the simulation
+	 */
+	template<int Dim>
+	void integrate(MFEMMPMData & data);
+
 public:
 
 	/**
@@ -34,6 +34,7 @@
 #include <MeshContainer.h>
 #include <StringCaster.h>
 #include <cmath>
+#include <array>
 #include <iostream>
 
 using namespace mfem;
@@ -44,9 +45,8 @@ namespace Kelvin {
 MFEMOlevskyLVCR::MFEMOlevskyLVCR(MFEMData & data) : _data(data),
 		dim(data.meshContainer().dimension()), porosity(0.0),
 		shearModulus(0.0), phi(0.0), psi(0.0), density(1.0),
-		velCol(1,dim), velSpace(&(data.meshContainer().getMesh()),
-				&velCol,dim,Ordering::byVDIM),velGf(&velSpace)
-		{
+		sinteringStress(0.0), deviatoricScale(0.0), volumetricScale(0.0),
+		sinteringScale(0.0) {
 
 	// Get the properties
 	auto & propertiesParser = data.properties();
@@ -59,6 +59,12 @@ MFEMOlevskyLVCR::MFEMOlevskyLVCR(MFEMData & data) : _data(data),
 	// Compute phi and psi for the stress updates
 	phi = (1.0-porosity)*(1.0-porosity);
 	psi = (2.0/3.0)*phi*(1.0-porosity)/porosity;
+	// Compute the constant parts of the stress update once
+	sinteringStress = phi*(2.0*(1.0-porosity)-(1.0-porosity))/porosity;
+	double twoShearMod = 2.0*shearModulus;
+	deviatoricScale = twoShearMod*phi/density;
+	volumetricScale = twoShearMod*psi/density;
+	sinteringScale = sinteringStress/density;
 
 	return;
 }
@@ -68,91 +74,166 @@ MFEMOlevskyLVCR::~MFEMOlevskyLVCR() {
 }
 
 void MFEMOlevskyLVCR::updateStrainRate(const Kelvin::Grid & grid,
-		Kelvin::MaterialPoint & matPoint) {
+		ParticleSet & particles, const int & index) {
+
+	// Use the stencil from the grid if it was computed for these particles.
+	if (grid.hasStencilsFor(particles)) {
+		computeStrainRate(grid,&grid.stencils()[index],
+				particles.strain(index),1);
+		return;
+	}
 
-	// Create the H1 field
+	// Otherwise compute the stencil from the cached location of the particle
+	// if possible, or find the element that contains it.
 	auto & meshContainer = _data.meshContainer();
-	auto & _mesh = meshContainer.getMesh();
-
-	// Create and fill the grid function
-	auto & nodes = grid.nodes();
-	for (int i = 0; i < nodes.size(); i++) {
-		auto & nodeVel = nodes[i].vel;
-		for (int j = 0; j < dim; j++) {
-			velGf[i*dim+j] = nodeVel[j];
+	ParticleStencil stencil;
+	mfem::IntegrationPoint intPoint;
+	int id = 0;
+	if (particles.locationsAreCurrent()) {
+		id = particles.elementId(index);
+		intPoint.Set(particles.referencePos(index),dim);
+	} else {
+		id = meshContainer.locate(particles.pos(index),intPoint);
+	}
+	meshContainer.computeStencil(id,intPoint,stencil);
+	computeStrainRate(grid,&stencil,particles.strain(index),1);
+
+}
+
+void MFEMOlevskyLVCR::updateStrainRate(const Kelvin::Grid & grid,
+		ParticleSet & particles, const int & begin, const int & end) {
+
+	// The stencils and tensors of the range are contiguous, so the whole
+	// range is handled in one parallel call. Computing stencils from the mesh
+	// uses its scratch space, so that case is handled serially.
+	if (grid.hasStencilsFor(particles)) {
+		if (end > begin) {
+			computeStrainRate(grid,&grid.stencils()[begin],
+					particles.strain(begin),end-begin);
+		}
+	} else {
+		for (int i = begin; i < end; i++) {
+			updateStrainRate(grid,particles,i);
 		}
 	}
 
-    // Find the point quickly since the background mesh is known to be a cube.
-    int id = 0;
-    id = grid.getElementId(matPoint);
-    // Put the point in an mfem vector
-	mfem::Vector pointVec(dim);
-	for (int i = 0; i < dim; i++) {
-		pointVec[i] = matPoint.pos[i];
+}
+
+void MFEMOlevskyLVCR::computeStrainRate(const Kelvin::Grid & grid,
+		const ParticleStencil * stencils, double * strain,
+		const int & numPoints) const {
+
+	// Dispatch to the kernel for the dimension so that the tensors have fixed
+	// sizes.
+	switch (dim) {
+	case 2:
+		computeStrainRate<2>(grid,stencils,strain,numPoints);
+		break;
+	case 3:
+		computeStrainRate<3>(grid,stencils,strain,numPoints);
+		break;
+	default:
+		throw "Unsupported grid dimension. Only 2D and 3D grids are supported.";
 	}
 
-	// Get the element transformation
-	mfem::Array < mfem::IntegrationPoint > intPoints(1);
-	auto * elemTrans = _mesh.GetElementTransformation(id);
-	elemTrans->TransformBack(pointVec,intPoints[0]);
-	// Set the material point position in reference coordinates
-	elemTrans->SetIntPoint(&intPoints[0]);
-	// Get the gradient of the velocity at the material point
-	DenseMatrix gradVel(dim, dim);
-	velGf.GetVectorGradient(*elemTrans, gradVel);
-	// Compute the strain using infinitesimal strain theory by
-	// symmetrizing the matrix.
-	gradVel.Symmetrize();
-	// Map the matrix into the point
-	for (int j = 0; j < dim; j++) {
-		for (int k = 0; k < dim; k++) {
-			matPoint.strain[j][k] = gradVel(j, k);
+}
+
+template<int Dim>
+void MFEMOlevskyLVCR::computeStrainRate(const Kelvin::Grid & grid,
+		const ParticleStencil * stencils, double * strain,
+		const int & numPoints) const {
+
+	const int tensorSize = Dim*Dim;
+	auto & blocks = grid.nodeBlocks();
+	#pragma omp parallel for schedule(static)
+	for (int p = 0; p < numPoints; p++) {
+		auto & stencil = stencils[p];
+		double * pStrain = strain + p*tensorSize;
+		// Sum the velocity gradient over the nodes of the stencil. Nodes that
+		// are not stored on the grid have no mass and therefore no velocity.
+		double gradVel[Dim][Dim] = {};
+		for (int i = 0; i < stencil.numNodes; i++) {
+			int nodeId = stencil.nodeIds[i];
+			if (!blocks.contains(nodeId)) continue;
+			const double * nodeVel = blocks.velocity(nodeId);
+			const double * gradient = stencil.gradients[i];
+			for (int j = 0; j < Dim; j++) {
+				for (int k = 0; k < Dim; k++) {
+					gradVel[j][k] += nodeVel[j]*gradient[k];
+				}
+			}
+		}
+		// Compute the strain using infinitesimal strain theory by
+		// symmetrizing the matrix.
+		for (int j = 0; j < Dim; j++) {
+			for (int k = 0; k < Dim; k++) {
+				pStrain[j*Dim+k] = 0.5*(gradVel[j][k] + gradVel[k][j]);
+			}
 		}
 	}
 
 }
 
 void MFEMOlevskyLVCR::updateStress(const Kelvin::Grid & grid,
-		Kelvin::MaterialPoint & matPoint) {
+		ParticleSet & particles, const int & index) {
+	computeStress(particles.strain(index),particles.stress(index),1);
+}
 
-	int dim = grid.dimension();
-	double twoShearMod = 2.0*shearModulus;
-	double deviatoricStrainRate[dim][dim];
-	double sinteringStress[dim];
+void MFEMOlevskyLVCR::updateStress(const Kelvin::Grid & grid,
+		ParticleSet & particles, const int & begin, const int & end) {
+	// The tensors of the range are contiguous, so the whole range can be
+	// handled in one call.
+	if (end > begin) {
+		computeStress(particles.strain(begin),particles.stress(begin),
+				end-begin);
+	}
+}
 
-	// Compute the sintering stress, which is constant for now
-	for (int i = 0; i < dim; i++) {
-		sinteringStress[i] = phi*(2.0*(1.0-porosity)-(1.0-porosity))/porosity;
+void MFEMOlevskyLVCR::computeStress(const double * strain, double * stress,
+		const int & numPoints) const {
+
+	// Dispatch to the kernel for the dimension so that the tensors have fixed
+	// sizes.
+	switch (dim) {
+	case 2:
+		computeStress<2>(strain,stress,numPoints);
+		break;
+	case 3:
+		computeStress<3>(strain,stress,numPoints);
+		break;
+	default:
+		throw "Unsupported grid dimension. Only 2D and 3D grids are supported.";
 	}
 
-	double traceE = 0.0;
-	// Copy the initial strain rate into the deviatoric matrix
-	for (int i = 0; i < dim; i++) {
-		for (int j = 0; j < dim; j++) {
-			deviatoricStrainRate[i][j] = matPoint.strain[i][j];
+}
+
+template<int Dim>
+void MFEMOlevskyLVCR::computeStress(const double * strain, double * stress,
+		const int & numPoints) const {
+
+	const int tensorSize = Dim*Dim;
+	#pragma omp parallel for schedule(static)
+	for (int p = 0; p < numPoints; p++) {
+		const double * pStrain = strain + p*tensorSize;
+		double * pStress = stress + p*tensorSize;
+		// Compute the trace of the strain rate
+		double traceE = 0.0;
+		for (int i = 0; i < Dim; i++) {
+			traceE += pStrain[i*Dim+i];
 		}
-	}
-	// Compute the trace of the strain rate
-	for (int i = 0; i < dim; i++) {
-		traceE += matPoint.strain[i][i];
-	}
-	// Compute the hydrostatic strain rate
-	double hydrostaticStrainRate = traceE / dim;
-	// Compute the deviatoric strain rate
-	for (int i = 0; i < dim; i++) {
-		deviatoricStrainRate[i][i] -= hydrostaticStrainRate;
-	}
-	// Compute the stress matrix
-	for (int i = 0; i < dim; i++) {
-		// "Initialize" the stress matrix with a scaled deviatoric matrix
-		for (int j = 0; j < dim; j++) {
-			matPoint.stress[i][j] = twoShearMod * phi
-					* deviatoricStrainRate[i][j] / density;
+		// Compute the hydrostatic strain rate
+		double hydrostaticStrainRate = traceE / Dim;
+		// The diagonal term is the same in every direction
+		double diagonal = volumetricScale*traceE + sinteringScale
+				- deviatoricScale*hydrostaticStrainRate;
+		// Compute the stress matrix from the scaled deviatoric strain rate
+		// and add in the diagonal components
+		for (int i = 0; i < Dim; i++) {
+			for (int j = 0; j < Dim; j++) {
+				pStress[i*Dim+j] = deviatoricScale*pStrain[i*Dim+j];
+			}
+			pStress[i*Dim+i] += diagonal;
 		}
-		// Add in the diagonal components
-		matPoint.stress[i][i] +=
-				(twoShearMod * psi * traceE + sinteringStress[i]) / density;
 	}
 
 }
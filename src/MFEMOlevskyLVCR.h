@@ -77,20 +77,74 @@ class MFEMOlevskyLVCR : public ConstitutiveRelationship {
 	double density;
 
 	/**
-	 * Finite element collection used to compute the velocity for the strain
-	 * rate.
+	 * The sintering stress, which is constant and the same in every
+	 * direction for now.
 	 */
-	mfem::H1_FECollection velCol;
+	double sinteringStress;
 
 	/**
-	 * Finite element space used to compute the velocity for the strain rate.
+	 * 2*shearModulus*phi/density, the scale of the deviatoric strain rate in
+	 * the stress.
 	 */
-	mfem::FiniteElementSpace velSpace;
+	double deviatoricScale;
 
 	/**
-	 * Finite element grid function that compute the velocity.
+	 * 2*shearModulus*psi/density, the scale of the trace of the strain rate
+	 * in the stress.
 	 */
-	mfem::GridFunction velGf;
+	double volumetricScale;
+
+	/**
+	 * sinteringStress/density, the constant part of the diagonal stress.
+	 */
+	double sinteringScale;
+
+	/**
+	 * This operation computes the stress from the strain rate of a range of
+	 * material points that are stored contiguously. The dimension is a
+	 * template parameter so that the tensors have fixed sizes and the loops
+	 * are unrolled.
+	 * @param strain the strain rate tensors, Dim x Dim in row-major order
+	 * per point
+	 * @param stress the stress tensors that will be updated, Dim x Dim in
+	 * row-major order per point
+	 * @param numPoints the number of material points
+	 */
+	template<int Dim>
+	void computeStress(const double * strain, double * stress,
+			const int & numPoints) const;
+
+	/**
+	 * This operation computes the strain rate of a range of material points
+	 * from their stencils and the nodal velocities on the grid,
+	 * \grad v_jk = \sum_i v_ij dN_i/dx_k. The dimension is a template
+	 * parameter like it is for computeStress<Dim>(). Only the grid is read,
+	 * so the points are updated in parallel.
+	 * @param grid the computational grid
+	 * @param stencils the stencils of the material points
+	 * @param strain the strain rate tensors that will be updated, Dim x Dim
+	 * in row-major order per point
+	 * @param numPoints the number of material points
+	 */
+	template<int Dim>
+	void computeStrainRate(const Kelvin::Grid & grid,
+			const ParticleStencil * stencils, double * strain,
+			const int & numPoints) const;
+
+	/**
+	 * This operation dispatches to computeStress<Dim>() for the spatial
+	 * dimension.
+	 */
+	void computeStress(const double * strain, double * stress,
+			const int & numPoints) const;
+
+	/**
+	 * This operation dispatches to computeStrainRate<Dim>() for the spatial
+	 * dimension.
+	 */
+	void computeStrainRate(const Kelvin::Grid & grid,
+			const ParticleStencil * stencils, double * strain,
+			const int & numPoints) const;
 
 public:
 
@@ -104,24 +158,59 @@ public:
 	 */
 	virtual ~MFEMOlevskyLVCR();
 
+	// Pull in the adapters for single material points
+	using ConstitutiveRelationship::updateStrainRate;
+	using ConstitutiveRelationship::updateStress;
+
 	/**
 	 * This operation updates the strain rate at the material points using
-	 * infinitesimal strain theory, 1/2(\grad v + \grad v^T).
+	 * infinitesimal strain theory, 1/2(\grad v + \grad v^T). The stencil of
+	 * the point is taken from the grid if Grid::hasStencilsFor() the
+	 * particle set, and it is computed from the mesh otherwise.
 	 * @param grid the computational grid on which nodal quantities are defined.
-	 * @param the material point at which the strains should be updated.
+	 * @param particles the particle set that holds the material point
+	 * @param index the index of the material point at which the strains
+	 * should be updated.
 	 */
 	virtual void updateStrainRate(const Kelvin::Grid & grid,
-			Kelvin::MaterialPoint & matPoints);
+			ParticleSet & particles, const int & index);
+
+	/**
+	 * This operation updates the strain rate for a contiguous range of
+	 * material points. The points are updated in parallel if
+	 * Grid::hasStencilsFor() the particle set, since its stencils can then
+	 * be used directly. Otherwise the stencils are computed from the mesh, which uses
+	 * shared scratch space, so the points are updated serially.
+	 * @param grid the computational grid on which nodal quantities are defined.
+	 * @param particles the particle set that holds the material points
+	 * @param begin the index of the first material point in the range
+	 * @param end the index one past the last material point in the range
+	 */
+	virtual void updateStrainRate(const Kelvin::Grid & grid,
+			ParticleSet & particles, const int & begin, const int & end);
 
 	/**
 	 * This operation updates the stress at the material points using the
 	 * constitutive equation for linear viscous materials from Eugene Olevsky's
 	 * Continuum Theory of Sintering.
 	 * @param grid the computational grid on which nodal quantities are defined.
-	 * @param the material point at which the strains should be updated.
+	 * @param particles the particle set that holds the material point
+	 * @param index the index of the material point at which the stress
+	 * should be updated.
+	 */
+	virtual void updateStress(const Kelvin::Grid & grid,
+			ParticleSet & particles, const int & index);
+
+	/**
+	 * This operation updates the stress for a contiguous range of material
+	 * points with the material constants computed once for the whole range.
+	 * @param grid the computational grid on which nodal quantities are defined.
+	 * @param particles the particle set that holds the material points
+	 * @param begin the index of the first material point in the range
+	 * @param end the index one past the last material point in the range
 	 */
 	virtual void updateStress(const Kelvin::Grid & grid,
-			Kelvin::MaterialPoint & matPoints);
+			ParticleSet & particles, const int & begin, const int & end);
 };
 
 } /* namespace Kelvin */
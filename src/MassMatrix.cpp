@@ -37,21 +37,63 @@ using namespace std;
 
 namespace Kelvin {
 
-MassMatrix::MassMatrix(const std::vector<MaterialPoint> & particleList) :
-		nodes(nodesDummy),
-		particles(particleList), shapes(NULL) {
+MassMatrix::MassMatrix(const ParticleSet & particleSet) :
+		nodes(&ownedNodes),
+		particles(&particleSet), stencils(&ownedStencils) {
 	// TODO Auto-generated constructor stub
 
 }
 
+MassMatrix::MassMatrix(const std::vector<MaterialPoint> & particleList) :
+		nodes(&ownedNodes),
+		particles(&ownedParticles), stencils(&ownedStencils) {
+	ownedParticles.assign(particleList);
+}
+
 MassMatrix::~MassMatrix() {
 	// TODO Auto-generated destructor stub
 }
 
 void MassMatrix::assemble(mfem::SparseMatrix & shapeMatrix,
 		std::set<int> & nodeSet) {
-	shapes = &shapeMatrix;
-	nodes = nodeSet;
+
+	// Convert the rows of the shape matrix to stencils. Gradients are not
+	// needed for the mass.
+	int numPoints = shapeMatrix.Height();
+	const int * rowStart = shapeMatrix.GetI();
+	const int * nodeIds = shapeMatrix.GetJ();
+	const double * shapeValues = shapeMatrix.GetData();
+	ownedStencils.resize(numPoints);
+	for (int i = 0; i < numPoints; i++) {
+		auto & stencil = ownedStencils[i];
+		stencil.numNodes = rowStart[i+1] - rowStart[i];
+		if (stencil.numNodes > ParticleStencil::maxNodes) {
+			throw "Shape matrix row is too large for a particle stencil.";
+		}
+		for (int k = 0; k < stencil.numNodes; k++) {
+			stencil.nodeIds[k] = nodeIds[rowStart[i]+k];
+			stencil.weights[k] = shapeValues[rowStart[i]+k];
+		}
+	}
+
+	ownedNodes.assign(nodeSet);
+	assemble(*particles,ownedStencils,ownedNodes);
+}
+
+void MassMatrix::assemble(const ParticleSet & particleSet,
+		const std::vector<ParticleStencil> & particleStencils,
+		const ActiveNodeSet & nodeSet) {
+	particles = &particleSet;
+	stencils = &particleStencils;
+	nodes = &nodeSet;
+	// The consistent matrix depends on the shapes, so drop it.
+	consistentMatrix.reset();
+}
+
+void MassMatrix::updateShapes(const ParticleSet & particleSet) {
+	particles = &particleSet;
+	// The consistent matrix depends on the shapes, so drop it.
+	consistentMatrix.reset();
 }
 
 double MassMatrix::operator()(int i, int j) const {
@@ -60,24 +102,45 @@ double MassMatrix::operator()(int i, int j) const {
 	double m_ij = 0.0;
 	double particleMass = 0.0;
 
-	// Construct the mass matrix associated with the grid nodes
-
-	// FIXME! Set particle mass on Particle subclass of Point, next to coords.
-	Vector rowI;
-	Array<int> colsI;
+	// Read the entry from the assembled matrix if it is available. Nodes
+	// without mass have no entries.
+	if (consistentMatrix) {
+		int rowIndex = nodes->slot(i);
+		int colIndex = nodes->slot(j);
+		if (rowIndex >= 0 && colIndex >= 0) {
+			const int * rowStart = consistentMatrix->GetI();
+			const int * cols = consistentMatrix->GetJ();
+			const double * values = consistentMatrix->GetData();
+			for (int k = rowStart[rowIndex]; k < rowStart[rowIndex+1]; k++) {
+				if (cols[k] == colIndex) {
+					m_ij = values[k];
+					break;
+				}
+			}
+		}
+		return m_ij;
+	}
 
-	// Get the i-th and j-th rows of the shape matrix for the p-th
-	// particle. The i-th row is technically transposed in the dot
-	// product that follows.
-	int numParticles = particles.size();
+	// Otherwise compute m_ij = \sum_p M_p S_pi S_pj by searching the stencil
+	// of every particle for nodes i and j.
+	int numParticles = particles->size();
 	for (int k = 0; k < numParticles; k++) {
-		auto & matPoint = particles[k];
-		particleMass = matPoint.mass;
-		shapes->GetRow(k, colsI, rowI);
-		int colI = colsI.Find(i);
-		int colJ = colsI.Find(j);
-		if (colI >= 0 && colJ >= 0) {
-			m_ij += particleMass * rowI[colI] * rowI[colJ];
+		auto & stencil = (*stencils)[k];
+		particleMass = particles->mass(k);
+		double shapeI = 0.0, shapeJ = 0.0;
+		bool foundI = false, foundJ = false;
+		for (int l = 0; l < stencil.numNodes; l++) {
+			if (stencil.nodeIds[l] == i) {
+				shapeI = stencil.weights[l];
+				foundI = true;
+			}
+			if (stencil.nodeIds[l] == j) {
+				shapeJ = stencil.weights[l];
+				foundJ = true;
+			}
+		}
+		if (foundI && foundJ) {
+			m_ij += particleMass * shapeI * shapeJ;
 		}
 	}
 
@@ -86,24 +149,104 @@ double MassMatrix::operator()(int i, int j) const {
 
 std::vector<double> MassMatrix::lump() {
 
-	int i = 0; // Row counter
-	set<int>::iterator outerIt;
-	set<int>::iterator innerIt;
-	std::vector<double> diagonal(nodes.size());
-
-	// Loop over all the non-zero rows and compute the mass
-	int numPoints = particles.size();
-	double dValue = 0.0;
-	double index = 0;
-	for (outerIt = nodes.begin(); outerIt != nodes.end(); outerIt++) {
-		const auto & constShapes = (*shapes);
+	std::vector<double> diagonal;
+	lump(diagonal);
+
+	return diagonal;
+}
+
+void MassMatrix::lump(std::vector<double> & diagonal) {
+
+	// Sum the mass weighted shapes down each column of the shape matrix by
+	// walking each particle's stencil once. The sums go straight into the
+	// slots of the massive nodes, so nothing is stored for the rest of the
+	// grid.
+	int numPoints = particles->size();
+	diagonal.assign(nodes->size(),0.0);
+	for (int i = 0; i < numPoints; i++) {
+		auto & stencil = (*stencils)[i];
+		double mass = particles->mass(i);
+		for (int k = 0; k < stencil.numNodes; k++) {
+			int slot = nodes->slot(stencil.nodeIds[k]);
+			if (slot >= 0) {
+				diagonal[slot] += mass * stencil.weights[k];
+			}
+		}
+	}
+
+	return;
+}
+
+const mfem::SparseMatrix & MassMatrix::assembleConsistentMatrix() {
+
+	// Only assemble the matrix once per set of shapes
+	if (!consistentMatrix) {
+		// Create the shape matrix from the stencils with its columns
+		// restricted to the massive nodes, which are numbered by their slots
+		// in the node set. The matrix takes ownership of the arrays.
+		int numMassiveNodes = nodes->size();
+		int numPoints = particles->size();
+		int * restrictedI = new int[numPoints+1];
+		restrictedI[0] = 0;
+		for (int i = 0; i < numPoints; i++) {
+			restrictedI[i+1] = restrictedI[i] + (*stencils)[i].numNodes;
+		}
+		int numNonZeros = restrictedI[numPoints];
+		int * restrictedJ = new int[numNonZeros];
+		double * restrictedData = new double[numNonZeros];
 		for (int i = 0; i < numPoints; i++) {
-			diagonal[index] += particles[i].mass * constShapes(i, *outerIt);
+			auto & stencil = (*stencils)[i];
+			for (int k = 0; k < stencil.numNodes; k++) {
+				restrictedJ[restrictedI[i]+k] = nodes->slot(stencil.nodeIds[k]);
+				restrictedData[restrictedI[i]+k] = stencil.weights[k];
+			}
 		}
-		index++;
+		SparseMatrix restrictedShapes(restrictedI,restrictedJ,restrictedData,
+				numPoints,numMassiveNodes);
+
+		// Create the diagonal matrix of particle masses
+		int * massI = new int[numPoints+1];
+		int * massJ = new int[numPoints];
+		double * massData = new double[numPoints];
+		for (int i = 0; i < numPoints; i++) {
+			massI[i] = i;
+			massJ[i] = i;
+			massData[i] = particles->mass(i);
+		}
+		massI[numPoints] = numPoints;
+		SparseMatrix particleMasses(massI,massJ,massData,numPoints,numPoints);
+
+		// M = S^T diag(m) S
+		consistentMatrix.reset(RAP(restrictedShapes,particleMasses,
+				restrictedShapes));
+		consistentMatrix->SortColumnIndices();
 	}
 
-	return diagonal;
+	return *consistentMatrix;
+}
+
+bool MassMatrix::solve(const mfem::Vector & b, mfem::Vector & x,
+		double relTol, int maxIter) {
+
+	auto & matrix = assembleConsistentMatrix();
+
+	// Configure a Jacobi preconditioned CG solver. The mass matrix is
+	// symmetric positive definite over the massive nodes.
+	DSmoother preconditioner(matrix);
+	CGSolver solver;
+	solver.SetPreconditioner(preconditioner);
+	solver.SetOperator(matrix);
+	solver.iterative_mode = false;
+	solver.SetRelTol(relTol);
+	solver.SetAbsTol(0.0);
+	solver.SetMaxIter(maxIter);
+	solver.SetPrintLevel(0);
+
+	// Solve the system
+	x.SetSize(b.Size());
+	solver.Mult(b,x);
+
+	return solver.GetConverged();
 }
 
 } /* namespace Kelvin */
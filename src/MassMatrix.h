@@ -36,7 +36,11 @@
 #include <vector>
 #include <set>
 #include <MaterialPoint.h>
+#include <ParticleSet.h>
+#include <KelvinBaseTypes.h>
+#include <ActiveNodeSet.h>
 #include <functional>
+#include <memory>
 
 namespace Kelvin {
 
@@ -58,47 +62,69 @@ namespace Kelvin {
  */
 class MassMatrix {
 
-private:
+protected:
 
 	/**
-	 * A private dummy to get around injecting references in the constructor.
+	 * The list of nodes with particles near by, i.e. - "massive nodes." This
+	 * points either to the node set of the client, such as the Grid, or to
+	 * ownedNodes if the mass matrix was assembled from a shape matrix.
 	 */
-	std::set<int> nodesDummy;
+	const ActiveNodeSet * nodes;
 
 	/**
-	 * A private dummy to get around injecting references in the constructor.
+	 * The massive nodes when the mass matrix is assembled from a shape matrix
+	 * and a std::set of nodes.
 	 */
-	mfem::SparseMatrix shapesDummy;
+	ActiveNodeSet ownedNodes;
 
-protected:
+	/**
+	 * The full set of particles that give rise to mass in the grid. This
+	 * points either to particles owned by the client, such as the Grid, or to
+	 * ownedParticles if the mass matrix was created from a list of material
+	 * points.
+	 */
+	const ParticleSet * particles;
 
 	/**
-	 * The list of nodes with particles near by, i.e. - "massive nodes."
+	 * A copy of the material points when the mass matrix is created from a
+	 * list of them.
 	 */
-	std::set<int> & nodes;
+	ParticleSet ownedParticles;
 
 	/**
-	 * The full set of particles that give rise to mass in the grid.
+	 * The particle stencils that define the relationship between nodes and
+	 * particles. That is, the map of particles to grid nodes/cells. This
+	 * points either to stencils owned by the client, such as the Grid, or to
+	 * ownedStencils if the mass matrix was assembled from a shape matrix.
 	 */
-	const std::vector<MaterialPoint> & particles;
+	const std::vector<ParticleStencil> * stencils;
 
 	/**
-	 * The shape matrix that defines the relationship between nodes and
-	 * particles. That is, the map of particles to grid nodes/cells.
-	 *
-	 * This is stored as a pointer because of a bug in MFEM that adversely
-	 * affects storing it as a reference. This will be fully investigated
-	 * in the future, but for now the pointer is fine. Note that this class
-	 * does not free the pointer.
+	 * Stencils created from a sparse shape matrix when the mass matrix is
+	 * assembled from one.
+	 */
+	std::vector<ParticleStencil> ownedStencils;
+
+	/**
+	 * The assembled consistent mass matrix over the massive nodes, or null if
+	 * it has not been assembled for the present shapes.
 	 */
-	mfem::SparseMatrix * shapes;
+	std::unique_ptr<mfem::SparseMatrix> consistentMatrix;
 
 public:
 
 	/**
 	 * Constructor. The mass matrix must have a reference to the master list of
 	 * particles for the system.
-	 * @param particlesList the particles in the system
+	 * @param particleSet the particles in the system
+	 */
+	MassMatrix(const ParticleSet & particleSet);
+
+	/**
+	 * Constructor. The particles are copied into a particle set owned by the
+	 * mass matrix, so changes to the list after construction are not seen by
+	 * the mass matrix.
+	 * @param particleList the particles in the system
 	 */
 	MassMatrix(const std::vector<MaterialPoint> & particleList);
 
@@ -119,6 +145,29 @@ public:
 	void assemble(mfem::SparseMatrix & shapeMatrix,
 			std::set<int> & nodeSet);
 
+	/**
+	 * This operator assembles the mass matrix from the particles, their
+	 * stencils and the list of nodes that have mass in the background mesh.
+	 * None of them are copied, so they must outlive the mass matrix or be
+	 * reassembled when they change. The node set must be compacted.
+	 * @param particleSet the particles in the system
+	 * @param particleStencils the stencils with the shapes at the nodes
+	 * surrounding each particle, in the same order as the particles
+	 * @param nodeSet the list of nodes in the background mesh that actually have
+	 * mass
+	 */
+	void assemble(const ParticleSet & particleSet,
+			const std::vector<ParticleStencil> & particleStencils,
+			const ActiveNodeSet & nodeSet);
+
+	/**
+	 * This operation updates the mass matrix after the weights of the
+	 * stencils that it was assembled with were rewritten in place, but the
+	 * nodes that have mass did not change.
+	 * @param particleSet the particles in the system
+	 */
+	void updateShapes(const ParticleSet & particleSet);
+
 	/**
 	 * This operator computes the element in the matrix at the i-th row and the
 	 * j-th column. This represents the mass shared between the i-th and j-th
@@ -129,7 +178,9 @@ public:
 	 * m_ij = 0.0.
 	 *
 	 * This method will indiscriminately compute m_ij, even if i and j are not
-	 * in the node set, and does not exploit the sparse nature of the matrix.
+	 * in the node set, and does not exploit the sparse nature of the matrix
+	 * unless the consistent matrix was assembled with
+	 * assembleConsistentMatrix(), in which case the entry is read from it.
 	 *
 	 * @param i row number
 	 * @param j column number
@@ -142,13 +193,56 @@ public:
 	 * This operation creates a diagonalized form of the mass matrix by summing
 	 * across the rows of the original mass matrix, which is called
 	 * "mass lumping."
+	 *
+	 * Since the shape functions form a partition of unity, the row sum
+	 * \sum_j m_ij reduces to the column sum of the mass weighted shape matrix,
+	 * \sum_p M_p S_pi, which is computed in a single pass over the particle
+	 * stencils.
 	 * @return the non-zero diagonal/lumped mass matrix entries, one for
 	 * entry in the massive node set. The result is moved using C++11 move
-	 * semantics. (It would be nice to have a by-input-reference version for
-	 * high performance concerns about repeated allocations, etc.)
+	 * semantics.
 	 */
 	std::vector<double> lump();
 
+	/**
+	 * This operation is the same as lump(), but it writes the diagonal into a
+	 * vector provided by the caller to avoid repeated allocations.
+	 * @param diagonal the vector that will be resized to the size of the
+	 * massive node set and filled with the lumped mass matrix entries
+	 */
+	void lump(std::vector<double> & diagonal);
+
+	/**
+	 * This operation assembles the full consistent mass matrix,
+	 * M = S^T diag(m_p) S, as a sparse matrix using a single sparse triple
+	 * product of the shape matrix. The rows and columns of the matrix are
+	 * the massive nodes in the same order as the node set (and lump()), so
+	 * the matrix is not singular due to nodes that have no mass.
+	 *
+	 * The matrix is stored until the next call to assemble().
+	 * @return the consistent mass matrix
+	 */
+	const mfem::SparseMatrix & assembleConsistentMatrix();
+
+	/**
+	 * This operation solves M x = b with the consistent mass matrix using
+	 * a Jacobi preconditioned conjugate gradient solver. The matrix is
+	 * assembled if it has not been already. Vector valued nodal quantities
+	 * should be solved one component at a time.
+	 *
+	 * Note that the consistent mass matrix is only positive semi-definite
+	 * when elements contain fewer particles than nodes, in which case b must
+	 * be in the range of M for the solve to converge.
+	 * @param b the right hand side with one entry per massive node, in the
+	 * same order as the node set
+	 * @param x the solution, which will be resized to match b
+	 * @param relTol the relative tolerance of the solver
+	 * @param maxIter the maximum number of solver iterations
+	 * @return true if the solver converged, false otherwise
+	 */
+	bool solve(const mfem::Vector & b, mfem::Vector & x,
+			double relTol = 1.0e-12, int maxIter = 1000);
+
 };
 
 } /* namespace Kelvin */
@@ -47,12 +47,17 @@ MeshContainer::MeshContainer(
 			   _order(StringCaster<int>::cast(meshProps.at("order"))),
 			    dim(mesh.Dimension()), _name(meshProps.at("name")),
 				feCollection(spaceFactory.getCollection(_order,dim)),
-				space(spaceFactory.getFESpace(mesh,feCollection)) {
+				space(spaceFactory.getFESpace(mesh,feCollection)),
+				locator(mesh), cartesianMesh(mesh,feCollection) {
 
 	// Helpful diagnostic information.
 	cout << "Loaded mesh " << meshFilename << ". Mesh dimension = " << dim
 			<< " with " << mesh.GetNE() << " elements and " << mesh.GetNV()
 			<< " vertices." << endl;
+	if (cartesianMesh.isCartesian()) {
+		cout << "Mesh is a Cartesian grid. Using closed form shape functions."
+				<< endl;
+	}
 
 	setupHexMeshParams();
 }
@@ -62,7 +67,8 @@ MeshContainer::MeshContainer(const char * meshFile, const int & order,
 		meshFilename(meshFile), mesh(meshFile), _order(order),
 		dim(mesh.Dimension()), _name("mesh"),
 		feCollection(spaceFactory.getCollection(_order,dim)),
-		space(spaceFactory.getFESpace(mesh,feCollection)) {
+		space(spaceFactory.getFESpace(mesh,feCollection)),
+		locator(mesh), cartesianMesh(mesh,feCollection) {
 
 	setupHexMeshParams();
 }
@@ -236,23 +242,147 @@ std::vector<Gradient> MeshContainer::getNodalGradients(const std::vector<double>
     return gradients;
 }
 
+void MeshContainer::computeStencil(const std::vector<double> & point,
+		const int & elemId, ParticleStencil & stencil) {
+	computeStencil(point.data(),elemId,stencil);
+}
+
+void MeshContainer::computeStencil(const double * point,
+		const int & elemId, ParticleStencil & stencil) {
+
+	// Only transform the point if the element is real, otherwise leave the
+	// stencil empty
+	mfem::IntegrationPoint intPoint;
+	if (elemId > -1) {
+		// Pack the point
+		stencilPoint.SetSize(dim);
+		for (int i = 0; i < dim; i++) {
+			stencilPoint[i] = point[i];
+		}
+		// Get the reference coordinates
+		auto * elemTransform = mesh.GetElementTransformation(elemId);
+		elemTransform->TransformBack(stencilPoint,intPoint);
+	}
+	computeStencil(elemId,intPoint,stencil);
+
+	return;
+}
+
+void MeshContainer::computeStencil(const int & elemId,
+		const mfem::IntegrationPoint & intPoint, ParticleStencil & stencil) {
+
+	// Skip MFEM entirely on Cartesian grids
+	if (cartesianMesh.isCartesian()) {
+		cartesianMesh.computeStencil(elemId,intPoint,stencil);
+		return;
+	}
+
+	stencil.elementId = elemId;
+	stencil.numNodes = 0;
+
+	// Only proceed if the element is real, otherwise leave the stencil empty
+	if (elemId > -1) {
+		// Get the element transform, type and the finite element itself.
+		auto * elemTransform = mesh.GetElementTransformation(elemId);
+		elemTransform->SetIntPoint(&intPoint);
+		auto type = elemTransform->GetGeometryType();
+		auto * fElement = space.FEColl()->FiniteElementForGeometry(type);
+
+		// Compute the shapes and the physical gradients
+		int numDof = fElement->GetDof();
+		if (numDof > ParticleStencil::maxNodes) {
+			throw "Element has too many nodes for a particle stencil.";
+		}
+		stencilShapes.SetSize(numDof);
+		stencilGradients.SetSize(numDof,dim);
+		fElement->CalcShape(intPoint,stencilShapes);
+		fElement->CalcPhysDShape(*elemTransform,stencilGradients);
+
+		// Repack everything into the stencil, assuming numVerts = numDof
+		auto * vertexIds = mesh.GetElement(elemId)->GetVertices();
+		for (int i = 0; i < numDof; i++) {
+			stencil.nodeIds[i] = vertexIds[i];
+			stencil.weights[i] = stencilShapes[i];
+			for (int j = 0; j < dim; j++) {
+				stencil.gradients[i][j] = stencilGradients(i,j);
+			}
+		}
+		stencil.numNodes = numDof;
+	}
+
+	return;
+}
+
+void MeshContainer::computeStencils(const int & numPoints,
+		const int * elementIds, const double * referencePoints,
+		ParticleStencil * stencils) {
+
+	// MFEM's shape functions share scratch space, so only the closed form
+	// stencils are computed in parallel.
+	bool parallel = cartesianMesh.isCartesian();
+	#pragma omp parallel for schedule(static) if(parallel)
+	for (int i = 0; i < numPoints; i++) {
+		mfem::IntegrationPoint intPoint;
+		intPoint.Set(referencePoints + i*dim,dim);
+		computeStencil(elementIds[i],intPoint,stencils[i]);
+	}
+
+	return;
+}
+
 std::vector<Gradient> MeshContainer::getNodalGradients(const std::vector<double> & point) {
 	int elementId = getElementId(point);
 	return getNodalGradients(point,elementId);
 }
 
 int MeshContainer::getElementId(const std::vector<double> & point) {
+	return getElementId(point.data());
+}
 
-	// Find the element that contains the point
-	mfem::Array<int> elementId(1);
-	mfem::Array<mfem::IntegrationPoint> intPoint(1);
-	auto pointMatrix = convertPointToMatrix(point);
-    mesh.FindPoints(pointMatrix,elementId,intPoint);
+int MeshContainer::getElementId(const double * point) {
+	mfem::IntegrationPoint intPoint;
+	return locate(point,intPoint);
+}
 
-	return elementId[0];
+const ElementLocator & MeshContainer::getElementLocator() const {
+	return locator;
+}
+
+int MeshContainer::locate(const double * point,
+		mfem::IntegrationPoint & intPoint) const {
+	if (cartesianMesh.isCartesian()) {
+		return cartesianMesh.locate(point,intPoint);
+	}
+	return locator.locate(point,intPoint);
+}
+
+void MeshContainer::locate(const int & numPoints, const double * points,
+		int * elementIds, double * referencePoints) const {
+
+	// Every point writes its own entries, so no synchronization is needed
+	#pragma omp parallel for schedule(static)
+	for (int i = 0; i < numPoints; i++) {
+		mfem::IntegrationPoint intPoint{};
+		elementIds[i] = locate(points + i*dim,intPoint);
+		intPoint.Get(referencePoints + i*dim,dim);
+	}
+
+	return;
+}
+
+bool MeshContainer::isCartesian() const {
+	return cartesianMesh.isCartesian();
+}
+
+const CartesianMesh & MeshContainer::getCartesianMesh() const {
+	return cartesianMesh;
 }
 
 int MeshContainer::getElementIdFromHexMesh(const std::vector<double> & point) {
+	return getElementIdFromHexMesh(point.data());
+}
+
+int MeshContainer::getElementIdFromHexMesh(const double * point) {
 
 	int id = -1;
 
@@ -39,6 +39,8 @@
 #include <vector>
 #include <Point.h>
 #include <KelvinBaseTypes.h>
+#include <ElementLocator.h>
+#include <CartesianMesh.h>
 
 namespace Kelvin {
 
@@ -109,6 +111,33 @@ private:
 	 */
 	int nodesPerSide = 0;
 
+	/**
+	 * Scratch space used by computeStencil() for the point in physical
+	 * coordinates so that stencils can be computed without allocating.
+	 */
+	mfem::Vector stencilPoint;
+
+	/**
+	 * Scratch space used by computeStencil() for the nodal shapes.
+	 */
+	mfem::Vector stencilShapes;
+
+	/**
+	 * Scratch space used by computeStencil() for the nodal gradients.
+	 */
+	mfem::DenseMatrix stencilGradients;
+
+	/**
+	 * The spatial index used to find the elements that contain points.
+	 */
+	ElementLocator locator;
+
+	/**
+	 * The closed form point location and shapes, which are only used if the
+	 * mesh is a Cartesian grid.
+	 */
+	CartesianMesh cartesianMesh;
+
 	/**
 	 * This operation computes parameters that are used if the underlying mesh
 	 * is hexahedral or quadrilateral.
@@ -259,22 +288,146 @@ public:
 	std::vector<Gradient> getNodalGradients(const std::vector<double> & point,
 			const int & elemId);
 
+	/**
+	 * This operation computes the full stencil of a point in an element in
+	 * place: the ids of the element's nodes and the values and gradients of
+	 * their shape functions at the point. The point is only transformed to
+	 * reference coordinates once, and no memory is allocated.
+	 *
+	 * Unlike getNodalGradients(), the gradients are computed with respect to
+	 * the physical coordinates, so they account for the size of the element.
+	 * @param point a vector containing the coordinates of the point
+	 * @param elemId the id of the element that contains the point
+	 * @param stencil the stencil that will be filled. If the element id is
+	 * invalid the stencil will have no nodes.
+	 */
+	void computeStencil(const std::vector<double> & point, const int & elemId,
+			ParticleStencil & stencil);
+
+	/**
+	 * The same as computeStencil(const std::vector<double> &, const int &,
+	 * ParticleStencil &), but for a point stored in a raw array with
+	 * dimension entries, such as a position in a ParticleSet.
+	 */
+	void computeStencil(const double * point, const int & elemId,
+			ParticleStencil & stencil);
+
+	/**
+	 * The same as computeStencil(const double *, const int &,
+	 * ParticleStencil &), but for a point that has already been transformed
+	 * into the reference space of the element, such as a cached particle
+	 * location, so no inverse transformation is needed.
+	 * @param elemId the id of the element that contains the point
+	 * @param intPoint the reference coordinates of the point in the element
+	 * @param stencil the stencil that will be filled. If the element id is
+	 * invalid the stencil will have no nodes.
+	 *
+	 * On a Cartesian mesh the stencil is computed in closed form without any
+	 * scratch space, so it is safe to call from multiple threads at once.
+	 */
+	void computeStencil(const int & elemId,
+			const mfem::IntegrationPoint & intPoint, ParticleStencil & stencil);
+
+	/**
+	 * This operation computes the stencils of many points at once from their
+	 * element ids and reference coordinates, such as the cached locations of
+	 * a ParticleSet, and writes them into a caller provided array. Nothing is
+	 * allocated, and the stencils are computed in parallel on Cartesian
+	 * meshes.
+	 * @param numPoints the number of points
+	 * @param elementIds the id of the element that contains each point, or
+	 * -1 for points that are not in the mesh
+	 * @param referencePoints the reference coordinates of each point, stored
+	 * point-major with dimension entries per point
+	 * @param stencils the array of numPoints stencils that will be filled
+	 */
+	void computeStencils(const int & numPoints, const int * elementIds,
+			const double * referencePoints, ParticleStencil * stencils);
+
 	/**
 	 * This operation finds the containing element id for the point for any
-	 * supported mesh type.
+	 * supported mesh type. It computes the element directly on Cartesian
+	 * grids and uses a spatial index over the elements otherwise, so the
+	 * mesh does not need to be uniform or aligned with the axes.
 	 * @param the point for which the element id should be determined
 	 * @return the id of the element or -1 if the point could not be found
 	 */
 	int getElementId(const std::vector<double> & point);
 
+	/**
+	 * The same as getElementId(const std::vector<double> &), but for a point
+	 * stored in a raw array with dimension entries. It is safe to call from
+	 * multiple threads at once.
+	 */
+	int getElementId(const double * point);
+
+	/**
+	 * This operation returns the spatial index used to find elements, which
+	 * also provides the reference coordinates of the points that it finds.
+	 * @return the element locator
+	 */
+	const ElementLocator & getElementLocator() const;
+
+	/**
+	 * This operation finds the element that contains a point and the
+	 * coordinates of the point in the reference space of that element. It
+	 * uses the closed form location if the mesh is a Cartesian grid and the
+	 * element locator otherwise. It is safe to call from multiple threads at
+	 * once.
+	 * @param point the point, with dimension entries
+	 * @param intPoint the reference coordinates of the point if it was found
+	 * @return the id of the element or -1 if the point is not in the mesh
+	 */
+	int locate(const double * point, mfem::IntegrationPoint & intPoint) const;
+
+	/**
+	 * This operation locates many points at once, such as all of the
+	 * particles in a ParticleSet, and writes their element ids and reference
+	 * coordinates into caller provided arrays. The points are located in
+	 * parallel and nothing is allocated.
+	 * @param numPoints the number of points
+	 * @param points the coordinates of the points, stored point-major with
+	 * dimension entries per point
+	 * @param elementIds the array of numPoints element ids that will be
+	 * filled. Points that are not in the mesh get -1.
+	 * @param referencePoints the array of numPoints*dimension reference
+	 * coordinates that will be filled, stored the same way as the points.
+	 * The entries of points that are not in the mesh are zero.
+	 */
+	void locate(const int & numPoints, const double * points, int * elementIds,
+			double * referencePoints) const;
+
+	/**
+	 * This operation returns true if the mesh is a structured, axis-aligned
+	 * grid of linear quadrilaterals or hexahedra, in which case points are
+	 * located and stencils are computed in closed form.
+	 * @return true if the mesh is Cartesian, false otherwise
+	 */
+	bool isCartesian() const;
+
+	/**
+	 * This operation returns the closed form operations for Cartesian grids.
+	 * They may only be used if isCartesian() is true.
+	 * @return the Cartesian mesh
+	 */
+	const CartesianMesh & getCartesianMesh() const;
+
 	/**
 	 * This operation finds the containing element id for the point assuming
-	 * that the background mesh is hexahedral (or quadrilateral in 2D).
+	 * that the background mesh is a uniform hexahedral (or quadrilateral in
+	 * 2D) grid with the same number of elements on each side and a corner at
+	 * the origin. getElementId() should be used for all other meshes.
 	 * @param point the point for which the element id should be determined.
 	 * 	 * @return the id of the element or -1 if the point could not be found
 	 */
 	int getElementIdFromHexMesh(const std::vector<double> & point);
 
+	/**
+	 * The same as getElementIdFromHexMesh(const std::vector<double> &), but
+	 * for a point stored in a raw array with dimension entries.
+	 */
+	int getElementIdFromHexMesh(const double * point);
+
 	/**
 	 * This operation returns the quadrature points in the mesh.
 	 * @return the quadrature points
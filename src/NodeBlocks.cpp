@@ -0,0 +1,163 @@
+/**----------------------------------------------------------------------------
+ Copyright  2018-, UT-Battelle, LLC
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ Author(s): Jay Jay Billings (billingsjj <at> ornl <dot> gov)
+ -----------------------------------------------------------------------------*/
+#include <NodeBlocks.h>
+#include <algorithm>
+
+namespace Kelvin {
+
+NodeBlocks::NodeBlocks(const int & numNodes, const int & dim,
+		const bool & sparse) {
+	resize(numNodes,dim,sparse);
+}
+
+void NodeBlocks::resize(const int & numNodes, const int & dim,
+		const bool & sparse) {
+	this->numNodes = numNodes;
+	this->dim = dim;
+	this->sparse = sparse;
+	latticeNodes = {{0,0,0}};
+	blockSlots.clear();
+	denseSlots.assign(sparse ? 0 : (numNodes + blockSize - 1) >> blockBits,-1);
+	activeNodes.clear();
+	freeSlots.clear();
+	numSlots = 0;
+	countData.clear();
+	massData.clear();
+	momentumData.clear();
+	forceData.clear();
+	velocityData.clear();
+	accelerationData.clear();
+}
+
+void NodeBlocks::setLattice(const std::array<int,3> & nodesPerDirection) {
+	resize(numNodes,dim,sparse);
+	latticeNodes = nodesPerDirection;
+	tileBits = (dim == 2) ? std::array<int,3>{{3,2,0}}
+			: std::array<int,3>{{2,2,1}};
+	for (int j = 0; j < 3; j++) {
+		int tileSize = 1 << tileBits[j];
+		numTiles[j] = (latticeNodes[j] + tileSize - 1) / tileSize;
+	}
+	// Partial tiles make more blocks than consecutive ids would
+	if (!sparse) {
+		denseSlots.assign(numTiles[0]*numTiles[1]*numTiles[2],-1);
+	}
+}
+
+int NodeBlocks::allocate(const int & block) {
+
+	int slot = 0;
+	if (!freeSlots.empty()) {
+		// Reuse the storage of a retired block
+		slot = freeSlots.back();
+		freeSlots.pop_back();
+		long begin = (long) slot*blockSize, end = begin + blockSize;
+		std::fill(countData.begin() + begin,countData.begin() + end,0);
+		std::fill(massData.begin() + begin,massData.begin() + end,0.0);
+		std::fill(momentumData.begin() + begin*dim,momentumData.begin() + end*dim,0.0);
+		std::fill(forceData.begin() + begin*dim,forceData.begin() + end*dim,0.0);
+		std::fill(velocityData.begin() + begin*dim,
+				velocityData.begin() + end*dim,0.0);
+		std::fill(accelerationData.begin() + begin*dim,
+				accelerationData.begin() + end*dim,0.0);
+	} else {
+		// Grow the storage by a block. The new entries are zero.
+		slot = numSlots++;
+		long size = (long) numSlots*blockSize;
+		activeNodes.push_back(0);
+		countData.resize(size,0);
+		massData.resize(size,0.0);
+		momentumData.resize(size*dim,0.0);
+		forceData.resize(size*dim,0.0);
+		velocityData.resize(size*dim,0.0);
+		accelerationData.resize(size*dim,0.0);
+	}
+	if (sparse) {
+		blockSlots.insert(block,slot);
+	} else {
+		denseSlots[block] = slot;
+	}
+
+	return slot;
+}
+
+bool NodeBlocks::activate(const int & nodeId) {
+	int block = 0, offset = 0;
+	split(nodeId,block,offset);
+	int slot = findSlot(block);
+	if (slot < 0) {
+		slot = allocate(block);
+	}
+	if (countData[(slot << blockBits) | offset]++ > 0) {
+		return false;
+	}
+	activeNodes[slot]++;
+	return true;
+}
+
+bool NodeBlocks::deactivate(const int & nodeId) {
+	int block = 0, offset = 0;
+	split(nodeId,block,offset);
+	int slot = findSlot(block);
+	if (--countData[(slot << blockBits) | offset] > 0) {
+		return false;
+	}
+	if (--activeNodes[slot] == 0) {
+		freeSlots.push_back(slot);
+		if (sparse) {
+			blockSlots.erase(block);
+		} else {
+			denseSlots[block] = -1;
+		}
+	}
+	return true;
+}
+
+int NodeBlocks::count(const int & nodeId) const {
+	return contains(nodeId) ? countData[index(nodeId)] : 0;
+}
+
+int NodeBlocks::numActiveBlocks() const {
+	return numSlots - freeSlots.size();
+}
+
+int NodeBlocks::capacity() const {
+	return numSlots*blockSize;
+}
+
+void NodeBlocks::clearTransfer() {
+	std::fill(massData.begin(),massData.end(),0.0);
+	std::fill(momentumData.begin(),momentumData.end(),0.0);
+	std::fill(forceData.begin(),forceData.end(),0.0);
+}
+
+} /* namespace Kelvin */
@@ -0,0 +1,499 @@
+/**----------------------------------------------------------------------------
+ Copyright  2018-, UT-Battelle, LLC
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ Author(s): Jay Jay Billings (billingsjj <at> ornl <dot> gov)
+ -----------------------------------------------------------------------------*/
+#ifndef SRC_NODEBLOCKS_H_
+#define SRC_NODEBLOCKS_H_
+
+#include <array>
+#include <vector>
+#include <BlockTable.h>
+
+namespace Kelvin {
+
+/**
+ * This class stores the state of the grid nodes - mass, momentum, force,
+ * velocity and acceleration - in fixed size blocks of nodes that are only
+ * allocated where there are particles, like SPGrid. By default a block holds
+ * consecutive node ids, which is all that is known about a general mesh. On
+ * a Cartesian mesh whose vertex ids run along the lattice, setLattice()
+ * makes each block a tile of the lattice instead, so the nodes of a
+ * particle stencil usually share a block. A block is
+ * activated when the first of its nodes gains mass and retired when the
+ * last of its nodes loses it, and the storage of retired blocks is reused.
+ * The number of particle stencils that include each node is kept in the
+ * blocks with the other nodal quantities.
+ *
+ * By default the storage slot of each block is kept in an array with one
+ * entry per grid block, so finding a node is a single load. Sparse blocks
+ * find the slots of the active blocks through a BlockTable instead, so
+ * nothing is stored per grid node or per grid block and memory follows the
+ * number of nodes near particles instead of the size of the grid, at the
+ * cost of a hash probe on every access.
+ *
+ * Each quantity is stored in its own array. The entries of a block are
+ * contiguous, node-major with dim entries for the vector quantities, and
+ * index() maps a node id to its entry so that the arrays can be used
+ * directly by scatters:
+ * @code
+ * double * velocity = &blocks.velocities()[blocks.index(nodeId)*dim];
+ * @endcode
+ *
+ * Nodes in an active block are always stored, even if they are not active
+ * themselves, so contains() only checks the block.
+ */
+class NodeBlocks {
+public:
+
+	/**
+	 * The number of bits of a node id that index a node within its block.
+	 */
+	static const int blockBits = 5;
+
+	/**
+	 * The number of nodes in a block.
+	 */
+	static const int blockSize = 1 << blockBits;
+
+protected:
+
+	/**
+	 * The dimension of the vector quantities.
+	 */
+	int dim = 3;
+
+	/**
+	 * The number of nodes in the grid.
+	 */
+	int numNodes = 0;
+
+	/**
+	 * True if the slots of the blocks are found through blockSlots, false if
+	 * they are found through denseSlots.
+	 */
+	bool sparse = false;
+
+	/**
+	 * The number of nodes in each direction of the vertex lattice if the
+	 * blocks are tiles of the lattice, or zero if they hold consecutive ids.
+	 */
+	std::array<int,3> latticeNodes{{0,0,0}};
+
+	/**
+	 * The number of bits of a lattice coordinate that index a node within
+	 * its tile in each direction. They add up to blockBits.
+	 */
+	std::array<int,3> tileBits{{0,0,0}};
+
+	/**
+	 * The number of tiles in each direction of the lattice.
+	 */
+	std::array<int,3> numTiles{{0,0,0}};
+
+	/**
+	 * This operation finds the block of a node and the position of the node
+	 * in the block.
+	 * @param nodeId the node id
+	 * @param block the block
+	 * @param offset the position of the node in the block
+	 */
+	void split(const int & nodeId, int & block, int & offset) const {
+		if (latticeNodes[0] == 0) {
+			block = nodeId >> blockBits;
+			offset = nodeId & (blockSize - 1);
+			return;
+		}
+		int i = nodeId % latticeNodes[0], rest = nodeId / latticeNodes[0];
+		int j = rest % latticeNodes[1], k = rest / latticeNodes[1];
+		block = ((k >> tileBits[2])*numTiles[1] + (j >> tileBits[1]))
+				*numTiles[0] + (i >> tileBits[0]);
+		offset = ((((k & ((1 << tileBits[2]) - 1)) << tileBits[1])
+				| (j & ((1 << tileBits[1]) - 1))) << tileBits[0])
+				| (i & ((1 << tileBits[0]) - 1));
+	}
+
+	/**
+	 * The storage slot of each active block if the blocks are sparse.
+	 */
+	BlockTable blockSlots;
+
+	/**
+	 * The storage slot of every grid block, or -1 if it is not active, if
+	 * the blocks are dense.
+	 */
+	std::vector<int> denseSlots;
+
+	/**
+	 * This operation returns the storage slot of a block.
+	 * @param block the block
+	 * @return the storage slot, or -1 if the block is not active
+	 */
+	int findSlot(const int & block) const {
+		return sparse ? blockSlots.find(block) : denseSlots[block];
+	}
+
+	/**
+	 * The number of active nodes in the block in each storage slot.
+	 */
+	std::vector<int> activeNodes;
+
+	/**
+	 * Storage slots of retired blocks that can be reused.
+	 */
+	std::vector<int> freeSlots;
+
+	/**
+	 * The number of storage slots that have been allocated.
+	 */
+	int numSlots = 0;
+
+	/**
+	 * The number of particle stencils that include each node, one per node.
+	 * A node is active when its count is not zero.
+	 */
+	std::vector<int> countData;
+
+	/**
+	 * The nodal masses, one per node.
+	 */
+	std::vector<double> massData;
+
+	/**
+	 * The nodal momenta, node-major.
+	 */
+	std::vector<double> momentumData;
+
+	/**
+	 * The nodal forces, node-major.
+	 */
+	std::vector<double> forceData;
+
+	/**
+	 * The nodal velocities, node-major.
+	 */
+	std::vector<double> velocityData;
+
+	/**
+	 * The nodal accelerations, node-major.
+	 */
+	std::vector<double> accelerationData;
+
+	/**
+	 * This operation gives a block a storage slot and clears it.
+	 * @param block the block
+	 * @return the storage slot
+	 */
+	int allocate(const int & block);
+
+public:
+
+	/**
+	 * Constructor
+	 * @param numNodes the number of nodes in the grid
+	 * @param dim the dimension of the vector quantities
+	 * @param sparse true if the slots of the blocks should be found through
+	 * a hash table instead of an array over all grid blocks
+	 */
+	NodeBlocks(const int & numNodes = 0, const int & dim = 3,
+			const bool & sparse = false);
+
+	/**
+	 * This operation resizes the grid and retires every block.
+	 * @param numNodes the number of nodes in the grid
+	 * @param dim the dimension of the vector quantities
+	 * @param sparse true if the slots of the blocks should be found through
+	 * a hash table instead of an array over all grid blocks
+	 */
+	void resize(const int & numNodes, const int & dim,
+			const bool & sparse = false);
+
+	/**
+	 * This operation makes the blocks tiles of the vertex lattice of a
+	 * Cartesian mesh whose vertex ids run along the lattice, x first, then y,
+	 * then z. The tiles are 8x4 nodes in 2D and 4x4x2 nodes in 3D. Every
+	 * block is retired.
+	 * @param nodesPerDirection the number of nodes in each direction of the
+	 * lattice, 1 in the z direction in 2D
+	 */
+	void setLattice(const std::array<int,3> & nodesPerDirection);
+
+	/**
+	 * This operation adds a reference to a node, such as a particle stencil
+	 * that includes it. The node is activated by its first reference, which
+	 * activates its block if it is the first active node in it.
+	 * @param nodeId the node id
+	 * @return true if the node was activated, false if it was already active
+	 */
+	bool activate(const int & nodeId);
+
+	/**
+	 * This operation removes a reference to an active node. The node is
+	 * deactivated when its last reference is removed, which retires its
+	 * block if it was the last active node in it.
+	 * @param nodeId the node id
+	 * @return true if the node was deactivated, false if it is still active
+	 */
+	bool deactivate(const int & nodeId);
+
+	/**
+	 * This operation returns the number of references to a node.
+	 * @param nodeId the node id
+	 * @return the number of references, which is zero if the node is not
+	 * active
+	 */
+	int count(const int & nodeId) const;
+
+	/**
+	 * This operation returns true if the node is stored, which is the case
+	 * if its block is active.
+	 * @param nodeId the node id
+	 * @return true if the node is stored, false otherwise
+	 */
+	bool contains(const int & nodeId) const {
+		int block = 0, offset = 0;
+		split(nodeId,block,offset);
+		return findSlot(block) >= 0;
+	}
+
+	/**
+	 * This operation returns the entry of a stored node in the arrays of
+	 * nodal quantities. The vector quantities of the node start at
+	 * index(nodeId)*dim.
+	 * @param nodeId the node id, which must be stored
+	 * @return the index of the node
+	 */
+	int index(const int & nodeId) const {
+		int block = 0, offset = 0;
+		split(nodeId,block,offset);
+		return (findSlot(block) << blockBits) | offset;
+	}
+
+	/**
+	 * This operation returns the mass of a stored node.
+	 * @param nodeId the node id
+	 * @return the mass
+	 */
+	double & mass(const int & nodeId) {
+		return massData[index(nodeId)];
+	}
+
+	/**
+	 * This operation returns the momentum of a stored node.
+	 * @param nodeId the node id
+	 * @return the dim components of the momentum
+	 */
+	double * momentum(const int & nodeId) {
+		return &momentumData[index(nodeId)*dim];
+	}
+
+	/**
+	 * This operation returns the force on a stored node.
+	 * @param nodeId the node id
+	 * @return the dim components of the force
+	 */
+	double * force(const int & nodeId) {
+		return &forceData[index(nodeId)*dim];
+	}
+
+	/**
+	 * This operation returns the velocity of a stored node.
+	 * @param nodeId the node id
+	 * @return the dim components of the velocity
+	 */
+	double * velocity(const int & nodeId) {
+		return &velocityData[index(nodeId)*dim];
+	}
+
+	/**
+	 * This operation returns the acceleration of a stored node.
+	 * @param nodeId the node id
+	 * @return the dim components of the acceleration
+	 */
+	double * acceleration(const int & nodeId) {
+		return &accelerationData[index(nodeId)*dim];
+	}
+
+	/**
+	 * The same as mass(), but read only.
+	 */
+	double mass(const int & nodeId) const {
+		return massData[index(nodeId)];
+	}
+
+	/**
+	 * The same as momentum(), but read only.
+	 */
+	const double * momentum(const int & nodeId) const {
+		return &momentumData[index(nodeId)*dim];
+	}
+
+	/**
+	 * The same as force(), but read only.
+	 */
+	const double * force(const int & nodeId) const {
+		return &forceData[index(nodeId)*dim];
+	}
+
+	/**
+	 * The same as velocity(), but read only.
+	 */
+	const double * velocity(const int & nodeId) const {
+		return &velocityData[index(nodeId)*dim];
+	}
+
+	/**
+	 * The same as acceleration(), but read only.
+	 */
+	const double * acceleration(const int & nodeId) const {
+		return &accelerationData[index(nodeId)*dim];
+	}
+
+	/**
+	 * This operation returns true if the slots of the blocks are found
+	 * through a hash table.
+	 * @return true if the blocks are sparse, false otherwise
+	 */
+	bool isSparse() const {
+		return sparse;
+	}
+
+	/**
+	 * This operation returns the dimension of the vector quantities.
+	 * @return the dimension
+	 */
+	int dimension() const {
+		return dim;
+	}
+
+	/**
+	 * This operation returns the number of active blocks.
+	 * @return the number of active blocks
+	 */
+	int numActiveBlocks() const;
+
+	/**
+	 * This operation returns the number of nodes that storage is allocated
+	 * for, including the storage of retired blocks that will be reused.
+	 * @return the number of stored nodes, which is the length of the mass
+	 * array
+	 */
+	int capacity() const;
+
+	/**
+	 * This operation sets the masses, momenta and forces of all stored nodes
+	 * to zero.
+	 */
+	void clearTransfer();
+
+	/**
+	 * This operation returns the array of nodal masses.
+	 * @return the masses
+	 */
+	double * masses() {
+		return massData.data();
+	}
+
+	/**
+	 * This operation returns the array of nodal momenta.
+	 * @return the momenta
+	 */
+	double * momenta() {
+		return momentumData.data();
+	}
+
+	/**
+	 * This operation returns the array of nodal forces.
+	 * @return the forces
+	 */
+	double * forces() {
+		return forceData.data();
+	}
+
+	/**
+	 * This operation returns the array of nodal velocities.
+	 * @return the velocities
+	 */
+	double * velocities() {
+		return velocityData.data();
+	}
+
+	/**
+	 * This operation returns the array of nodal accelerations.
+	 * @return the accelerations
+	 */
+	double * accelerations() {
+		return accelerationData.data();
+	}
+
+	/**
+	 * The same as masses(), but read only.
+	 * @return the masses
+	 */
+	const double * masses() const {
+		return massData.data();
+	}
+
+	/**
+	 * The same as momenta(), but read only.
+	 * @return the momenta
+	 */
+	const double * momenta() const {
+		return momentumData.data();
+	}
+
+	/**
+	 * The same as forces(), but read only.
+	 * @return the forces
+	 */
+	const double * forces() const {
+		return forceData.data();
+	}
+
+	/**
+	 * The same as velocities(), but read only.
+	 * @return the velocities
+	 */
+	const double * velocities() const {
+		return velocityData.data();
+	}
+
+	/**
+	 * The same as accelerations(), but read only.
+	 * @return the accelerations
+	 */
+	const double * accelerations() const {
+		return accelerationData.data();
+	}
+
+};
+
+} /* namespace Kelvin */
+
+#endif /* SRC_NODEBLOCKS_H_ */
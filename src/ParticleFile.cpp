@@ -0,0 +1,403 @@
+/**----------------------------------------------------------------------------
+ Copyright  2018-, UT-Battelle, LLC
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ Author(s): Jay Jay Billings (billingsjj <at> ornl <dot> gov)
+ -----------------------------------------------------------------------------*/
+#include <ParticleFile.h>
+#include <fstream>
+#include <vector>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <cctype>
+#include <climits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+namespace Kelvin {
+
+/**
+ * The magic string at the start of binary particle files
+ */
+static const char particleFileMagic[8] = {'K','E','L','V','I','N','P','I'};
+
+/**
+ * The size of the binary header in bytes
+ */
+static const size_t particleFileHeaderSize = 24;
+
+/**
+ * This is a read-only memory map of a whole file. It is unmapped when it
+ * goes out of scope.
+ */
+class MappedFile {
+public:
+
+	/**
+	 * The start of the file, or null if it is empty
+	 */
+	const char * data = nullptr;
+
+	/**
+	 * The size of the file in bytes
+	 */
+	size_t size = 0;
+
+	/**
+	 * Constructor. Maps the file.
+	 * @param filename the name of the file
+	 */
+	MappedFile(const std::string & filename) {
+		int fd = open(filename.c_str(), O_RDONLY);
+		if (fd < 0) {
+			throw "Unable to open the particle file.";
+		}
+		struct stat status;
+		if (fstat(fd, &status) != 0) {
+			close(fd);
+			throw "Unable to open the particle file.";
+		}
+		size = status.st_size;
+		if (size > 0) {
+			void * map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (map == MAP_FAILED) {
+				close(fd);
+				throw "Unable to map the particle file.";
+			}
+			// The file is read front to back
+			madvise(map, size, MADV_SEQUENTIAL);
+			data = static_cast<const char *>(map);
+		}
+		// The map stays valid after the file is closed
+		close(fd);
+	}
+
+	/**
+	 * Destructor. Unmaps the file.
+	 */
+	~MappedFile() {
+		if (data) {
+			munmap(const_cast<char *>(data), size);
+		}
+	}
+
+	MappedFile(const MappedFile &) = delete;
+	MappedFile & operator=(const MappedFile &) = delete;
+};
+
+/**
+ * This operation returns true if the line is blank or a comment.
+ */
+static bool isSkippedLine(const char * begin, const char * end) {
+	while (begin < end && isspace((unsigned char) *begin)) {
+		begin++;
+	}
+	return begin == end || *begin == '#';
+}
+
+/**
+ * This operation returns the start of the line after the one that contains
+ * position, or end if there isn't one.
+ */
+static const char * nextLine(const char * position, const char * end) {
+	const char * newline = static_cast<const char *>(
+			memchr(position, '\n', end - position));
+	return newline ? newline + 1 : end;
+}
+
+/**
+ * This operation parses the coordinates and the material id of one CSV line.
+ * @return false if the line has too few values
+ */
+static bool parseLine(const char * begin, const char * end, const int & dim,
+		double * pos, int & materialId, string & buffer) {
+
+	// Copy the line so that strtod stops at its end, since the map is not
+	// null terminated.
+	buffer.assign(begin, end);
+	const char * position = buffer.c_str();
+	char * next;
+	for (int j = 0; j <= dim; j++) {
+		double value = strtod(position, &next);
+		if (next == position) {
+			// Only the material id may be left out
+			if (j < dim) {
+				return false;
+			}
+			materialId = 1;
+			break;
+		}
+		if (j < dim) {
+			pos[j] = value;
+		} else {
+			materialId = (int) value;
+		}
+		// Move past the delimiter
+		position = next;
+		while (*position == ',' || isspace((unsigned char) *position)) {
+			position++;
+		}
+	}
+
+	return true;
+}
+
+bool ParticleFile::isBinary(const std::string & filename) {
+	ifstream stream(filename, ios::in | ios::binary);
+	char magic[sizeof(particleFileMagic)];
+	stream.read(magic, sizeof(magic));
+	return stream && !memcmp(magic, particleFileMagic, sizeof(magic));
+}
+
+int ParticleFile::binaryDimension(const std::string & filename) {
+	if (!isBinary(filename)) {
+		throw "The file is not a Kelvin binary particle file.";
+	}
+	ifstream stream(filename, ios::in | ios::binary);
+	int32_t header32[2];
+	stream.seekg(sizeof(particleFileMagic));
+	stream.read(reinterpret_cast<char *>(header32), sizeof(header32));
+	swapToLittleEndian(header32, 2);
+	if (!stream || header32[1] < 1 || header32[1] > 3) {
+		throw "The dimension in the binary particle file header is invalid.";
+	}
+	return header32[1];
+}
+
+void ParticleFile::read(const std::string & filename, const int & dim,
+		ParticleSet & particles) {
+	if (isBinary(filename)) {
+		readBinary(filename, dim, particles);
+	} else {
+		readCSV(filename, dim, particles);
+	}
+}
+
+void ParticleFile::readBinary(const std::string & filename, const int & dim,
+		ParticleSet & particles) {
+
+	MappedFile file(filename);
+	if (file.size < particleFileHeaderSize
+			|| memcmp(file.data, particleFileMagic, sizeof(particleFileMagic))) {
+		throw "The file is not a Kelvin binary particle file.";
+	}
+
+	// Header
+	int32_t header32[2];
+	int64_t numParticles;
+	memcpy(header32, file.data + 8, sizeof(header32));
+	memcpy(&numParticles, file.data + 16, sizeof(numParticles));
+	swapToLittleEndian(header32, 2);
+	swapToLittleEndian(&numParticles, 1);
+	if (header32[0] != version) {
+		throw "Unsupported binary particle file version.";
+	}
+	if (header32[1] < 1 || header32[1] > 3) {
+		throw "The dimension in the binary particle file header is invalid.";
+	}
+	if (header32[1] != dim) {
+		throw "The dimension of the particle file does not match the mesh.";
+	}
+	// The particle set indexes its tensors with ints
+	if (numParticles < 0 || numParticles > INT_MAX/(dim*dim)) {
+		throw "The number of particles in the binary particle file header is invalid.";
+	}
+	// Divide instead of multiplying so that a huge count can't overflow
+	size_t bytesPerParticle = dim*sizeof(double) + sizeof(int32_t);
+	if ((file.size - particleFileHeaderSize)/bytesPerParticle
+			< (size_t) numParticles) {
+		throw "The binary particle file is truncated.";
+	}
+	size_t numValues = dim*numParticles;
+
+	// Copy the arrays straight from the map into the particles
+	particles = ParticleSet(dim, numParticles);
+	const char * posData = file.data + particleFileHeaderSize;
+	const char * idData = posData + numValues*sizeof(double);
+	if (numValues > 0) {
+		double * pos = particles.pos(0);
+		memcpy(pos, posData, numValues*sizeof(double));
+		swapToLittleEndian(pos, numValues);
+	}
+	#pragma omp parallel for schedule(static)
+	for (int64_t i = 0; i < numParticles; i++) {
+		int32_t materialId;
+		memcpy(&materialId, idData + i*sizeof(int32_t), sizeof(int32_t));
+		swapToLittleEndian(&materialId, 1);
+		particles.materialId(i) = materialId;
+	}
+
+	return;
+}
+
+void ParticleFile::readCSV(const std::string & filename, const int & dim,
+		ParticleSet & particles) {
+
+	MappedFile file(filename);
+	const char * begin = file.data;
+	const char * end = file.data + file.size;
+
+	// Split the file into one chunk of whole lines per thread
+	int numChunks = max(1, min(maxThreads(), (int) (file.size/4096) + 1));
+	vector<const char *> chunkStarts(numChunks + 1, end);
+	chunkStarts[0] = begin;
+	for (int t = 1; t < numChunks; t++) {
+		const char * start = begin + t*(file.size/numChunks);
+		chunkStarts[t] = max(chunkStarts[t-1],
+				start > begin ? nextLine(start - 1, end) : begin);
+	}
+
+	// Count the particles in each chunk and compute where each chunk's
+	// particles start in the set
+	vector<int> chunkOffsets(numChunks + 1, 0);
+	#pragma omp parallel for schedule(static,1)
+	for (int t = 0; t < numChunks; t++) {
+		int count = 0;
+		for (const char * line = chunkStarts[t]; line < chunkStarts[t+1];) {
+			const char * next = nextLine(line, chunkStarts[t+1]);
+			if (!isSkippedLine(line, next)) {
+				count++;
+			}
+			line = next;
+		}
+		chunkOffsets[t+1] = count;
+	}
+	for (int t = 0; t < numChunks; t++) {
+		chunkOffsets[t+1] += chunkOffsets[t];
+	}
+
+	// Parse each chunk into its part of the set
+	particles = ParticleSet(dim, chunkOffsets[numChunks]);
+	bool linesComplete = true;
+	#pragma omp parallel for schedule(static,1) reduction(&&:linesComplete)
+	for (int t = 0; t < numChunks; t++) {
+		string buffer;
+		int index = chunkOffsets[t];
+		for (const char * line = chunkStarts[t]; line < chunkStarts[t+1];) {
+			const char * next = nextLine(line, chunkStarts[t+1]);
+			if (!isSkippedLine(line, next)) {
+				if (!parseLine(line, next, dim, particles.pos(index),
+						particles.materialId(index), buffer)) {
+					linesComplete = false;
+				}
+				index++;
+			}
+			line = next;
+		}
+	}
+	if (!linesComplete) {
+		throw "Each line of a particle file needs one coordinate per dimension.";
+	}
+
+	return;
+}
+
+void ParticleFile::writeBinary(const std::string & filename,
+		const ParticleSet & particles) {
+
+	ofstream stream(filename, ios::out | ios::binary | ios::trunc);
+	if (!stream) {
+		throw "Unable to open the particle file for writing.";
+	}
+
+	// Header
+	int dim = particles.dimension();
+	int numParticles = particles.size();
+	int32_t header32[2] = {version, dim};
+	int64_t header64 = numParticles;
+	swapToLittleEndian(header32, 2);
+	swapToLittleEndian(&header64, 1);
+	stream.write(particleFileMagic, sizeof(particleFileMagic));
+	stream.write(reinterpret_cast<const char *>(header32), sizeof(header32));
+	stream.write(reinterpret_cast<const char *>(&header64), sizeof(header64));
+
+	// Arrays
+	vector<double> pos(particles.pos(0), particles.pos(0) + dim*numParticles);
+	swapToLittleEndian(pos.data(), pos.size());
+	stream.write(reinterpret_cast<const char *>(pos.data()),
+			pos.size()*sizeof(double));
+	vector<int32_t> materialIds(numParticles);
+	for (int i = 0; i < numParticles; i++) {
+		materialIds[i] = particles.materialId(i);
+	}
+	swapToLittleEndian(materialIds.data(), materialIds.size());
+	stream.write(reinterpret_cast<const char *>(materialIds.data()),
+			materialIds.size()*sizeof(int32_t));
+
+	stream.close();
+	if (!stream) {
+		throw "Unable to write the particle file.";
+	}
+
+	return;
+}
+
+void ParticleFile::writeCSV(const std::string & filename,
+		const ParticleSet & particles) {
+
+	ofstream stream(filename, ios::out | ios::trunc);
+	if (!stream) {
+		throw "Unable to open the particle file for writing.";
+	}
+	int dim = particles.dimension();
+	stream << "# Number of particles = " << particles.size() << "\n";
+	stream << (dim == 2 ? "# x, y, materialId\n" : "# x, y, z, materialId\n");
+
+	// Write enough digits to read the same doubles back
+	char field[64];
+	string lines;
+	for (int i = 0; i < particles.size(); i++) {
+		const double * pos = particles.pos(i);
+		for (int j = 0; j < dim; j++) {
+			int length = snprintf(field, sizeof(field), "%.17g, ", pos[j]);
+			lines.append(field, length);
+		}
+		lines += to_string(particles.materialId(i));
+		lines += '\n';
+		if (lines.size() > (1 << 20)) {
+			stream.write(lines.data(), lines.size());
+			lines.clear();
+		}
+	}
+	stream.write(lines.data(), lines.size());
+
+	stream.close();
+	if (!stream) {
+		throw "Unable to write the particle file.";
+	}
+
+	return;
+}
+
+} /* namespace Kelvin */
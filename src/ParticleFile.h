@@ -0,0 +1,132 @@
+/**----------------------------------------------------------------------------
+ Copyright  2018-, UT-Battelle, LLC
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ Author(s): Jay Jay Billings (billingsjj <at> ornl <dot> gov)
+ -----------------------------------------------------------------------------*/
+#ifndef SRC_PARTICLEFILE_H_
+#define SRC_PARTICLEFILE_H_
+
+#include <ParticleSet.h>
+#include <string>
+
+namespace Kelvin {
+
+/**
+ * This class reads and writes particle input files. Two formats are
+ * supported:
+ *
+ * CSV - one particle per line with its coordinates followed by its material
+ * id, separated by commas. Lines that start with # are comments and blank
+ * lines are skipped. The material id is 1 if it is left out.
+ *
+ * Binary - a 24 byte header - the 8 characters "KELVINPI", the format version
+ * and the dimension as 32-bit integers and the number of particles as a
+ * 64-bit integer - followed by the positions as doubles, dimension entries
+ * per particle, and then the material ids as 32-bit integers. Every value is
+ * little-endian. The positions have the same layout as in a ParticleSet, so
+ * they are copied directly from the mapped file.
+ *
+ * Both formats are read through a memory map of the file instead of being
+ * parsed into rows first. CSV files are split into chunks of lines that are
+ * parsed in parallel.
+ */
+class ParticleFile {
+public:
+
+	/**
+	 * The version of the binary format
+	 */
+	static const int version = 1;
+
+	/**
+	 * This operation returns true if the file is a binary particle file.
+	 * @param filename the name of the file
+	 * @return true if the file starts with the binary header, false otherwise
+	 */
+	static bool isBinary(const std::string & filename);
+
+	/**
+	 * This operation returns the dimension stored in the header of a binary
+	 * particle file.
+	 * @param filename the name of the file
+	 * @return the dimension of the particles in the file
+	 */
+	static int binaryDimension(const std::string & filename);
+
+	/**
+	 * This operation reads a particle file in either format. The positions
+	 * and material ids of the particles are set and everything else is reset.
+	 * @param filename the name of the file
+	 * @param dim the dimension of the particles
+	 * @param particles the particles, resized to the number in the file
+	 */
+	static void read(const std::string & filename, const int & dim,
+			ParticleSet & particles);
+
+	/**
+	 * This operation reads a binary particle file.
+	 * @param filename the name of the file
+	 * @param dim the dimension of the particles, which must match the file
+	 * @param particles the particles, resized to the number in the file
+	 */
+	static void readBinary(const std::string & filename, const int & dim,
+			ParticleSet & particles);
+
+	/**
+	 * This operation reads a CSV particle file.
+	 * @param filename the name of the file
+	 * @param dim the dimension of the particles
+	 * @param particles the particles, resized to the number in the file
+	 */
+	static void readCSV(const std::string & filename, const int & dim,
+			ParticleSet & particles);
+
+	/**
+	 * This operation writes the positions and material ids of the particles
+	 * in the binary format.
+	 * @param filename the name of the file
+	 * @param particles the particles
+	 */
+	static void writeBinary(const std::string & filename,
+			const ParticleSet & particles);
+
+	/**
+	 * This operation writes the positions and material ids of the particles
+	 * in the CSV format.
+	 * @param filename the name of the file
+	 * @param particles the particles
+	 */
+	static void writeCSV(const std::string & filename,
+			const ParticleSet & particles);
+
+};
+
+} /* namespace Kelvin */
+
+#endif /* SRC_PARTICLEFILE_H_ */
@@ -0,0 +1,255 @@
+/**----------------------------------------------------------------------------
+ Copyright  2018-, UT-Battelle, LLC
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ Author(s): Jay Jay Billings (billingsjj <at> ornl <dot> gov)
+ -----------------------------------------------------------------------------*/
+#include <ParticleSet.h>
+#include <algorithm>
+#include <numeric>
+#include <atomic>
+
+namespace Kelvin {
+
+/**
+ * The last generation given to any particle set
+ */
+static std::atomic<long> lastGeneration(0);
+
+ParticleSet::ParticleSet(int dim, int size) : nDim(dim), numParticles(0) {
+	resize(size);
+}
+
+void ParticleSet::checkDimension(const int & dim) const {
+	if (dim != nDim) {
+		throw "Material point and particle set dimension mismatch (unequal).";
+	}
+}
+
+void ParticleSet::newGeneration() {
+	orderGeneration = ++lastGeneration;
+}
+
+int ParticleSet::dimension() const {
+	return nDim;
+}
+
+int ParticleSet::size() const {
+	return numParticles;
+}
+
+void ParticleSet::resize(int size) {
+	int oldSize = numParticles;
+	numParticles = size;
+	int vectorSize = size*nDim;
+	int tensorSize = vectorSize*nDim;
+	_pos.resize(vectorSize,0.0);
+	_vel.resize(vectorSize,0.0);
+	_acc.resize(vectorSize,0.0);
+	_bodyForce.resize(vectorSize,0.0);
+	_stress.resize(tensorSize,0.0);
+	_strain.resize(tensorSize,0.0);
+	_mass.resize(size,0.0);
+	_volume.resize(size,0.0);
+	_materialId.resize(size,0);
+	// New particles are identified by their index
+	_id.resize(size);
+	for (int i = oldSize; i < size; i++) {
+		_id[i] = i;
+	}
+	// New particles have not been located
+	_elementId.resize(size,-1);
+	_referencePos.resize(vectorSize,0.0);
+	locationsCurrent = false;
+	newGeneration();
+}
+
+void ParticleSet::reserve(int size) {
+	int vectorSize = size*nDim;
+	int tensorSize = vectorSize*nDim;
+	_pos.reserve(vectorSize);
+	_vel.reserve(vectorSize);
+	_acc.reserve(vectorSize);
+	_bodyForce.reserve(vectorSize);
+	_stress.reserve(tensorSize);
+	_strain.reserve(tensorSize);
+	_mass.reserve(size);
+	_volume.reserve(size);
+	_materialId.reserve(size);
+	_id.reserve(size);
+	_elementId.reserve(size);
+	_referencePos.reserve(vectorSize);
+}
+
+void ParticleSet::clear() {
+	resize(0);
+}
+
+void ParticleSet::push_back(const MaterialPoint & point) {
+	checkDimension(point.dimension());
+	resize(numParticles+1);
+	set(numParticles-1,point);
+}
+
+void ParticleSet::assign(const std::vector<MaterialPoint> & points) {
+	int numPoints = points.size();
+	// Take the dimension from the points since they are the source of truth.
+	if (numPoints > 0) {
+		nDim = points[0].dimension();
+	}
+	// Resize from empty so that every field is reset
+	clear();
+	resize(numPoints);
+	for (int i = 0; i < numPoints; i++) {
+		set(i,points[i]);
+	}
+}
+
+void ParticleSet::copyTo(std::vector<MaterialPoint> & points) const {
+	if ((int) points.size() != numParticles) {
+		points.assign(numParticles,MaterialPoint(nDim));
+	}
+	for (int i = 0; i < numParticles; i++) {
+		get(i,points[i]);
+	}
+}
+
+void ParticleSet::get(const int & index, MaterialPoint & point) const {
+	const double * pPos = pos(index);
+	const double * pVel = vel(index);
+	const double * pAcc = acc(index);
+	const double * pBodyForce = bodyForce(index);
+	const double * pStress = stress(index);
+	const double * pStrain = strain(index);
+	for (int i = 0; i < nDim; i++) {
+		point.pos[i] = pPos[i];
+		point.vel[i] = pVel[i];
+		point.acc[i] = pAcc[i];
+		point.bodyForce[i] = pBodyForce[i];
+		for (int j = 0; j < nDim; j++) {
+			point.stress[i][j] = pStress[i*nDim+j];
+			point.strain[i][j] = pStrain[i*nDim+j];
+		}
+	}
+	point.mass = _mass[index];
+	point.volume = _volume[index];
+	point.materialId = _materialId[index];
+}
+
+void ParticleSet::set(const int & index, const MaterialPoint & point) {
+	double * pPos = pos(index);
+	double * pVel = vel(index);
+	double * pAcc = acc(index);
+	double * pBodyForce = bodyForce(index);
+	double * pStress = stress(index);
+	double * pStrain = strain(index);
+	for (int i = 0; i < nDim; i++) {
+		pPos[i] = point.pos[i];
+		pVel[i] = point.vel[i];
+		pAcc[i] = point.acc[i];
+		pBodyForce[i] = point.bodyForce[i];
+		for (int j = 0; j < nDim; j++) {
+			pStress[i*nDim+j] = point.stress[i][j];
+			pStrain[i*nDim+j] = point.strain[i][j];
+		}
+	}
+	_mass[index] = point.mass;
+	_volume[index] = point.volume;
+	_materialId[index] = point.materialId;
+	// The position may have changed
+	locationsCurrent = false;
+}
+
+/**
+ * This function gathers a field with a fixed number of entries per particle
+ * into a new order.
+ */
+template<typename T>
+static void gather(AlignedVector<T> & field, const int & stride,
+		const std::vector<int> & order) {
+	AlignedVector<T> reordered(field.size());
+	int size = order.size();
+	for (int i = 0; i < size; i++) {
+		std::copy_n(field.data() + order[i]*stride, stride,
+				reordered.data() + i*stride);
+	}
+	field.swap(reordered);
+}
+
+void ParticleSet::permute(const std::vector<int> & order) {
+	if ((int) order.size() != numParticles) {
+		throw "Particle order and particle set size mismatch (unequal).";
+	}
+	int tensorStride = nDim*nDim;
+	gather(_pos,nDim,order);
+	gather(_vel,nDim,order);
+	gather(_acc,nDim,order);
+	gather(_bodyForce,nDim,order);
+	gather(_stress,tensorStride,order);
+	gather(_strain,tensorStride,order);
+	gather(_mass,1,order);
+	gather(_volume,1,order);
+	gather(_materialId,1,order);
+	gather(_id,1,order);
+	gather(_elementId,1,order);
+	gather(_referencePos,nDim,order);
+	newGeneration();
+}
+
+void ParticleSet::groupByMaterial() {
+	if (std::is_sorted(_materialId.begin(),_materialId.end())) {
+		return;
+	}
+	std::vector<int> order(numParticles);
+	std::iota(order.begin(),order.end(),0);
+	std::stable_sort(order.begin(),order.end(),
+			[this](const int & a, const int & b) {
+		return _materialId[a] < _materialId[b];
+	});
+	permute(order);
+}
+
+std::vector<MaterialRange> ParticleSet::materialRanges() const {
+	std::vector<MaterialRange> ranges;
+	int begin = 0;
+	for (int i = 1; i <= numParticles; i++) {
+		if (i == numParticles || _materialId[i] != _materialId[begin]) {
+			ranges.push_back({_materialId[begin],begin,i});
+			begin = i;
+		}
+	}
+	return ranges;
+}
+
+MaterialPoint ParticleSet::operator[](const int & index) const {
+	MaterialPoint point(nDim);
+	get(index,point);
+	return point;
+}
+
+} /* namespace Kelvin */
@@ -0,0 +1,518 @@
+/**----------------------------------------------------------------------------
+ Copyright  2018-, UT-Battelle, LLC
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ Author(s): Jay Jay Billings (billingsjj <at> ornl <dot> gov)
+ -----------------------------------------------------------------------------*/
+#ifndef SRC_PARTICLESET_H_
+#define SRC_PARTICLESET_H_
+
+#include <MaterialPoint.h>
+#include <KelvinBaseTypes.h>
+#include <vector>
+
+namespace Kelvin {
+
+/**
+ * This is a contiguous range of particles, [begin,end), in a ParticleSet
+ * that all have the same material id.
+ */
+struct MaterialRange {
+	/**
+	 * The material id of every particle in the range
+	 */
+	int materialId;
+
+	/**
+	 * The index of the first particle in the range
+	 */
+	int begin;
+
+	/**
+	 * The index one past the last particle in the range
+	 */
+	int end;
+};
+
+/**
+ * This class stores a collection of material points as a structure of
+ * arrays. Each field - position, velocity, acceleration, body force, stress,
+ * strain, mass, volume and material id - is kept in its own contiguous,
+ * cache line aligned array instead of in separate heap allocations per
+ * particle.
+ *
+ * Vector and tensor fields are stored particle-major. The vector fields have
+ * dimension entries per particle and the tensors have dimension by dimension
+ * entries per particle in row-major order, so the values of particle i are
+ * accessed through pointers:
+ * @code
+ * double * pos = particles.pos(i);
+ * double * stress = particles.stress(i);
+ * pos[1] += dt*particles.vel(i)[1];
+ * double sigma_xy = stress[0*dim+1];
+ * @endcode
+ *
+ * MaterialPoints can still be read from and written to the set with
+ * operator[], get() and set(), but they are copies of the stored values, not
+ * views of them.
+ *
+ * Every particle also has an id that does not change when the particles are
+ * reordered with permute(). New particles get their index in the set as
+ * their id.
+ *
+ * The set also caches the location of each particle in the background mesh:
+ * the id of the element that contains it and its coordinates in the
+ * reference space of that element. The cache is filled by the grid and must
+ * be invalidated with invalidateLocations() whenever positions are changed
+ * through pos(). Operations on the set that change positions invalidate it
+ * automatically.
+ */
+class ParticleSet {
+protected:
+
+	/**
+	 * The number of dimensions of the particles.
+	 */
+	int nDim;
+
+	/**
+	 * The number of particles in the set.
+	 */
+	int numParticles;
+
+	/**
+	 * The positions, dimension entries per particle.
+	 */
+	AlignedVector<double> _pos;
+
+	/**
+	 * The velocities, dimension entries per particle.
+	 */
+	AlignedVector<double> _vel;
+
+	/**
+	 * The accelerations, dimension entries per particle.
+	 */
+	AlignedVector<double> _acc;
+
+	/**
+	 * The body forces, dimension entries per particle.
+	 */
+	AlignedVector<double> _bodyForce;
+
+	/**
+	 * The stress tensors, dimension by dimension entries per particle.
+	 */
+	AlignedVector<double> _stress;
+
+	/**
+	 * The strain tensors, dimension by dimension entries per particle.
+	 */
+	AlignedVector<double> _strain;
+
+	/**
+	 * The masses
+	 */
+	AlignedVector<double> _mass;
+
+	/**
+	 * The volumes
+	 */
+	AlignedVector<double> _volume;
+
+	/**
+	 * The material ids
+	 */
+	AlignedVector<int> _materialId;
+
+	/**
+	 * The stable particle ids
+	 */
+	AlignedVector<int> _id;
+
+	/**
+	 * The cached ids of the elements that contain the particles
+	 */
+	AlignedVector<int> _elementId;
+
+	/**
+	 * The cached reference coordinates of the particles in their elements,
+	 * dimension entries per particle
+	 */
+	AlignedVector<double> _referencePos;
+
+	/**
+	 * True if the cached locations match the present positions
+	 */
+	bool locationsCurrent = false;
+
+	/**
+	 * The generation of the order of the particles. See generation().
+	 */
+	long orderGeneration = 0;
+
+	/**
+	 * This operation gives the set a new generation.
+	 */
+	void newGeneration();
+
+	/**
+	 * This operation throws an exception if the dimension does not match the
+	 * dimension of the set.
+	 * @param dim the dimension to check
+	 */
+	void checkDimension(const int & dim) const;
+
+public:
+
+	/**
+	 * Constructor
+	 * @param dim the dimension of the particles
+	 * @param size the initial number of particles, all of which are zero
+	 */
+	ParticleSet(int dim = 3, int size = 0);
+
+	/**
+	 * This operation returns the dimension of the particles.
+	 * @return the dimension
+	 */
+	int dimension() const;
+
+	/**
+	 * This operation returns the number of particles in the set.
+	 * @return the number of particles
+	 */
+	int size() const;
+
+	/**
+	 * This operation changes the number of particles in the set. All of the
+	 * values of new particles are zero.
+	 * @param size the new number of particles
+	 */
+	void resize(int size);
+
+	/**
+	 * This operation reserves space for the given number of particles.
+	 * @param size the number of particles
+	 */
+	void reserve(int size);
+
+	/**
+	 * This operation removes all of the particles from the set.
+	 */
+	void clear();
+
+	/**
+	 * This operation adds a copy of a material point to the end of the set.
+	 * @param point the material point. It must have the same dimension as
+	 * the set.
+	 */
+	void push_back(const MaterialPoint & point);
+
+	/**
+	 * This operation replaces the contents of the set with copies of the
+	 * material points. The dimension of the set is taken from the first
+	 * point.
+	 * @param points the material points
+	 */
+	void assign(const std::vector<MaterialPoint> & points);
+
+	/**
+	 * This operation copies the contents of the set back into a list of
+	 * material points, which is resized to match the set if needed.
+	 * @param points the material points
+	 */
+	void copyTo(std::vector<MaterialPoint> & points) const;
+
+	/**
+	 * This operation copies the values of the i-th particle into a material
+	 * point of the same dimension.
+	 * @param index the particle index
+	 * @param point the material point that will hold the values
+	 */
+	void get(const int & index, MaterialPoint & point) const;
+
+	/**
+	 * This operation sets the values of the i-th particle from a material
+	 * point of the same dimension.
+	 * @param index the particle index
+	 * @param point the material point with the new values
+	 */
+	void set(const int & index, const MaterialPoint & point);
+
+	/**
+	 * This operation returns a copy of the i-th particle as a material point.
+	 * Changes to the copy are not stored in the set; use set() for that.
+	 * @param index the particle index
+	 * @return the material point
+	 */
+	MaterialPoint operator[](const int & index) const;
+
+	/**
+	 * This operation reorders the particles in the set such that the i-th
+	 * particle after the call is the order[i]-th particle before it. The
+	 * particle ids move with the particles.
+	 * @param order the new order, which must be a permutation of the
+	 * particle indices
+	 */
+	void permute(const std::vector<int> & order);
+
+	/**
+	 * This operation reorders the particles so that all of the particles
+	 * with the same material id are stored contiguously, sorted by material
+	 * id. The relative order of particles with the same material id is kept,
+	 * and the set is not changed at all if it is already grouped.
+	 */
+	void groupByMaterial();
+
+	/**
+	 * This operation returns the ranges of consecutive particles that share a
+	 * material id, in order. After groupByMaterial() there is exactly one
+	 * range per material.
+	 * @return the material ranges
+	 */
+	std::vector<MaterialRange> materialRanges() const;
+
+	/**
+	 * The position of the i-th particle, dimension entries.
+	 */
+	double * pos(const int & index) {
+		return _pos.data() + index*nDim;
+	};
+
+	/**
+	 * The position of the i-th particle, dimension entries.
+	 */
+	const double * pos(const int & index) const {
+		return _pos.data() + index*nDim;
+	};
+
+	/**
+	 * The velocity of the i-th particle, dimension entries.
+	 */
+	double * vel(const int & index) {
+		return _vel.data() + index*nDim;
+	};
+
+	/**
+	 * The velocity of the i-th particle, dimension entries.
+	 */
+	const double * vel(const int & index) const {
+		return _vel.data() + index*nDim;
+	};
+
+	/**
+	 * The acceleration of the i-th particle, dimension entries.
+	 */
+	double * acc(const int & index) {
+		return _acc.data() + index*nDim;
+	};
+
+	/**
+	 * The acceleration of the i-th particle, dimension entries.
+	 */
+	const double * acc(const int & index) const {
+		return _acc.data() + index*nDim;
+	};
+
+	/**
+	 * The body force on the i-th particle, dimension entries.
+	 */
+	double * bodyForce(const int & index) {
+		return _bodyForce.data() + index*nDim;
+	};
+
+	/**
+	 * The body force on the i-th particle, dimension entries.
+	 */
+	const double * bodyForce(const int & index) const {
+		return _bodyForce.data() + index*nDim;
+	};
+
+	/**
+	 * The stress tensor of the i-th particle, dimension by dimension entries
+	 * in row-major order.
+	 */
+	double * stress(const int & index) {
+		return _stress.data() + index*nDim*nDim;
+	};
+
+	/**
+	 * The stress tensor of the i-th particle, dimension by dimension entries
+	 * in row-major order.
+	 */
+	const double * stress(const int & index) const {
+		return _stress.data() + index*nDim*nDim;
+	};
+
+	/**
+	 * The strain tensor of the i-th particle, dimension by dimension entries
+	 * in row-major order.
+	 */
+	double * strain(const int & index) {
+		return _strain.data() + index*nDim*nDim;
+	};
+
+	/**
+	 * The strain tensor of the i-th particle, dimension by dimension entries
+	 * in row-major order.
+	 */
+	const double * strain(const int & index) const {
+		return _strain.data() + index*nDim*nDim;
+	};
+
+	/**
+	 * The mass of the i-th particle
+	 */
+	double & mass(const int & index) {
+		return _mass[index];
+	};
+
+	/**
+	 * The mass of the i-th particle
+	 */
+	const double & mass(const int & index) const {
+		return _mass[index];
+	};
+
+	/**
+	 * The volume of the i-th particle
+	 */
+	double & volume(const int & index) {
+		return _volume[index];
+	};
+
+	/**
+	 * The volume of the i-th particle
+	 */
+	const double & volume(const int & index) const {
+		return _volume[index];
+	};
+
+	/**
+	 * The material id of the i-th particle
+	 */
+	int & materialId(const int & index) {
+		return _materialId[index];
+	};
+
+	/**
+	 * The material id of the i-th particle
+	 */
+	const int & materialId(const int & index) const {
+		return _materialId[index];
+	};
+
+	/**
+	 * The stable id of the i-th particle, which is kept through reordering
+	 */
+	int & id(const int & index) {
+		return _id[index];
+	};
+
+	/**
+	 * The stable id of the i-th particle, which is kept through reordering
+	 */
+	const int & id(const int & index) const {
+		return _id[index];
+	};
+
+	/**
+	 * The cached id of the element that contains the i-th particle, or -1 if
+	 * the particle is outside of the mesh. Only valid if
+	 * locationsAreCurrent() is true.
+	 */
+	int & elementId(const int & index) {
+		return _elementId[index];
+	};
+
+	/**
+	 * The cached id of the element that contains the i-th particle
+	 */
+	const int & elementId(const int & index) const {
+		return _elementId[index];
+	};
+
+	/**
+	 * The cached reference coordinates of the i-th particle in its element,
+	 * dimension entries. Only valid if locationsAreCurrent() is true.
+	 */
+	double * referencePos(const int & index) {
+		return _referencePos.data() + index*nDim;
+	};
+
+	/**
+	 * The cached reference coordinates of the i-th particle in its element
+	 */
+	const double * referencePos(const int & index) const {
+		return _referencePos.data() + index*nDim;
+	};
+
+	/**
+	 * This operation returns true if the cached element ids and reference
+	 * coordinates match the present positions of the particles.
+	 * @return true if the locations are current, false otherwise
+	 */
+	bool locationsAreCurrent() const {
+		return locationsCurrent;
+	};
+
+	/**
+	 * This operation marks the cached locations as current after they have
+	 * been filled for the present positions.
+	 */
+	void validateLocations() {
+		locationsCurrent = true;
+	};
+
+	/**
+	 * This operation marks the cached locations as out of date. It must be
+	 * called after moving the particles.
+	 */
+	void invalidateLocations() {
+		locationsCurrent = false;
+	};
+
+	/**
+	 * This operation returns the generation of the order of the particles.
+	 * It changes whenever particles are added, removed or reordered, and no
+	 * two sets ever share a generation, so data that is stored per particle
+	 * in the order of a set, such as the stencils of a Grid, can check that
+	 * it still belongs to the set. Changing the values of the particles does
+	 * not change the generation.
+	 * @return the generation
+	 */
+	long generation() const {
+		return orderGeneration;
+	};
+
+};
+
+} /* namespace Kelvin */
+
+#endif /* SRC_PARTICLESET_H_ */
@@ -0,0 +1,130 @@
+/**----------------------------------------------------------------------------
+ Copyright  2018-, UT-Battelle, LLC
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ Author(s): Jay Jay Billings (billingsjj <at> ornl <dot> gov)
+ -----------------------------------------------------------------------------*/
+#include <ParticleSorter.h>
+#include <algorithm>
+#include <numeric>
+#include <limits>
+
+namespace Kelvin {
+
+ParticleSorter::ParticleSorter(MeshContainer & meshContainer) :
+		dim(meshContainer.dimension()) {
+
+	auto & mesh = meshContainer.getMesh();
+	int numVerts = mesh.GetNV();
+	int numElements = mesh.GetNE();
+
+	// Find the bounding box of the mesh
+	std::vector<double> lower(dim,std::numeric_limits<double>::max());
+	std::vector<double> upper(dim,std::numeric_limits<double>::lowest());
+	for (int i = 0; i < numVerts; i++) {
+		const double * vertex = mesh.GetVertex(i);
+		for (int j = 0; j < dim; j++) {
+			lower[j] = std::min(lower[j],vertex[j]);
+			upper[j] = std::max(upper[j],vertex[j]);
+		}
+	}
+
+	// Compute the Morton code of each element centroid, quantized to the
+	// resolution of the code over the bounding box.
+	const double maxCoord = (double) ((1u << bitsPerCoordinate) - 1);
+	elementKeys.resize(numElements);
+	mfem::Array<int> vertexIds;
+	uint32_t coords[3] = {0,0,0};
+	for (int i = 0; i < numElements; i++) {
+		mesh.GetElementVertices(i,vertexIds);
+		int numElementVerts = vertexIds.Size();
+		for (int j = 0; j < dim; j++) {
+			double centroid = 0.0;
+			for (int k = 0; k < numElementVerts; k++) {
+				centroid += mesh.GetVertex(vertexIds[k])[j];
+			}
+			centroid /= numElementVerts;
+			double width = upper[j] - lower[j];
+			double scaled = (width > 0.0) ?
+					(centroid - lower[j])/width : 0.0;
+			coords[j] = (uint32_t) (scaled*maxCoord);
+		}
+		elementKeys[i] = mortonCode(coords,dim);
+	}
+
+}
+
+uint64_t ParticleSorter::mortonCode(const uint32_t * coords,
+		const int & dim) {
+	uint64_t code = 0;
+	for (int bit = 0; bit < bitsPerCoordinate; bit++) {
+		for (int j = 0; j < dim; j++) {
+			uint64_t value = (coords[j] >> bit) & 1u;
+			code |= value << (bit*dim + j);
+		}
+	}
+	return code;
+}
+
+bool ParticleSorter::sort(const Grid & grid, ParticleSet & particles) {
+
+	// Compute the key of every particle from its element, which is cached if
+	// the particles were already located. Particles outside of the mesh go to
+	// the end.
+	int numParticles = particles.size();
+	int numElements = elementKeys.size();
+	bool useCache = particles.locationsAreCurrent();
+	particleKeys.resize(numParticles);
+	for (int i = 0; i < numParticles; i++) {
+		int elementId = (useCache) ?
+				particles.elementId(i) : grid.getElementId(particles,i);
+		particleKeys[i] = (elementId > -1 && elementId < numElements) ?
+				elementKeys[elementId] : std::numeric_limits<uint64_t>::max();
+	}
+
+	// Order by material, then by key. Ties keep their present order.
+	auto before = [&](const int & a, const int & b) {
+		int materialA = particles.materialId(a);
+		int materialB = particles.materialId(b);
+		return (materialA < materialB)
+				|| (materialA == materialB && particleKeys[a] < particleKeys[b]);
+	};
+	order.resize(numParticles);
+	std::iota(order.begin(),order.end(),0);
+	// Don't reorder anything if the particles are already sorted, which is
+	// common since they move slowly between sorts.
+	if (std::is_sorted(order.begin(),order.end(),before)) {
+		return false;
+	}
+	std::stable_sort(order.begin(),order.end(),before);
+	particles.permute(order);
+
+	return true;
+}
+
+} /* namespace Kelvin */
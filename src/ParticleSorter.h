@@ -0,0 +1,122 @@
+/**----------------------------------------------------------------------------
+ Copyright  2018-, UT-Battelle, LLC
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ Author(s): Jay Jay Billings (billingsjj <at> ornl <dot> gov)
+ -----------------------------------------------------------------------------*/
+#ifndef SRC_PARTICLESORTER_H_
+#define SRC_PARTICLESORTER_H_
+
+#include <ParticleSet.h>
+#include <MeshContainer.h>
+#include <Grid.h>
+#include <cstdint>
+#include <vector>
+
+namespace Kelvin {
+
+/**
+ * This class reorders particles so that particles that are close to each
+ * other in space are also close to each other in memory. Particles are binned
+ * by the background element that contains them and the bins are ordered along
+ * a Morton (Z-order) space filling curve through the element centroids, so
+ * the particle-to-grid and grid-to-particle loops walk the grid nodes in a
+ * mostly local order.
+ *
+ * Particles are still grouped by material id first, so the material ranges
+ * of the set are kept. Within a bin the particles keep their relative order.
+ * Particles outside of the mesh are placed at the end of their material
+ * group. The stable ids of the particles move with them, so output can still
+ * be written in the original order.
+ * @code
+ * ParticleSorter sorter(meshContainer);
+ * sorter.sort(grid,particles);
+ * @endcode
+ */
+class ParticleSorter {
+protected:
+
+	/**
+	 * The spatial dimension of the mesh
+	 */
+	int dim;
+
+	/**
+	 * The Morton code of the centroid of each element in the mesh
+	 */
+	std::vector<uint64_t> elementKeys;
+
+	/**
+	 * Scratch space for the sort keys of the particles
+	 */
+	std::vector<uint64_t> particleKeys;
+
+	/**
+	 * Scratch space for the new order of the particles
+	 */
+	std::vector<int> order;
+
+public:
+
+	/**
+	 * The number of bits used for each coordinate in the Morton code.
+	 */
+	static const int bitsPerCoordinate = 21;
+
+	/**
+	 * Constructor. The Morton codes of the elements are computed here once.
+	 * @param meshContainer the mesh container that holds the background mesh
+	 */
+	ParticleSorter(MeshContainer & meshContainer);
+
+	/**
+	 * This operation reorders the particles by material and then along the
+	 * space filling curve. It does nothing if the particles are already in
+	 * order.
+	 * @param grid the grid, which is used to find the element of each
+	 * particle
+	 * @param particles the particles to sort
+	 * @return true if the particles were reordered, false otherwise
+	 */
+	bool sort(const Grid & grid, ParticleSet & particles);
+
+	/**
+	 * This operation interleaves the bits of the coordinates to compute a
+	 * Morton code. Only the lowest bitsPerCoordinate bits of each coordinate
+	 * are used.
+	 * @param coords the integer coordinates
+	 * @param dim the number of coordinates, 2 or 3
+	 * @return the Morton code
+	 */
+	static uint64_t mortonCode(const uint32_t * coords, const int & dim);
+
+};
+
+} /* namespace Kelvin */
+
+#endif /* SRC_PARTICLESORTER_H_ */
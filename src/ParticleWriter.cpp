@@ -0,0 +1,255 @@
+/**----------------------------------------------------------------------------
+ Copyright  2018-, UT-Battelle, LLC
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ Author(s): Jay Jay Billings (billingsjj <at> ornl <dot> gov)
+ -----------------------------------------------------------------------------*/
+#include <ParticleWriter.h>
+#include <fstream>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+
+using namespace std;
+
+namespace Kelvin {
+
+/**
+ * The magic string at the start of binary snapshots
+ */
+static const char snapshotMagic[8] = {'K','E','L','V','I','N','P','S'};
+
+void ParticleSnapshot::assign(const ParticleSet & particles,
+		const int & step, const double & time) {
+
+	dim = particles.dimension();
+	numParticles = particles.size();
+	this->step = step;
+	this->time = time;
+	pos.resize(dim*numParticles);
+	vel.resize(dim*numParticles);
+	stress.resize(dim*dim*numParticles);
+	materialId.resize(numParticles);
+
+	// Scatter each particle to the position of its stable id, which is the
+	// order of the input file, even if they were reordered in memory.
+	bool idsInRange = true;
+	#pragma omp parallel for schedule(static) reduction(&&:idsInRange)
+	for (int i = 0; i < numParticles; i++) {
+		int id = particles.id(i);
+		if (id < 0 || id >= numParticles) {
+			idsInRange = false;
+			continue;
+		}
+		const double * pPos = particles.pos(i);
+		const double * pVel = particles.vel(i);
+		const double * pStress = particles.stress(i);
+		for (int j = 0; j < dim; j++) {
+			pos[j*numParticles + id] = pPos[j];
+			vel[j*numParticles + id] = pVel[j];
+		}
+		for (int j = 0; j < dim*dim; j++) {
+			stress[j*numParticles + id] = pStress[j];
+		}
+		materialId[id] = particles.materialId(i);
+	}
+	if (!idsInRange) {
+		throw "Particle id out of range. Ids must be 0 to the number of particles - 1.";
+	}
+
+	return;
+}
+
+void ParticleSnapshot::writeBinary(const std::string & filename) const {
+
+	ofstream stream(filename, ios::out | ios::binary | ios::trunc);
+	if (!stream) {
+		throw "Unable to open the particle output file.";
+	}
+
+	// Header
+	const int32_t header32[2] = {version, dim};
+	const int64_t header64[2] = {numParticles, step};
+	stream.write(snapshotMagic, sizeof(snapshotMagic));
+	writeLittleEndian(stream, header32, 2);
+	writeLittleEndian(stream, header64, 2);
+	writeLittleEndian(stream, &time, 1);
+
+	// Arrays
+	writeLittleEndian(stream, pos.data(), pos.size());
+	writeLittleEndian(stream, vel.data(), vel.size());
+	writeLittleEndian(stream, stress.data(), stress.size());
+	// Make sure the ids are written as 32-bit integers
+	if (sizeof(int) == sizeof(int32_t)) {
+		writeLittleEndian(stream,
+				reinterpret_cast<const int32_t *>(materialId.data()),
+				materialId.size());
+	} else {
+		vector<int32_t> ids(materialId.begin(), materialId.end());
+		writeLittleEndian(stream, ids.data(), ids.size());
+	}
+
+	stream.close();
+	if (!stream) {
+		throw "Unable to write the particle output file.";
+	}
+
+	return;
+}
+
+void ParticleSnapshot::writeCSV(const std::string & filename) const {
+
+	ofstream stream(filename, ios::out | ios::trunc);
+	if (!stream) {
+		throw "Unable to open the particle output file.";
+	}
+
+	// Format a block of lines at a time instead of streaming each value
+	char field[64];
+	string lines;
+	lines.reserve(1 << 20);
+	int stepLength = snprintf(field, sizeof(field), "%.15f", (double) step);
+	string stepField(field, stepLength);
+	for (int i = 0; i < numParticles; i++) {
+		for (int j = 0; j < dim; j++) {
+			int length = snprintf(field, sizeof(field), "%.15f, ",
+					pos[j*numParticles + i]);
+			lines.append(field, length);
+		}
+		lines += stepField;
+		lines += '\n';
+		if (lines.size() > (1 << 20) - 256) {
+			stream.write(lines.data(), lines.size());
+			lines.clear();
+		}
+	}
+	stream.write(lines.data(), lines.size());
+
+	stream.close();
+	if (!stream) {
+		throw "Unable to write the particle output file.";
+	}
+
+	return;
+}
+
+void ParticleSnapshot::readBinary(const std::string & filename) {
+
+	ifstream stream(filename, ios::in | ios::binary);
+	if (!stream) {
+		throw "Unable to open the particle snapshot file.";
+	}
+
+	// Header
+	char magic[sizeof(snapshotMagic)];
+	int32_t header32[2];
+	int64_t header64[2];
+	stream.read(magic, sizeof(magic));
+	if (!stream || memcmp(magic, snapshotMagic, sizeof(magic))) {
+		throw "The file is not a Kelvin particle snapshot.";
+	}
+	readLittleEndian(stream, header32, 2);
+	readLittleEndian(stream, header64, 2);
+	readLittleEndian(stream, &time, 1);
+	if (!stream || header32[0] != version) {
+		throw "Unsupported particle snapshot version.";
+	}
+	dim = header32[1];
+	numParticles = (int) header64[0];
+	step = (int) header64[1];
+	if (dim < 1 || dim > 3 || numParticles < 0) {
+		throw "Invalid particle snapshot header.";
+	}
+
+	// Arrays
+	pos.resize(dim*numParticles);
+	vel.resize(dim*numParticles);
+	stress.resize(dim*dim*numParticles);
+	vector<int32_t> ids(numParticles);
+	readLittleEndian(stream, pos.data(), pos.size());
+	readLittleEndian(stream, vel.data(), vel.size());
+	readLittleEndian(stream, stress.data(), stress.size());
+	readLittleEndian(stream, ids.data(), ids.size());
+	if (!stream) {
+		throw "The particle snapshot file is truncated.";
+	}
+	materialId.assign(ids.begin(), ids.end());
+
+	return;
+}
+
+ParticleWriter::ParticleWriter(const ParticleOutputFormat & format,
+		const std::string & prefix) : _format(format), _prefix(prefix) {
+}
+
+const ParticleOutputFormat & ParticleWriter::format() const {
+	return _format;
+}
+
+std::string ParticleWriter::filename(const int & step) const {
+	if (_format == ParticleOutputFormat::CSV) {
+		// Same names as the original CSV output
+		return _prefix + to_string((double) step) + ".csv";
+	}
+	return _prefix + to_string(step) + ".bin";
+}
+
+void ParticleWriter::write(const ParticleSet & particles, const int & step,
+		const double & time) {
+
+	// The writer thread never reads this buffer while it is being filled
+	// because the last snapshot in it was finished before the other buffer
+	// was queued.
+	ParticleSnapshot & snapshot = _buffers[_next];
+	snapshot.assign(particles, step, time);
+	_writer.submit([this,&snapshot]() {
+		if (_format == ParticleOutputFormat::BINARY) {
+			snapshot.writeBinary(filename(snapshot.step));
+		} else {
+			snapshot.writeCSV(filename(snapshot.step));
+		}
+	});
+	_next = 1 - _next;
+
+	return;
+}
+
+void ParticleWriter::flush() {
+	_writer.wait();
+}
+
+ParticleOutputFormat ParticleWriter::parseFormat(const std::string & name) {
+	if (name == "binary") {
+		return ParticleOutputFormat::BINARY;
+	} else if (name == "csv") {
+		return ParticleOutputFormat::CSV;
+	}
+	throw "Unknown output format. Use binary or csv.";
+}
+
+} /* namespace Kelvin */
@@ -0,0 +1,247 @@
+/**----------------------------------------------------------------------------
+ Copyright  2018-, UT-Battelle, LLC
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ Author(s): Jay Jay Billings (billingsjj <at> ornl <dot> gov)
+ -----------------------------------------------------------------------------*/
+#ifndef SRC_PARTICLEWRITER_H_
+#define SRC_PARTICLEWRITER_H_
+
+#include <ParticleSet.h>
+#include <string>
+#include <vector>
+#include <BackgroundWriter.h>
+
+namespace Kelvin {
+
+/**
+ * The formats that particle snapshots can be written in.
+ */
+enum class ParticleOutputFormat {
+	/**
+	 * A binary header followed by raw little-endian arrays.
+	 */
+	BINARY,
+	/**
+	 * One line of text per particle with the position and the step.
+	 */
+	CSV
+};
+
+/**
+ * This is a copy of the particle data that is written at an output step:
+ * positions, velocities, stresses and material ids, in the order of the
+ * stable particle ids.
+ *
+ * The arrays are component-major, so component j of the position of particle
+ * i is pos[j*numParticles + i] and component (j,k) of its stress is
+ * stress[(j*dim + k)*numParticles + i].
+ *
+ * The binary format is a 40 byte header - the 8 character magic string
+ * "KELVINPS", the format version and the dimension as 32-bit integers, the
+ * number of particles and the step as 64-bit integers and the time as a
+ * double - followed by the position, velocity, stress and material id
+ * arrays in the layout above. Every value is little-endian and the material
+ * ids are 32-bit integers.
+ */
+struct ParticleSnapshot {
+
+	/**
+	 * The version of the binary format
+	 */
+	static const int version = 1;
+
+	/**
+	 * The dimension of the particles
+	 */
+	int dim = 0;
+
+	/**
+	 * The number of particles
+	 */
+	int numParticles = 0;
+
+	/**
+	 * The time step of the snapshot
+	 */
+	int step = 0;
+
+	/**
+	 * The simulation time of the snapshot
+	 */
+	double time = 0.0;
+
+	/**
+	 * The positions, dim component arrays
+	 */
+	std::vector<double> pos;
+
+	/**
+	 * The velocities, dim component arrays
+	 */
+	std::vector<double> vel;
+
+	/**
+	 * The stresses, dim by dim component arrays in row-major order
+	 */
+	std::vector<double> stress;
+
+	/**
+	 * The material ids
+	 */
+	std::vector<int> materialId;
+
+	/**
+	 * This operation copies the particles into the snapshot, ordered by
+	 * their ids. The storage is reused between calls.
+	 * @param particles the particles, with ids from 0 to size - 1
+	 * @param step the time step
+	 * @param time the simulation time
+	 */
+	void assign(const ParticleSet & particles, const int & step,
+			const double & time);
+
+	/**
+	 * This operation writes the snapshot in the binary format.
+	 * @param filename the name of the file
+	 */
+	void writeBinary(const std::string & filename) const;
+
+	/**
+	 * This operation writes the positions of the particles and the step, one
+	 * particle per line.
+	 * @param filename the name of the file
+	 */
+	void writeCSV(const std::string & filename) const;
+
+	/**
+	 * This operation reads a snapshot in the binary format.
+	 * @param filename the name of the file
+	 */
+	void readBinary(const std::string & filename);
+
+};
+
+/**
+ * This class writes particle snapshots on a background thread so that the
+ * time loop does not wait on the disk. The particles are copied into one of
+ * two snapshot buffers by write() while the other buffer is being written,
+ * so the caller only blocks if the previous snapshot has not finished by the
+ * time the next one is ready.
+ *
+ * Errors on the writer thread are reported by the next call to write() or
+ * flush().
+ */
+class ParticleWriter {
+protected:
+
+	/**
+	 * The output format
+	 */
+	ParticleOutputFormat _format;
+
+	/**
+	 * The prefix of the output file names
+	 */
+	std::string _prefix;
+
+	/**
+	 * The snapshot buffers, one filled by write() while the other is written
+	 */
+	ParticleSnapshot _buffers[2];
+
+	/**
+	 * The index of the buffer that the next call to write() fills
+	 */
+	int _next = 0;
+
+	/**
+	 * The writer thread. It is declared last so that it finishes before the
+	 * buffers are destroyed.
+	 */
+	BackgroundWriter _writer;
+
+public:
+
+	/**
+	 * Constructor
+	 * @param format the output format
+	 * @param prefix the prefix of the output file names
+	 */
+	ParticleWriter(const ParticleOutputFormat & format =
+			ParticleOutputFormat::CSV,
+			const std::string & prefix = "kelvin_output_");
+
+	/**
+	 * Destructor. Waits for the last snapshot to be written.
+	 */
+	~ParticleWriter() = default;
+
+	ParticleWriter(const ParticleWriter &) = delete;
+	ParticleWriter & operator=(const ParticleWriter &) = delete;
+
+	/**
+	 * This operation returns the output format.
+	 */
+	const ParticleOutputFormat & format() const;
+
+	/**
+	 * This operation returns the name of the file for a step.
+	 * @param step the time step
+	 * @return the file name
+	 */
+	std::string filename(const int & step) const;
+
+	/**
+	 * This operation copies the particles and queues them to be written to
+	 * filename(step). It returns as soon as the copy is done.
+	 * @param particles the particles, with ids from 0 to size - 1
+	 * @param step the time step
+	 * @param time the simulation time
+	 */
+	void write(const ParticleSet & particles, const int & step,
+			const double & time);
+
+	/**
+	 * This operation waits for all queued snapshots to be written.
+	 */
+	void flush();
+
+	/**
+	 * This operation converts the name of a format, "binary" or "csv", to
+	 * the format.
+	 * @param name the name of the format
+	 * @return the format
+	 */
+	static ParticleOutputFormat parseFormat(const std::string & name);
+
+};
+
+} /* namespace Kelvin */
+
+#endif /* SRC_PARTICLEWRITER_H_ */
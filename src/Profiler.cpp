@@ -0,0 +1,359 @@
+/**----------------------------------------------------------------------------
+ Copyright  2018-, UT-Battelle, LLC
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ Author(s): Jay Jay Billings (billingsjj <at> ornl <dot> gov)
+ -----------------------------------------------------------------------------*/
+#include <Profiler.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <KelvinBaseTypes.h>
+
+using namespace std;
+
+namespace Kelvin {
+
+/**
+ * The records of one thread are only written by that thread. They have their
+ * own lock so that they can be merged while it runs, which is never
+ * contended while recording. The records are merged into the retired ones
+ * when the thread finishes.
+ */
+struct Profiler::Accumulator {
+
+	/**
+	 * The lock for the records of the thread
+	 */
+	std::mutex mutex;
+
+	/**
+	 * The phases by id
+	 */
+	std::vector<ProfilePhase> phases;
+
+	/**
+	 * The counters by id
+	 */
+	std::vector<long long> counters;
+
+	/**
+	 * Constructor. Registers the accumulator.
+	 */
+	Accumulator() {
+		lock_guard<std::mutex> lock(Profiler::_mutex);
+		Profiler::_accumulators.push_back(this);
+	}
+
+	/**
+	 * Destructor. Retires the records and unregisters the accumulator.
+	 */
+	~Accumulator() {
+		lock_guard<std::mutex> lock(Profiler::_mutex);
+		auto & retiredPhases = Profiler::_retiredPhases;
+		auto & retiredCounters = Profiler::_retiredCounters;
+		if (retiredPhases.size() < phases.size()) {
+			retiredPhases.resize(phases.size());
+		}
+		for (size_t i = 0; i < phases.size(); i++) {
+			retiredPhases[i].merge(phases[i]);
+		}
+		if (retiredCounters.size() < counters.size()) {
+			retiredCounters.resize(counters.size(),0);
+		}
+		for (size_t i = 0; i < counters.size(); i++) {
+			retiredCounters[i] += counters[i];
+		}
+		auto & accumulators = Profiler::_accumulators;
+		accumulators.erase(std::find(accumulators.begin(),accumulators.end(),
+				this));
+	}
+
+};
+
+// Initialize the registry
+std::map<std::string,int> Profiler::_phaseIds;
+std::map<std::string,int> Profiler::_counterIds;
+std::vector<Profiler::Accumulator *> Profiler::_accumulators;
+std::vector<ProfilePhase> Profiler::_retiredPhases;
+std::vector<long long> Profiler::_retiredCounters;
+std::mutex Profiler::_mutex;
+
+const int ProfilePhase::maxSamples;
+
+void ProfilePhase::record(const double & seconds) {
+	minimum = (calls == 0) ? seconds : min(minimum,seconds);
+	maximum = (calls == 0) ? seconds : max(maximum,seconds);
+	calls++;
+	sum += seconds;
+	if ((int) samples.size() < maxSamples) {
+		samples.push_back(seconds);
+		return;
+	}
+	// Keep each of the calls so far with the same probability
+	uniform_int_distribution<long long> pick(0,calls - 1);
+	long long replaced = pick(generator);
+	if (replaced < maxSamples) {
+		samples[replaced] = seconds;
+	}
+}
+
+void ProfilePhase::merge(const ProfilePhase & other) {
+	if (other.calls == 0) {
+		return;
+	}
+	if (calls == 0) {
+		*this = other;
+		return;
+	}
+	// Take from each sample in proportion to the calls it stands for if
+	// both of them don't fit.
+	int numSamples = samples.size(), numOther = other.samples.size();
+	if (numSamples + numOther > maxSamples) {
+		long long allCalls = calls + other.calls;
+		int fromThis = (int) llround((double) maxSamples*calls/allCalls);
+		fromThis = min(max(fromThis,maxSamples - numOther),numSamples);
+		int fromOther = min(maxSamples - fromThis,numOther);
+		vector<double> otherSamples(other.samples);
+		shuffle(samples.begin(),samples.end(),generator);
+		shuffle(otherSamples.begin(),otherSamples.end(),generator);
+		samples.resize(fromThis);
+		samples.insert(samples.end(),otherSamples.begin(),
+				otherSamples.begin() + fromOther);
+	} else {
+		samples.insert(samples.end(),other.samples.begin(),
+				other.samples.end());
+	}
+	minimum = min(minimum,other.minimum);
+	maximum = max(maximum,other.maximum);
+	calls += other.calls;
+	sum += other.sum;
+}
+
+double ProfilePhase::total() const {
+	return sum;
+}
+
+double ProfilePhase::percentile(const double & percent) const {
+	if (calls == 0) {
+		return 0.0;
+	} else if (percent <= 0.0) {
+		return minimum;
+	} else if (percent >= 100.0) {
+		return maximum;
+	}
+	// Nearest rank: the smallest sample with at least percent of the samples
+	// at or below it
+	vector<double> sorted(samples);
+	int rank = (int) ceil(percent/100.0*sorted.size());
+	rank = min(max(rank,1),(int) sorted.size());
+	nth_element(sorted.begin(), sorted.begin() + rank - 1, sorted.end());
+	return sorted[rank - 1];
+}
+
+bool Profiler::enabled() {
+#ifdef KELVIN_PROFILE
+	return true;
+#else
+	return false;
+#endif
+}
+
+Profiler::Accumulator & Profiler::accumulator() {
+	thread_local Accumulator threadAccumulator;
+	return threadAccumulator;
+}
+
+int Profiler::phaseId(const std::string & name) {
+	lock_guard<mutex> lock(_mutex);
+	auto phase = _phaseIds.find(name);
+	if (phase != _phaseIds.end()) {
+		return phase->second;
+	}
+	int id = _phaseIds.size();
+	_phaseIds[name] = id;
+	return id;
+}
+
+int Profiler::counterId(const std::string & name) {
+	lock_guard<mutex> lock(_mutex);
+	auto counter = _counterIds.find(name);
+	if (counter != _counterIds.end()) {
+		return counter->second;
+	}
+	int id = _counterIds.size();
+	_counterIds[name] = id;
+	return id;
+}
+
+void Profiler::record(const int & id, const double & seconds) {
+	auto & threadRecords = accumulator();
+	lock_guard<mutex> lock(threadRecords.mutex);
+	if ((int) threadRecords.phases.size() <= id) {
+		threadRecords.phases.resize(id + 1);
+	}
+	threadRecords.phases[id].record(seconds);
+}
+
+void Profiler::record(const std::string & name, const double & seconds) {
+	record(phaseId(name),seconds);
+}
+
+void Profiler::count(const int & id, const long long & value) {
+	auto & threadRecords = accumulator();
+	lock_guard<mutex> lock(threadRecords.mutex);
+	if ((int) threadRecords.counters.size() <= id) {
+		threadRecords.counters.resize(id + 1,0);
+	}
+	threadRecords.counters[id] += value;
+}
+
+void Profiler::count(const std::string & name, const long long & value) {
+	count(counterId(name),value);
+}
+
+ProfilePhase Profiler::mergedPhase(const int & id) {
+	ProfilePhase phase;
+	if ((int) _retiredPhases.size() > id) {
+		phase.merge(_retiredPhases[id]);
+	}
+	for (auto threadRecords : _accumulators) {
+		lock_guard<mutex> lock(threadRecords->mutex);
+		if ((int) threadRecords->phases.size() > id) {
+			phase.merge(threadRecords->phases[id]);
+		}
+	}
+	return phase;
+}
+
+long long Profiler::mergedCounter(const int & id) {
+	long long value = 0;
+	if ((int) _retiredCounters.size() > id) {
+		value += _retiredCounters[id];
+	}
+	for (auto threadRecords : _accumulators) {
+		lock_guard<mutex> lock(threadRecords->mutex);
+		if ((int) threadRecords->counters.size() > id) {
+			value += threadRecords->counters[id];
+		}
+	}
+	return value;
+}
+
+ProfilePhase Profiler::phase(const std::string & name) {
+	lock_guard<mutex> lock(_mutex);
+	auto id = _phaseIds.find(name);
+	if (id == _phaseIds.end()) {
+		throw "Unknown profile phase.";
+	}
+	auto phase = mergedPhase(id->second);
+	if (phase.calls == 0) {
+		throw "Unknown profile phase.";
+	}
+	return phase;
+}
+
+long long Profiler::counter(const std::string & name) {
+	lock_guard<mutex> lock(_mutex);
+	auto id = _counterIds.find(name);
+	return id == _counterIds.end() ? 0 : mergedCounter(id->second);
+}
+
+void Profiler::reset() {
+	lock_guard<mutex> lock(_mutex);
+	_retiredPhases.clear();
+	_retiredCounters.clear();
+	for (auto threadRecords : _accumulators) {
+		lock_guard<mutex> threadLock(threadRecords->mutex);
+		threadRecords->phases.clear();
+		threadRecords->counters.clear();
+	}
+}
+
+void Profiler::writeReport(const std::string & filename) {
+
+	ofstream report(filename);
+	if (!report) {
+		throw "Unable to open the profile report file.";
+	}
+
+	lock_guard<mutex> lock(_mutex);
+	char value[32];
+	// Doubles are written with %.9g, which is valid JSON for finite values
+	auto number = [&value](const double & x) {
+		snprintf(value, sizeof(value), "%.9g", x);
+		return string(value);
+	};
+	report << "{\n";
+	report << "  \"threads\": " << maxThreads() << ",\n";
+	report << "  \"phases\": {";
+	bool first = true;
+	for (auto & entry : _phaseIds) {
+		auto phase = mergedPhase(entry.second);
+		long long calls = phase.calls;
+		if (calls == 0) {
+			continue;
+		}
+		double total = phase.total();
+		report << (first ? "\n" : ",\n");
+		report << "    \"" << entry.first << "\": {"
+				<< "\"calls\": " << calls
+				<< ", \"total\": " << number(total)
+				<< ", \"mean\": " << number(calls ? total/calls : 0.0)
+				<< ", \"min\": " << number(phase.percentile(0.0))
+				<< ", \"p50\": " << number(phase.percentile(50.0))
+				<< ", \"p90\": " << number(phase.percentile(90.0))
+				<< ", \"p99\": " << number(phase.percentile(99.0))
+				<< ", \"max\": " << number(phase.percentile(100.0)) << "}";
+		first = false;
+	}
+	report << (first ? "},\n" : "\n  },\n");
+	report << "  \"counters\": {";
+	first = true;
+	for (auto & entry : _counterIds) {
+		long long value = mergedCounter(entry.second);
+		if (value == 0) {
+			continue;
+		}
+		report << (first ? "\n" : ",\n");
+		report << "    \"" << entry.first << "\": " << value;
+		first = false;
+	}
+	report << (first ? "}\n" : "\n  }\n");
+	report << "}\n";
+
+	report.close();
+	if (!report) {
+		throw "Unable to write the profile report file.";
+	}
+
+	return;
+}
+
+} /* namespace Kelvin */
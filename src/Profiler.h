@@ -0,0 +1,354 @@
+/**----------------------------------------------------------------------------
+ Copyright  2018-, UT-Battelle, LLC
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ Author(s): Jay Jay Billings (billingsjj <at> ornl <dot> gov)
+ -----------------------------------------------------------------------------*/
+#ifndef SRC_PROFILER_H_
+#define SRC_PROFILER_H_
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace Kelvin {
+
+/**
+ * This is the record of one timed phase: the number of calls, their total,
+ * minimum and maximum durations in seconds, and a uniform sample of the
+ * durations for the percentiles. The sample holds every duration until there
+ * are maxSamples of them, after which each new duration replaces a random
+ * one (reservoir sampling), so the memory of a phase is bounded however long
+ * the run is.
+ */
+struct ProfilePhase {
+
+	/**
+	 * The largest number of durations that are kept for the percentiles
+	 */
+	static const int maxSamples = 4096;
+
+	/**
+	 * The number of calls
+	 */
+	long long calls = 0;
+
+	/**
+	 * The sum of the durations
+	 */
+	double sum = 0.0;
+
+	/**
+	 * The shortest duration
+	 */
+	double minimum = 0.0;
+
+	/**
+	 * The longest duration
+	 */
+	double maximum = 0.0;
+
+	/**
+	 * A uniform sample of the durations, which is all of them if there were
+	 * no more than maxSamples calls
+	 */
+	std::vector<double> samples;
+
+	/**
+	 * The generator that picks the samples that are replaced
+	 */
+	std::minstd_rand generator;
+
+	/**
+	 * This operation adds the duration of one call.
+	 * @param seconds the duration in seconds
+	 */
+	void record(const double & seconds);
+
+	/**
+	 * This operation adds the calls of another record of the same phase,
+	 * such as one from another thread.
+	 * @param other the other record
+	 */
+	void merge(const ProfilePhase & other);
+
+	/**
+	 * This operation returns the sum of the durations.
+	 */
+	double total() const;
+
+	/**
+	 * This operation returns a percentile of the durations using the nearest
+	 * rank of the sample, so 50 is the median. 0 and 100 are the exact
+	 * minimum and maximum.
+	 * @param percent the percentile, from 0 to 100
+	 * @return the duration, or zero if there were no calls
+	 */
+	double percentile(const double & percent) const;
+
+};
+
+/**
+ * This is a global registry of timed phases and counters for finding where
+ * the time of a run goes. Phases are timed with KELVIN_PROFILE_SCOPE(name),
+ * which times the rest of the enclosing scope, and counters are added to with
+ * KELVIN_PROFILE_COUNT(name,value):
+ * @code
+ * {
+ *     KELVIN_PROFILE_SCOPE("particleToGrid");
+ *     KELVIN_PROFILE_COUNT("massiveNodes",nodeSet.size());
+ *     ...
+ * }
+ * @endcode
+ * Both macros compile to nothing unless Kelvin is built with KELVIN_PROFILE
+ * defined, which the KELVIN_ENABLE_PROFILING CMake option does. The report
+ * is written with writeReport() as JSON with the call count, total, mean,
+ * minimum, maximum and 50th, 90th and 99th percentile durations of every
+ * phase, in seconds, and the value of every counter that is not zero.
+ *
+ * Names are interned once: the macros look up the id of their name the
+ * first time they run and keep it in a static, and recording by id only
+ * touches the accumulators of the calling thread, which are merged when the
+ * phases and counters are read. Recording is safe anywhere, but timers in
+ * parallel regions measure each thread separately, so phases should be
+ * timed outside of them.
+ */
+class Profiler {
+private:
+
+	/**
+	 * The phases and counters recorded by one thread
+	 */
+	struct Accumulator;
+
+	/**
+	 * The ids of the phases by name
+	 */
+	static std::map<std::string,int> _phaseIds;
+
+	/**
+	 * The ids of the counters by name
+	 */
+	static std::map<std::string,int> _counterIds;
+
+	/**
+	 * The accumulators of the threads that are running
+	 */
+	static std::vector<Accumulator *> _accumulators;
+
+	/**
+	 * The phases recorded by threads that have finished, by id
+	 */
+	static std::vector<ProfilePhase> _retiredPhases;
+
+	/**
+	 * The counters added to by threads that have finished, by id
+	 */
+	static std::vector<long long> _retiredCounters;
+
+	/**
+	 * The lock for the names, the list of accumulators and the retired
+	 * records. It is not taken to record.
+	 */
+	static std::mutex _mutex;
+
+	/**
+	 * This operation returns the accumulator of the calling thread, creating
+	 * it if this is the first time the thread records.
+	 */
+	static Accumulator & accumulator();
+
+	/**
+	 * This operation merges the records of a phase from every thread. The
+	 * lock must be held.
+	 * @param id the id of the phase
+	 * @return the merged record
+	 */
+	static ProfilePhase mergedPhase(const int & id);
+
+	/**
+	 * This operation sums a counter over every thread. The lock must be
+	 * held.
+	 * @param id the id of the counter
+	 * @return the sum
+	 */
+	static long long mergedCounter(const int & id);
+
+public:
+
+	/**
+	 * This operation returns true if Kelvin was built with profiling.
+	 */
+	static bool enabled();
+
+	/**
+	 * This operation returns the id of a phase, creating it if the name is
+	 * new. Ids stay valid across reset().
+	 * @param name the name of the phase
+	 * @return the id
+	 */
+	static int phaseId(const std::string & name);
+
+	/**
+	 * This operation returns the id of a counter, creating it if the name is
+	 * new. Ids stay valid across reset().
+	 * @param name the name of the counter
+	 * @return the id
+	 */
+	static int counterId(const std::string & name);
+
+	/**
+	 * This operation adds the duration of one call to a phase.
+	 * @param id the id of the phase from phaseId()
+	 * @param seconds the duration in seconds
+	 */
+	static void record(const int & id, const double & seconds);
+
+	/**
+	 * The same as record(const int &, const double &), but the phase is
+	 * looked up by name.
+	 * @param name the name of the phase
+	 * @param seconds the duration in seconds
+	 */
+	static void record(const std::string & name, const double & seconds);
+
+	/**
+	 * This operation adds to a counter.
+	 * @param id the id of the counter from counterId()
+	 * @param value the amount to add
+	 */
+	static void count(const int & id, const long long & value);
+
+	/**
+	 * The same as count(const int &, const long long &), but the counter is
+	 * looked up by name.
+	 * @param name the name of the counter
+	 * @param value the amount to add
+	 */
+	static void count(const std::string & name, const long long & value);
+
+	/**
+	 * This operation returns a phase merged over all threads. It throws an
+	 * exception if the phase was not recorded since the last reset.
+	 * @param name the name of the phase
+	 * @return the phase
+	 */
+	static ProfilePhase phase(const std::string & name);
+
+	/**
+	 * This operation returns the value of a counter summed over all threads,
+	 * or zero if it was never counted.
+	 * @param name the name of the counter
+	 * @return the value
+	 */
+	static long long counter(const std::string & name);
+
+	/**
+	 * This operation clears all phases and counters. Their ids are kept.
+	 */
+	static void reset();
+
+	/**
+	 * This operation writes the phases and counters as JSON.
+	 * @param filename the name of the report file
+	 */
+	static void writeReport(const std::string & filename);
+
+};
+
+/**
+ * This class records the time from its construction to its destruction as
+ * one call of a phase in the Profiler.
+ */
+class ScopedTimer {
+private:
+
+	/**
+	 * The id of the phase
+	 */
+	int _phase;
+
+	/**
+	 * The time that the timer was created
+	 */
+	std::chrono::steady_clock::time_point _start;
+
+public:
+
+	/**
+	 * Constructor. Starts the timer.
+	 * @param phase the id of the phase from Profiler::phaseId()
+	 */
+	ScopedTimer(const int & phase) : _phase(phase),
+			_start(std::chrono::steady_clock::now()) {};
+
+	/**
+	 * Constructor. Looks up the phase by name and starts the timer.
+	 * @param name the name of the phase
+	 */
+	ScopedTimer(const char * name) : ScopedTimer(Profiler::phaseId(name)) {};
+
+	/**
+	 * Destructor. Records the time since construction.
+	 */
+	~ScopedTimer() {
+		std::chrono::duration<double> elapsed =
+				std::chrono::steady_clock::now() - _start;
+		Profiler::record(_phase, elapsed.count());
+	};
+
+	ScopedTimer(const ScopedTimer &) = delete;
+	ScopedTimer & operator=(const ScopedTimer &) = delete;
+
+};
+
+} /* namespace Kelvin */
+
+#define KELVIN_PROFILE_CONCAT_(a,b) a##b
+#define KELVIN_PROFILE_CONCAT(a,b) KELVIN_PROFILE_CONCAT_(a,b)
+
+#ifdef KELVIN_PROFILE
+#define KELVIN_PROFILE_SCOPE(name) \
+	static const int KELVIN_PROFILE_CONCAT(kelvinPhase,__LINE__) = \
+			Kelvin::Profiler::phaseId(name); \
+	Kelvin::ScopedTimer KELVIN_PROFILE_CONCAT(kelvinTimer,__LINE__)( \
+			KELVIN_PROFILE_CONCAT(kelvinPhase,__LINE__))
+#define KELVIN_PROFILE_COUNT(name,value) \
+	do { \
+		static const int kelvinCounter = Kelvin::Profiler::counterId(name); \
+		Kelvin::Profiler::count(kelvinCounter,value); \
+	} while (0)
+#else
+#define KELVIN_PROFILE_SCOPE(name)
+#define KELVIN_PROFILE_COUNT(name,value)
+#endif
+
+#endif /* SRC_PROFILER_H_ */
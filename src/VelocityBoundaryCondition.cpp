@@ -0,0 +1,160 @@
+/**----------------------------------------------------------------------------
+ Copyright  2018-, UT-Battelle, LLC
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ Author(s): Jay Jay Billings (billingsjj <at> ornl <dot> gov)
+ -----------------------------------------------------------------------------*/
+#include <VelocityBoundaryCondition.h>
+#include <cmath>
+#include <sstream>
+
+namespace Kelvin {
+
+VelocityBoundaryCondition::VelocityBoundaryCondition(const std::string & side,
+		const std::string & description, const int & dim) : side(side),
+				dim(dim) {
+
+	// The first word is the type and anything after it are its values
+	std::istringstream stream(description);
+	std::string typeName;
+	stream >> typeName;
+	if (typeName == "noSlip") {
+		type = VelocityBoundaryType::NO_SLIP;
+	} else if (typeName == "freeSlip") {
+		type = VelocityBoundaryType::FREE_SLIP;
+	} else if (typeName == "fixed") {
+		type = VelocityBoundaryType::FIXED;
+		double value;
+		while (stream >> value) {
+			velocity.push_back(value);
+		}
+		// A fixed condition without values holds the boundary still
+		if (velocity.empty()) {
+			velocity.assign(dim,0.0);
+		}
+		if (!stream.eof() || (int) velocity.size() != dim) {
+			throw "Fixed velocity boundary conditions need one velocity component per dimension.";
+		}
+	} else {
+		throw "Unknown velocity boundary condition. Use noSlip, freeSlip or fixed.";
+	}
+
+}
+
+void VelocityBoundaryCondition::setNodes(const std::vector<int> & nodeIds,
+		const std::vector<double> & normals) {
+
+	this->nodeIds = nodeIds;
+	this->normals.clear();
+	if (type != VelocityBoundaryType::FREE_SLIP) {
+		return;
+	}
+
+	if (normals.size() != nodeIds.size()*dim) {
+		throw "Free slip boundary conditions need a normal for every node.";
+	}
+	// Normalize the normals so that the projections are exact
+	this->normals = normals;
+	int numNodes = nodeIds.size();
+	for (int k = 0; k < numNodes; k++) {
+		double * normal = &this->normals[k*dim];
+		double norm = 0.0;
+		for (int j = 0; j < dim; j++) {
+			norm += normal[j]*normal[j];
+		}
+		norm = std::sqrt(norm);
+		if (norm == 0.0) {
+			throw "Free slip boundary conditions need non-zero normals.";
+		}
+		for (int j = 0; j < dim; j++) {
+			normal[j] /= norm;
+		}
+	}
+
+}
+
+const std::string & VelocityBoundaryCondition::getSide() const {
+	return side;
+}
+
+VelocityBoundaryType VelocityBoundaryCondition::getType() const {
+	return type;
+}
+
+const std::vector<int> & VelocityBoundaryCondition::getNodeIds() const {
+	return nodeIds;
+}
+
+const std::vector<double> & VelocityBoundaryCondition::getVelocity() const {
+	return velocity;
+}
+
+void VelocityBoundaryCondition::apply(NodeBlocks & nodes) const {
+
+	int numNodes = nodeIds.size();
+	for (int k = 0; k < numNodes; k++) {
+		int nodeId = nodeIds[k];
+		if (!nodes.contains(nodeId)) {
+			continue;
+		}
+		double * vel = nodes.velocity(nodeId);
+		double * acc = nodes.acceleration(nodeId);
+		switch (type) {
+		case VelocityBoundaryType::NO_SLIP:
+			for (int j = 0; j < dim; j++) {
+				vel[j] = 0.0;
+				acc[j] = 0.0;
+			}
+			break;
+		case VelocityBoundaryType::FREE_SLIP: {
+			// Remove the normal components: v = v - (v.n)n
+			const double * normal = &normals[k*dim];
+			double normalVel = 0.0, normalAcc = 0.0;
+			for (int j = 0; j < dim; j++) {
+				normalVel += vel[j]*normal[j];
+				normalAcc += acc[j]*normal[j];
+			}
+			for (int j = 0; j < dim; j++) {
+				vel[j] -= normalVel*normal[j];
+				acc[j] -= normalAcc*normal[j];
+			}
+			break;
+		}
+		case VelocityBoundaryType::FIXED:
+			for (int j = 0; j < dim; j++) {
+				vel[j] = velocity[j];
+				acc[j] = 0.0;
+			}
+			break;
+		}
+	}
+
+	return;
+}
+
+} /* namespace Kelvin */
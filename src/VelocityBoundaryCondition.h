@@ -0,0 +1,157 @@
+/**----------------------------------------------------------------------------
+ Copyright  2018-, UT-Battelle, LLC
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ Author(s): Jay Jay Billings (billingsjj <at> ornl <dot> gov)
+ -----------------------------------------------------------------------------*/
+#ifndef SRC_VELOCITYBOUNDARYCONDITION_H_
+#define SRC_VELOCITYBOUNDARYCONDITION_H_
+
+#include <NodeBlocks.h>
+#include <string>
+#include <vector>
+
+namespace Kelvin {
+
+/**
+ * The types of velocity boundary conditions that can be imposed on the grid.
+ *
+ * NO_SLIP - the velocity and acceleration are zero.
+ * FREE_SLIP - the components of the velocity and acceleration normal to the
+ * boundary are zero, the tangential components are free.
+ * FIXED - the velocity is set to a fixed value and the acceleration is zero.
+ */
+enum class VelocityBoundaryType {
+	FREE_SLIP, NO_SLIP, FIXED
+};
+
+/**
+ * This class imposes a velocity boundary condition on a list of grid nodes
+ * that is computed once, so that applying it only touches the nodes on the
+ * boundary.
+ *
+ * Conditions are described by a side and a string. The side is a name for
+ * the part of the boundary, such as a boundary attribute of the mesh, and
+ * the string is one of "noSlip", "freeSlip" or "fixed" followed by one
+ * velocity component per dimension, such as "fixed 0.0 -1.0e-3".
+ */
+class VelocityBoundaryCondition {
+protected:
+
+	/**
+	 * The side of the boundary where the condition is imposed.
+	 */
+	std::string side;
+
+	/**
+	 * The type of the condition.
+	 */
+	VelocityBoundaryType type;
+
+	/**
+	 * The dimension of the grid.
+	 */
+	int dim;
+
+	/**
+	 * The fixed velocity. Only used by FIXED conditions.
+	 */
+	std::vector<double> velocity;
+
+	/**
+	 * The ids of the grid nodes on the boundary.
+	 */
+	std::vector<int> nodeIds;
+
+	/**
+	 * The unit normals of the boundary at the nodes, stored node-major with
+	 * dim entries per node in the same order as nodeIds. Only used by
+	 * FREE_SLIP conditions.
+	 */
+	std::vector<double> normals;
+
+public:
+
+	/**
+	 * Constructor
+	 * @param side the side of the boundary where the condition is imposed
+	 * @param description the type of the condition and its values, if any
+	 * @param dim the dimension of the grid
+	 */
+	VelocityBoundaryCondition(const std::string & side,
+			const std::string & description, const int & dim);
+
+	/**
+	 * This operation sets the nodes on which the condition is imposed.
+	 * @param nodeIds the ids of the nodes on the boundary
+	 * @param normals the normals of the boundary at the nodes, node-major
+	 * with dim entries per node. They are normalized here. They may be
+	 * empty unless the condition is a FREE_SLIP condition.
+	 */
+	void setNodes(const std::vector<int> & nodeIds,
+			const std::vector<double> & normals);
+
+	/**
+	 * This operation returns the side of the boundary.
+	 * @return the side
+	 */
+	const std::string & getSide() const;
+
+	/**
+	 * This operation returns the type of the condition.
+	 * @return the type
+	 */
+	VelocityBoundaryType getType() const;
+
+	/**
+	 * This operation returns the ids of the nodes on which the condition is
+	 * imposed.
+	 * @return the node ids
+	 */
+	const std::vector<int> & getNodeIds() const;
+
+	/**
+	 * This operation returns the fixed velocity of a FIXED condition.
+	 * @return the velocity, with dim components, or an empty vector for other
+	 * conditions
+	 */
+	const std::vector<double> & getVelocity() const;
+
+	/**
+	 * This operation imposes the condition on the velocities and
+	 * accelerations of the boundary nodes. Nodes that are not stored in the
+	 * blocks are far from any particles and are skipped.
+	 * @param nodes the state of the grid nodes
+	 */
+	void apply(NodeBlocks & nodes) const;
+
+};
+
+} /* namespace Kelvin */
+
+#endif /* SRC_VELOCITYBOUNDARYCONDITION_H_ */
@@ -0,0 +1,221 @@
+/**----------------------------------------------------------------------------
+ Copyright  2018-, UT-Battelle, LLC
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ Author(s): Jay Jay Billings (billingsjj <at> ornl <dot> gov)
+ -----------------------------------------------------------------------------*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+#include <mfem.hpp>
+#include <MeshContainer.h>
+#include <H1FESpaceFactory.h>
+#include <Grid.h>
+#include <DelimitedTextParser.h>
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <vector>
+#include <set>
+
+using namespace Kelvin;
+using namespace mfem;
+using namespace std;
+
+/**
+ * This is the original node-major computation of the internal forces from
+ * Grid, which loops over every massive node and then over every particle. It
+ * is kept here as a reference for timing and correctness comparisons against
+ * the particle-major scatter in Grid::internalForces().
+ * @param grid the assembled grid that provides the stencils and node set
+ * @param particles the particles used to assemble the grid
+ * @param forces the output forces, ordered by the massive node set
+ */
+void nodeMajorInternalForces(Grid & grid,
+		const ParticleSet & particles,
+		vector<ForceVector> & forces) {
+
+	int dim = grid.dimension();
+	auto & stencils = grid.stencils();
+	auto & nodeSet = grid.massiveNodeSet();
+	int numParticles = particles.size();
+	forces.assign(nodeSet.size(),ForceVector(dim));
+	int i = 0;
+	for (auto nodeIt = nodeSet.begin(); nodeIt != nodeSet.end(); nodeIt++) {
+		auto & forceVector = forces[i];
+		forceVector.nodeId = *nodeIt;
+		for (int j = 0; j < numParticles; j++) {
+			const double * stress = particles.stress(j);
+			auto & stencil = stencils[j];
+			for (int k = 0; k < stencil.numNodes; k++) {
+				if (stencil.nodeIds[k] == *nodeIt) {
+					auto & grad = stencil.gradients[k];
+					for (int l = 0; l < dim; l++) {
+						for (int m = 0; m < dim; m++) {
+							forceVector.values[l] -= particles.mass(j)
+									* grad[m] * stress[m*dim+l];
+						}
+					}
+				}
+			}
+		}
+		i++;
+	}
+
+	return;
+}
+
+/**
+ * This operation loads the first dim columns of a particle file into a list
+ * of material points with unit mass and a simple, non-zero stress tensor.
+ * @param particleFilename the name of the CSV particle file
+ * @param dim the dimension of the background mesh
+ * @return the material points
+ */
+vector<MaterialPoint> loadParticles(const char * particleFilename,
+		const int & dim) {
+
+	fire::DelimitedTextParser<vector<vector<double>>,double> parser(",","#");
+	parser.setSource(particleFilename);
+	parser.parse();
+	auto data = parser.getData();
+
+	vector<MaterialPoint> particles;
+	particles.reserve(data->size());
+	for (int i = 0; i < data->size(); i++) {
+		auto & rawData = data->at(i);
+		MaterialPoint point(dim);
+		for (int j = 0; j < dim; j++) {
+			point.pos[j] = rawData[j];
+			for (int k = 0; k < dim; k++) {
+				point.stress[j][k] = (j == k) ? 1.0 : 0.5;
+			}
+		}
+		point.mass = 1.0;
+		particles.push_back(point);
+	}
+
+	return particles;
+}
+
+/**
+ * Main program
+ * @param argc the number of input arguments
+ * @param argv the input arguments array of argc elements
+ * @return EXIT_SUCCESS if successful, otherwise another value.
+ */
+int main(int argc, char * argv[]) {
+
+	const char *meshFilename = "background.vtk";
+	const char *particleFilename = "particles.csv";
+	int maxReferenceParticles = 20000;
+	int numRepeats = 3;
+
+	// Create the default command line arguments
+	OptionsParser args(argc, argv);
+	args.AddOption(&meshFilename, "-m", "--mesh",
+			"Background mesh file, such as data/3DCantilever/background.vtk.");
+	args.AddOption(&particleFilename, "-p", "--particle-set",
+			"Particle file, such as data/3DCantilever/particles.csv.");
+	args.AddOption(&maxReferenceParticles, "-r", "--max-reference-particles",
+			"Largest particle count for which the node-major reference is run.");
+	args.AddOption(&numRepeats, "-n", "--repeats",
+			"Number of timed repetitions per measurement.");
+	args.Parse();
+	if (!args.Good()) {
+		args.PrintUsage(cout);
+		return EXIT_FAILURE;
+	}
+
+	// Load the mesh and particles
+	H1FESpaceFactory spaceFactory;
+	MeshContainer meshContainer(meshFilename, 1, spaceFactory);
+	int dim = meshContainer.dimension();
+	auto allParticles = loadParticles(particleFilename, dim);
+	int totalParticles = allParticles.size();
+	cout << "Loaded " << totalParticles << " particles and "
+			<< meshContainer.getMesh().GetNV() << " nodes." << endl;
+
+	// Time both versions for an increasing number of particles. The
+	// particle-major scatter should scale linearly with the particle count
+	// while the node-major reference scales with nodes x particles.
+	cout << "particles, massive nodes, scatter (s), reference (s), "
+			<< "max |difference|" << endl;
+	vector<int> particleCounts;
+	for (int i = 16; i > 1; i /= 2) {
+		if (totalParticles/i > 0) particleCounts.push_back(totalParticles/i);
+	}
+	particleCounts.push_back(totalParticles);
+	for (int numParticles : particleCounts) {
+		ParticleSet particles(dim);
+		particles.reserve(numParticles);
+		for (int i = 0; i < numParticles; i++) {
+			particles.push_back(allParticles[i]);
+		}
+		Grid grid(meshContainer);
+		grid.assemble(particles);
+
+		// Time the particle-major scatter
+		auto start = chrono::steady_clock::now();
+		for (int i = 0; i < numRepeats; i++) {
+			grid.internalForces(particles);
+		}
+		chrono::duration<double> scatterTime = chrono::steady_clock::now()
+				- start;
+		auto & forces = grid.internalForces(particles);
+
+		// Time the node-major reference if it is affordable
+		double referenceTime = -1.0, maxDiff = 0.0;
+		if (numParticles <= maxReferenceParticles) {
+			vector<ForceVector> refForces;
+			start = chrono::steady_clock::now();
+			for (int i = 0; i < numRepeats; i++) {
+				nodeMajorInternalForces(grid, particles, refForces);
+			}
+			chrono::duration<double> refTime = chrono::steady_clock::now()
+					- start;
+			referenceTime = refTime.count()/numRepeats;
+			for (int i = 0; i < forces.size(); i++) {
+				for (int j = 0; j < dim; j++) {
+					maxDiff = max(maxDiff,abs(forces[i].values[j]
+							- refForces[i].values[j]));
+				}
+			}
+		}
+
+		cout << numParticles << ", " << forces.size() << ", "
+				<< scatterTime.count()/numRepeats << ", ";
+		if (referenceTime < 0.0) {
+			cout << "skipped, -" << endl;
+		} else {
+			cout << referenceTime << ", " << maxDiff << endl;
+		}
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,93 @@
+/**----------------------------------------------------------------------------
+ Copyright  2018-, UT-Battelle, LLC
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ Author(s): Jay Jay Billings (billingsjj <at> ornl <dot> gov)
+ -----------------------------------------------------------------------------*/
+#include <stdlib.h>
+#include <string>
+#include <iostream>
+#include <mfem.hpp>
+#include <ParticleSet.h>
+#include <ParticleFile.h>
+
+using namespace Kelvin;
+using namespace mfem;
+using namespace std;
+
+/**
+ * This program converts particle files between the CSV format and Kelvin's
+ * binary particle format. The format of the input file is detected, so a
+ * binary input file is written as CSV and a CSV input file is written as
+ * binary.
+ * @param argc the number of input arguments
+ * @param argv the input arguments array of argc elements
+ * @return EXIT_SUCCESS if successful, otherwise another value.
+ */
+int main(int argc, char * argv[]) {
+
+	const char *inputFilename = "particles.csv";
+	const char *outputFilename = "particles.bin";
+	int dim = 3;
+
+	// Create the default command line arguments
+	OptionsParser args(argc, argv);
+	args.AddOption(&inputFilename, "-i", "--input",
+			"Particle file to convert, either CSV or binary.");
+	args.AddOption(&outputFilename, "-o", "--output",
+			"Name of the converted particle file.");
+	args.AddOption(&dim, "-d", "--dimension",
+			"Number of coordinates per particle in the CSV input file.");
+
+	// Parse the arguments and do a cursory check.
+	args.Parse();
+	if (!args.Good()) {
+		args.PrintUsage(cout);
+		return EXIT_FAILURE;
+	}
+
+	try {
+		ParticleSet particles;
+		if (ParticleFile::isBinary(inputFilename)) {
+			// Binary files know their dimension
+			dim = ParticleFile::binaryDimension(inputFilename);
+			ParticleFile::readBinary(inputFilename, dim, particles);
+			ParticleFile::writeCSV(outputFilename, particles);
+		} else {
+			ParticleFile::readCSV(inputFilename, dim, particles);
+			ParticleFile::writeBinary(outputFilename, particles);
+		}
+		cout << "Converted " << particles.size() << " particles from "
+				<< inputFilename << " to " << outputFilename << endl;
+	} catch (const char * error) {
+		cout << error << endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -41,6 +41,8 @@
 #include <math.h>
 #include <vector>
 #include <Point.h>
+#include <ParticleSet.h>
+#include <ParticleFile.h>
 
 using namespace Kelvin;
 using namespace mfem;
@@ -350,6 +352,31 @@ void writeParticles(vector<Kelvin::Point> points, const char * particleFilename,
 	return;
 }
 
+/**
+ * This function writes the particles in Kelvin's binary particle format,
+ * which Kelvin loads without parsing.
+ *
+ * @param points a vector of the particles positions
+ * @param particleFilename the name of the output file container particle info.
+ * @param matId the material id of the particles
+ */
+void writeBinaryParticles(vector<Kelvin::Point> & points,
+		const char * particleFilename, const int & matId) {
+
+	int dim = points[0].dimension();
+	int size = points.size();
+	ParticleSet particles(dim,size);
+	for (int i = 0; i < size; i++) {
+		for (int j = 0; j < dim; j++) {
+			particles.pos(i)[j] = points[i].pos[j];
+		}
+		particles.materialId(i) = matId;
+	}
+	ParticleFile::writeBinary(particleFilename,particles);
+
+	return;
+}
+
 /**
  * Main program
  * @param argc the number of input arguments
@@ -365,6 +392,7 @@ int main(int argc, char * argv[]) {
 	int order = 1;
 	double coarsenFactor = 1.0;
 	double zShift = 1.0;
+	bool binary = false;
 
 	// Create the default command line arguments
 	OptionsParser args(argc, argv);
@@ -383,6 +411,8 @@ int main(int argc, char * argv[]) {
 			"Value of the material id that should be set by this program.");
 	args.AddOption(&zShift, "-z", "--zShift",
 			"PMGen shifts all axes by default. This option scalse the z shift.");
+	args.AddOption(&binary, "-bin", "--binary", "-csv", "--csv",
+			"Write the particle set in Kelvin's binary format instead of CSV.");
 
 	// Parse the arguments and do a cursory check.
 	args.Parse();
@@ -412,7 +442,11 @@ int main(int argc, char * argv[]) {
 			coarsenFactor, zShift);
 
 	// Write particle list
-	writeParticles(points, particleFilename, meshFilename, matId);
+	if (binary) {
+		writeBinaryParticles(points, particleFilename, matId);
+	} else {
+		writeParticles(points, particleFilename, meshFilename, matId);
+	}
 
 	return EXIT_SUCCESS;
 }
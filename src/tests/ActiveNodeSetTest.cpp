@@ -0,0 +1,166 @@
+/**----------------------------------------------------------------------------
+ Copyright  2018-, UT-Battelle, LLC
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ Author(s): Jay Jay Billings (billingsjj <at> ornl <dot> gov)
+ -----------------------------------------------------------------------------*/
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE kelvin
+
+#include <boost/test/included/unit_test.hpp>
+#include <set>
+#include <vector>
+#include <ActiveNodeSet.h>
+
+using namespace std;
+using namespace Kelvin;
+
+/**
+ * This operation checks that nodes can be added and removed and that the
+ * compact array and slots follow them.
+ */
+BOOST_AUTO_TEST_CASE(checkInsertAndErase) {
+
+	// Use enough nodes to span several words of the bitmap
+	int numNodes = 200;
+	ActiveNodeSet nodeSet(numNodes);
+	BOOST_REQUIRE_EQUAL(numNodes,nodeSet.capacity());
+	BOOST_REQUIRE(nodeSet.empty());
+
+	// Add nodes out of order and with a duplicate
+	vector<int> ids = {130,3,64,63,199,0,64};
+	for (auto id : ids) {
+		nodeSet.insert(id);
+	}
+	// Membership is current right away, but the array is not
+	BOOST_REQUIRE(nodeSet.contains(130));
+	BOOST_REQUIRE_EQUAL(0,nodeSet.count(131));
+	BOOST_REQUIRE(!nodeSet.isCompacted());
+	nodeSet.compact();
+	BOOST_REQUIRE(nodeSet.isCompacted());
+
+	// The active nodes are sorted and their slots match their positions
+	vector<int> sortedIds = {0,3,63,64,130,199};
+	BOOST_REQUIRE_EQUAL(sortedIds.size(),nodeSet.size());
+	int slot = 0;
+	for (auto nodeId : nodeSet) {
+		BOOST_REQUIRE_EQUAL(sortedIds[slot],nodeId);
+		BOOST_REQUIRE_EQUAL(slot,nodeSet.slot(nodeId));
+		BOOST_REQUIRE_EQUAL(nodeId,nodeSet[slot]);
+		BOOST_REQUIRE_EQUAL(nodeId,nodeSet.data()[slot]);
+		slot++;
+	}
+	BOOST_REQUIRE(nodeSet.find(64) != nodeSet.end());
+	BOOST_REQUIRE_EQUAL(64,*nodeSet.find(64));
+	BOOST_REQUIRE(nodeSet.find(65) == nodeSet.end());
+	// Nodes outside of the grid are never active
+	BOOST_REQUIRE_EQUAL(-1,nodeSet.slot(-1));
+	BOOST_REQUIRE_EQUAL(-1,nodeSet.slot(numNodes));
+	BOOST_REQUIRE(!nodeSet.contains(numNodes));
+
+	// Remove some nodes and make sure that the slots shift down
+	nodeSet.erase(3);
+	nodeSet.erase(130);
+	nodeSet.compact();
+	BOOST_REQUIRE_EQUAL(4,nodeSet.size());
+	BOOST_REQUIRE_EQUAL(-1,nodeSet.slot(3));
+	BOOST_REQUIRE_EQUAL(-1,nodeSet.slot(130));
+	BOOST_REQUIRE_EQUAL(1,nodeSet.slot(63));
+	BOOST_REQUIRE_EQUAL(3,nodeSet.slot(199));
+
+	// Clearing removes everything
+	nodeSet.clear();
+	nodeSet.compact();
+	BOOST_REQUIRE(nodeSet.empty());
+	BOOST_REQUIRE_EQUAL(-1,nodeSet.slot(0));
+
+	return;
+}
+
+/**
+ * This operation checks the conversion from a std::set and the comparison
+ * operators.
+ */
+BOOST_AUTO_TEST_CASE(checkAssignAndCompare) {
+
+	set<int> nodes = {5,1,70};
+	ActiveNodeSet nodeSet;
+	nodeSet.assign(nodes);
+	BOOST_REQUIRE(nodeSet.isCompacted());
+	BOOST_REQUIRE_EQUAL(71,nodeSet.capacity());
+	BOOST_REQUIRE_EQUAL(nodes.size(),nodeSet.size());
+	auto it = nodes.begin();
+	for (auto nodeId : nodeSet) {
+		BOOST_REQUIRE_EQUAL(*it,nodeId);
+		it++;
+	}
+
+	// Sets with the same nodes are equal even if their grids differ
+	ActiveNodeSet other(100);
+	other.insert(70);
+	other.insert(1);
+	other.compact();
+	BOOST_REQUIRE(nodeSet != other);
+	other.insert(5);
+	other.compact();
+	BOOST_REQUIRE(nodeSet == other);
+
+	return;
+}
+
+/**
+ * This operation checks that the storage of the set follows the active
+ * nodes instead of the size of the grid.
+ */
+BOOST_AUTO_TEST_CASE(checkLargeGrid) {
+
+	// A grid that would need gigabytes for one entry per node
+	int numNodes = 1 << 30;
+	ActiveNodeSet nodeSet(numNodes);
+	BOOST_REQUIRE_EQUAL(numNodes,nodeSet.capacity());
+	vector<int> ids = {numNodes - 1,7,1 << 20,(1 << 20) + 1};
+	for (auto id : ids) {
+		nodeSet.insert(id);
+	}
+	nodeSet.compact();
+	BOOST_REQUIRE_EQUAL(4,nodeSet.size());
+	BOOST_REQUIRE_EQUAL(0,nodeSet.slot(7));
+	BOOST_REQUIRE_EQUAL(1,nodeSet.slot(1 << 20));
+	BOOST_REQUIRE_EQUAL(2,nodeSet.slot((1 << 20) + 1));
+	BOOST_REQUIRE_EQUAL(3,nodeSet.slot(numNodes - 1));
+	BOOST_REQUIRE(!nodeSet.contains(8));
+
+	// Emptied words are dropped and the slots of the others follow
+	nodeSet.erase(7);
+	nodeSet.compact();
+	BOOST_REQUIRE_EQUAL(-1,nodeSet.slot(7));
+	BOOST_REQUIRE_EQUAL(0,nodeSet.slot(1 << 20));
+	BOOST_REQUIRE_EQUAL(2,nodeSet.slot(numNodes - 1));
+
+	return;
+}
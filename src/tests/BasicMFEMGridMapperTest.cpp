@@ -101,7 +101,7 @@ BOOST_AUTO_TEST_CASE(checkGridMapper) {
 	grid.updateNodalVelocitiesFromMomenta(mPoints);
 
 	// Compute the velocity at the grid point for time dt = 1.0
-	grid.updateNodalVelocities(1.0,mPoints);
+	grid.updateNodalVelocities(1.0);
 
 	// Create the grid mapper
 	BasicMFEMGridMapper mapper(mc.getMesh());
@@ -114,11 +114,11 @@ BOOST_AUTO_TEST_CASE(checkGridMapper) {
     			<< mPoints[i].acc[0] << " " << mPoints[i].acc[1] << endl;
     }
     // p1
-    BOOST_REQUIRE_CLOSE(3.0,mPoints[0].acc[0],1.0e-15);
-    BOOST_REQUIRE_CLOSE(3.0,mPoints[0].acc[1],1.0e-15);
+    BOOST_REQUIRE_CLOSE(2.0,mPoints[0].acc[0],1.0e-15);
+    BOOST_REQUIRE_CLOSE(2.0,mPoints[0].acc[1],1.0e-15);
     // p2
-    BOOST_REQUIRE_CLOSE(-3.0,mPoints[1].acc[0],0.0);
-    BOOST_REQUIRE_CLOSE(-3.0,mPoints[1].acc[1],1.0e-15);
+    BOOST_REQUIRE_SMALL(mPoints[1].acc[0],1.0e-15);
+    BOOST_REQUIRE_SMALL(mPoints[1].acc[1],1.0e-15);
 
     // Map grid node velocities back to particles, but store in a vector for
     // further processing
@@ -132,11 +132,11 @@ BOOST_AUTO_TEST_CASE(checkGridMapper) {
     	cout << endl;
     }
     // p1
-    BOOST_REQUIRE_CLOSE(4.0,vel[0],1.0e-15);
-    BOOST_REQUIRE_CLOSE(4.0,vel[1],1.0e-15);
+    BOOST_REQUIRE_CLOSE(3.0,vel[0],1.0e-15);
+    BOOST_REQUIRE_CLOSE(3.0,vel[1],1.0e-15);
     // p2
-    BOOST_REQUIRE_CLOSE(-2.0,vel[2],1.0e-15);
-    BOOST_REQUIRE_CLOSE(-2.0,vel[3],1.0e-15);
+    BOOST_REQUIRE_CLOSE(1.0,vel[2],1.0e-15);
+    BOOST_REQUIRE_CLOSE(1.0,vel[3],1.0e-15);
 
 	// Map grid node velocities to the particle velocities
 	cout << "----- Updated Velocities" << endl;
@@ -146,11 +146,51 @@ BOOST_AUTO_TEST_CASE(checkGridMapper) {
     			<< mPoints[i].vel[0] << " " << mPoints[i].vel[1] << endl;
     }
     // p1
-    BOOST_REQUIRE_CLOSE(4.0,mPoints[0].vel[0],1.0e-15);
-    BOOST_REQUIRE_CLOSE(4.0,mPoints[0].vel[1],1.0e-15);
+    BOOST_REQUIRE_CLOSE(3.0,mPoints[0].vel[0],1.0e-15);
+    BOOST_REQUIRE_CLOSE(3.0,mPoints[0].vel[1],1.0e-15);
     // p2
-    BOOST_REQUIRE_CLOSE(-2.0,mPoints[1].vel[0],1.0e-15);
-    BOOST_REQUIRE_CLOSE(-2.0,mPoints[1].vel[1],1.0e-15);
+    BOOST_REQUIRE_CLOSE(1.0,mPoints[1].vel[0],1.0e-15);
+    BOOST_REQUIRE_CLOSE(1.0,mPoints[1].vel[1],1.0e-15);
+
+    // Map the accelerations, velocities and velocity gradients in one pass.
+    // The grid has not changed, so the values must match the ones above.
+    cout << "----- Updated Kinematics" << endl;
+    ParticleSet particles;
+    particles.assign(mPoints);
+    std::vector<double> fusedVel(particles.size()*2);
+    std::vector<double> velGrad(particles.size()*4);
+    mapper.updateParticleKinematics(grid,particles,fusedVel,velGrad);
+    for (int i = 0; i < particles.size(); i++) {
+    	cout << particles.acc(i)[0] << " " << particles.acc(i)[1] << " | "
+    			<< fusedVel[i*2] << " " << fusedVel[i*2+1] << " | "
+				<< velGrad[i*4] << " " << velGrad[i*4+1] << " "
+				<< velGrad[i*4+2] << " " << velGrad[i*4+3] << endl;
+    }
+    // p1
+    BOOST_REQUIRE_CLOSE(2.0,particles.acc(0)[0],1.0e-15);
+    BOOST_REQUIRE_CLOSE(2.0,particles.acc(0)[1],1.0e-15);
+    BOOST_REQUIRE_CLOSE(3.0,fusedVel[0],1.0e-15);
+    BOOST_REQUIRE_CLOSE(3.0,fusedVel[1],1.0e-15);
+    // p2
+    BOOST_REQUIRE_SMALL(particles.acc(1)[0],1.0e-15);
+    BOOST_REQUIRE_SMALL(particles.acc(1)[1],1.0e-15);
+    BOOST_REQUIRE_CLOSE(1.0,fusedVel[2],1.0e-15);
+    BOOST_REQUIRE_CLOSE(1.0,fusedVel[3],1.0e-15);
+    // The velocity is the same in both directions and its gradient is the
+    // same in both elements, so dv_j/dx = -2 and dv_j/dy = -4 for each j.
+    std::vector<double> refVelGrad{-2.0,-4.0,-2.0,-4.0};
+    for (int i = 0; i < particles.size(); i++) {
+    	for (int j = 0; j < 4; j++) {
+    		BOOST_REQUIRE_CLOSE(refVelGrad[j],velGrad[i*4+j],1.0e-13);
+    	}
+    }
+
+    // The overload without gradients must give the same result
+    std::vector<double> velOnly(particles.size()*2);
+    mapper.updateParticleKinematics(grid,particles,velOnly);
+    for (int i = 0; i < velOnly.size(); i++) {
+    	BOOST_REQUIRE_CLOSE(fusedVel[i],velOnly[i],1.0e-15);
+    }
 
 	return;
 }
@@ -0,0 +1,96 @@
+/**----------------------------------------------------------------------------
+ Copyright  2018-, UT-Battelle, LLC
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ Author(s): Jay Jay Billings (billingsjj <at> ornl <dot> gov)
+ -----------------------------------------------------------------------------*/
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE kelvin
+
+#include <boost/test/included/unit_test.hpp>
+#include <map>
+#include <random>
+#include <BlockTable.h>
+
+using namespace std;
+using namespace Kelvin;
+
+/**
+ * This operation checks that keys can be added, found and removed, and that
+ * the table grows with the number of keys.
+ */
+BOOST_AUTO_TEST_CASE(checkInsertFindAndErase) {
+
+	BlockTable table;
+	BOOST_REQUIRE_EQUAL(0,table.size());
+	BOOST_REQUIRE_EQUAL(-1,table.find(0));
+
+	// Add consecutive keys, which are the common case, and some far apart
+	map<int,int> reference;
+	for (int i = 0; i < 100; i++) {
+		reference[i] = 2*i;
+		reference[1000000 + 37*i] = 2*i + 1;
+	}
+	for (auto & entry : reference) {
+		table.insert(entry.first,entry.second);
+	}
+	BOOST_REQUIRE_EQUAL(reference.size(),table.size());
+	BOOST_REQUIRE(2*table.size() <= table.capacity());
+	for (auto & entry : reference) {
+		BOOST_REQUIRE_EQUAL(entry.second,table.find(entry.first));
+	}
+	BOOST_REQUIRE_EQUAL(-1,table.find(100));
+
+	// Remove random keys and make sure the others can still be found
+	mt19937 generator(42);
+	uniform_int_distribution<int> distribution(0,1);
+	for (auto it = reference.begin(); it != reference.end(); ) {
+		if (distribution(generator)) {
+			table.erase(it->first);
+			it = reference.erase(it);
+		} else {
+			it++;
+		}
+	}
+	// Keys that are not there are ignored
+	table.erase(100);
+	BOOST_REQUIRE_EQUAL(reference.size(),table.size());
+	for (int i = 0; i < 100; i++) {
+		for (int key : {i, 1000000 + 37*i}) {
+			int value = (reference.count(key)) ? reference[key] : -1;
+			BOOST_REQUIRE_EQUAL(value,table.find(key));
+		}
+	}
+
+	// Clearing removes everything
+	table.clear();
+	BOOST_REQUIRE_EQUAL(0,table.size());
+	BOOST_REQUIRE_EQUAL(-1,table.find(1000000));
+
+	return;
+}
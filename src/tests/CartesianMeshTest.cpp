@@ -0,0 +1,223 @@
+/**----------------------------------------------------------------------------
+ Copyright  2018-, UT-Battelle, LLC
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ Author(s): Jay Jay Billings (billingsjj <at> ornl <dot> gov)
+ -----------------------------------------------------------------------------*/
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE kelvin
+
+#include <boost/test/included/unit_test.hpp>
+#include <mfem.hpp>
+#include <vector>
+#include <cmath>
+#include <MeshContainer.h>
+#include <H1FESpaceFactory.h>
+#include <ElementLocator.h>
+#include <CartesianMesh.h>
+
+using namespace std;
+using namespace mfem;
+using namespace Kelvin;
+
+// Test file names. This mesh has 4x2 unit squares.
+static std::string meshFile = "2Squares-background-unsquared.vtk";
+
+/**
+ * This operation compares the closed form location and stencils of a
+ * Cartesian mesh to the ones computed by MFEM at a set of points.
+ */
+void checkAgainstMFEM(Mesh & mesh, const CartesianMesh & cartesianMesh,
+		const FiniteElementCollection & collection,
+		const std::vector<std::vector<double>> & points) {
+
+	int dim = mesh.Dimension();
+	ElementLocator locator(mesh);
+	IsoparametricTransformation transformation;
+	for (auto & point : points) {
+		// Both must find the same element and reference coordinates
+		IntegrationPoint intPoint, refPoint;
+		int elemId = cartesianMesh.locate(point.data(),intPoint);
+		BOOST_REQUIRE(elemId > -1);
+		BOOST_REQUIRE_EQUAL(locator.locate(point.data(),refPoint),elemId);
+		double coords[3] = {intPoint.x,intPoint.y,intPoint.z};
+		double refCoords[3] = {refPoint.x,refPoint.y,refPoint.z};
+		for (int k = 0; k < dim; k++) {
+			BOOST_REQUIRE_SMALL(coords[k] - refCoords[k],1.0e-10);
+		}
+
+		// Compute the shapes and gradients with MFEM
+		mesh.GetElementTransformation(elemId,&transformation);
+		transformation.SetIntPoint(&intPoint);
+		auto * fElement = collection.FiniteElementForGeometry(
+				transformation.GetGeometryType());
+		int numDof = fElement->GetDof();
+		Vector shapes(numDof);
+		DenseMatrix gradients(numDof,dim);
+		fElement->CalcShape(intPoint,shapes);
+		fElement->CalcPhysDShape(transformation,gradients);
+
+		// Compare them to the closed form versions
+		ParticleStencil stencil;
+		cartesianMesh.computeStencil(elemId,intPoint,stencil);
+		BOOST_REQUIRE_EQUAL(elemId,stencil.elementId);
+		BOOST_REQUIRE_EQUAL(numDof,stencil.numNodes);
+		auto * vertexIds = mesh.GetElement(elemId)->GetVertices();
+		for (int i = 0; i < numDof; i++) {
+			BOOST_REQUIRE_EQUAL(vertexIds[i],stencil.nodeIds[i]);
+			BOOST_REQUIRE_SMALL(shapes[i] - stencil.weights[i],1.0e-12);
+			for (int j = 0; j < dim; j++) {
+				BOOST_REQUIRE_SMALL(gradients(i,j) - stencil.gradients[i][j],
+						1.0e-10);
+			}
+		}
+	}
+
+	return;
+}
+
+/**
+ * This operation checks that a quadrilateral mesh that is not anchored at
+ * the origin and does not have square elements is detected as Cartesian and
+ * that its closed form shapes match MFEM's.
+ */
+BOOST_AUTO_TEST_CASE(checkQuadrilaterals) {
+
+	// Create a 4x3 mesh of 0.5 by 0.25 elements on [-1,1]x[2,2.75]
+	Mesh mesh(4,3,Element::QUADRILATERAL,true,4.0,3.0);
+	for (int i = 0; i < mesh.GetNV(); i++) {
+		double * vertex = mesh.GetVertex(i);
+		vertex[0] = -1.0 + 0.5*vertex[0];
+		vertex[1] = 2.0 + 0.25*vertex[1];
+	}
+	H1_FECollection collection(1,2);
+	CartesianMesh cartesianMesh(mesh,collection);
+	BOOST_REQUIRE(cartesianMesh.isCartesian());
+	BOOST_REQUIRE_EQUAL(4,cartesianMesh.cells(0));
+	BOOST_REQUIRE_EQUAL(3,cartesianMesh.cells(1));
+	BOOST_REQUIRE_CLOSE(0.5,cartesianMesh.cellWidth(0),1.0e-12);
+	BOOST_REQUIRE_CLOSE(0.25,cartesianMesh.cellWidth(1),1.0e-12);
+	// MFEM numbers the vertices along the lattice
+	BOOST_REQUIRE(cartesianMesh.hasLatticeVertexOrder());
+
+	// Check points scattered through the mesh
+	std::vector<std::vector<double>> points;
+	for (int i = 0; i < 25; i++) {
+		points.push_back({-1.0 + 2.0*fmod(0.618034*i,1.0),
+			2.0 + 0.75*fmod(0.414214*i + 0.1,1.0)});
+	}
+	checkAgainstMFEM(mesh,cartesianMesh,collection,points);
+
+	// Points on the boundary are in the mesh, but not those outside of it
+	IntegrationPoint intPoint;
+	double upperCorner[2] = {1.0,2.75};
+	BOOST_REQUIRE(cartesianMesh.locate(upperCorner,intPoint) > -1);
+	double outside[2] = {-1.1,2.5};
+	BOOST_REQUIRE_EQUAL(-1,cartesianMesh.locate(outside,intPoint));
+
+	return;
+}
+
+/**
+ * This operation checks the closed form shapes on a hexahedral mesh.
+ */
+BOOST_AUTO_TEST_CASE(checkHexahedra) {
+
+	Mesh mesh(2,3,2,Element::HEXAHEDRON,true,1.0,1.5,2.0);
+	H1_FECollection collection(1,3);
+	CartesianMesh cartesianMesh(mesh,collection);
+	BOOST_REQUIRE(cartesianMesh.isCartesian());
+	for (int j = 0; j < 3; j++) {
+		BOOST_REQUIRE_CLOSE(0.5,cartesianMesh.cellWidth(j),1.0e-12);
+	}
+	BOOST_REQUIRE(cartesianMesh.hasLatticeVertexOrder());
+
+	std::vector<std::vector<double>> points;
+	for (int i = 0; i < 25; i++) {
+		points.push_back({fmod(0.618034*i,1.0),1.5*fmod(0.414214*i + 0.1,1.0),
+			2.0*fmod(0.732051*i + 0.2,1.0)});
+	}
+	checkAgainstMFEM(mesh,cartesianMesh,collection,points);
+
+	return;
+}
+
+/**
+ * This operation checks that meshes that are not Cartesian grids are left
+ * to MFEM.
+ */
+BOOST_AUTO_TEST_CASE(checkNonCartesian) {
+
+	H1_FECollection collection(1,2);
+
+	// Move an interior vertex so that the elements are no longer boxes
+	Mesh distorted(3,2,Element::QUADRILATERAL,true,3.0,2.0);
+	double * vertex = distorted.GetVertex(5);
+	vertex[0] += 0.1;
+	CartesianMesh distortedMesh(distorted,collection);
+	BOOST_REQUIRE(!distortedMesh.isCartesian());
+	BOOST_REQUIRE(!distortedMesh.hasLatticeVertexOrder());
+
+	// Triangles are not supported
+	Mesh triangles(3,2,Element::TRIANGLE,true,3.0,2.0);
+	CartesianMesh triangleMesh(triangles,collection);
+	BOOST_REQUIRE(!triangleMesh.isCartesian());
+
+	// Second order elements are not supported either
+	Mesh mesh(3,2,Element::QUADRILATERAL,true,3.0,2.0);
+	H1_FECollection quadraticCollection(2,2);
+	CartesianMesh quadraticMesh(mesh,quadraticCollection);
+	BOOST_REQUIRE(!quadraticMesh.isCartesian());
+
+	return;
+}
+
+/**
+ * This operation checks that the mesh container uses the closed form
+ * operations for the PMGen style background meshes.
+ */
+BOOST_AUTO_TEST_CASE(checkMeshContainer) {
+
+	H1FESpaceFactory spaceFactory;
+	MeshContainer mc(meshFile.c_str(),1,spaceFactory);
+	BOOST_REQUIRE(mc.isCartesian());
+
+	// The element ids run along x first
+	int numX = 4, numY = 2;
+	for (int j = 0; j < numY; j++) {
+		for (int i = 0; i < numX; i++) {
+			double point[2] = {i + 0.25, j + 0.75};
+			IntegrationPoint intPoint;
+			BOOST_REQUIRE_EQUAL(i + numX*j,mc.locate(point,intPoint));
+			BOOST_REQUIRE_CLOSE(0.25,intPoint.x,1.0e-10);
+			BOOST_REQUIRE_CLOSE(0.75,intPoint.y,1.0e-10);
+		}
+	}
+
+	return;
+}
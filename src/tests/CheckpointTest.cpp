@@ -0,0 +1,155 @@
+/**----------------------------------------------------------------------------
+ Copyright  2018-, UT-Battelle, LLC
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ Author(s): Jay Jay Billings (billingsjj <at> ornl <dot> gov)
+ -----------------------------------------------------------------------------*/
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE kelvin
+
+#include <boost/test/included/unit_test.hpp>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <unistd.h>
+#include <Checkpoint.h>
+
+using namespace std;
+using namespace Kelvin;
+
+/**
+ * This operation creates a 3D particle set with distinct values in every
+ * field and stores the particles out of id order.
+ */
+static ParticleSet createParticles(const int & numParticles) {
+	ParticleSet particles(3,numParticles);
+	for (int i = 0; i < numParticles; i++) {
+		for (int j = 0; j < 3; j++) {
+			particles.pos(i)[j] = i + 0.1*j;
+			particles.vel(i)[j] = -i + 0.2*j;
+			particles.acc(i)[j] = 2.0*i + 0.3*j;
+			particles.bodyForce(i)[j] = -9.8*j;
+		}
+		for (int j = 0; j < 9; j++) {
+			particles.stress(i)[j] = 100.0*i + j;
+			particles.strain(i)[j] = 1.0e-3*i - j;
+		}
+		particles.mass(i) = 0.5 + i;
+		particles.volume(i) = 0.25*i;
+		particles.materialId(i) = 1 + i % 2;
+	}
+	vector<int> order(numParticles);
+	for (int i = 0; i < numParticles; i++) {
+		order[i] = (i + 2) % numParticles;
+	}
+	particles.permute(order);
+	return particles;
+}
+
+/**
+ * This operation checks that a checkpoint restores every field of the
+ * particles, their order and the clock.
+ */
+BOOST_AUTO_TEST_CASE(checkWriteAndRead) {
+
+	string filename = "checkpointTest.bin";
+	int numParticles = 7;
+	ParticleSet particles = createParticles(numParticles);
+
+	// Write two checkpoints. The file always holds the last one.
+	CheckpointWriter writer(filename);
+	BOOST_REQUIRE_EQUAL(filename,writer.filename());
+	writer.write(particles,9,0.9);
+	particles.pos(0)[0] = -5.0;
+	writer.write(particles,19,1.9);
+	writer.flush();
+	BOOST_REQUIRE(Checkpoint::exists(filename));
+	BOOST_REQUIRE(!Checkpoint::exists(filename + ".tmp"));
+
+	Checkpoint checkpoint;
+	checkpoint.read(filename);
+	BOOST_REQUIRE_EQUAL(19,checkpoint.step);
+	BOOST_REQUIRE_EQUAL(1.9,checkpoint.time);
+	auto & restored = checkpoint.particles;
+	BOOST_REQUIRE_EQUAL(3,restored.dimension());
+	BOOST_REQUIRE_EQUAL(numParticles,restored.size());
+	BOOST_REQUIRE_EQUAL(-5.0,restored.pos(0)[0]);
+	for (int i = 0; i < numParticles; i++) {
+		BOOST_REQUIRE_EQUAL(particles.id(i),restored.id(i));
+		BOOST_REQUIRE_EQUAL(particles.materialId(i),restored.materialId(i));
+		BOOST_REQUIRE_EQUAL(particles.mass(i),restored.mass(i));
+		BOOST_REQUIRE_EQUAL(particles.volume(i),restored.volume(i));
+		for (int j = 0; j < 3; j++) {
+			BOOST_REQUIRE_EQUAL(particles.pos(i)[j],restored.pos(i)[j]);
+			BOOST_REQUIRE_EQUAL(particles.vel(i)[j],restored.vel(i)[j]);
+			BOOST_REQUIRE_EQUAL(particles.acc(i)[j],restored.acc(i)[j]);
+			BOOST_REQUIRE_EQUAL(particles.bodyForce(i)[j],
+					restored.bodyForce(i)[j]);
+		}
+		for (int j = 0; j < 9; j++) {
+			BOOST_REQUIRE_EQUAL(particles.stress(i)[j],restored.stress(i)[j]);
+			BOOST_REQUIRE_EQUAL(particles.strain(i)[j],restored.strain(i)[j]);
+		}
+	}
+	remove(filename.c_str());
+
+	return;
+}
+
+/**
+ * This operation checks that failed checkpoints are reported and leave the
+ * last good checkpoint in place.
+ */
+BOOST_AUTO_TEST_CASE(checkErrors) {
+
+	string filename = "checkpointTest.bin";
+	ParticleSet particles = createParticles(3);
+	Checkpoint checkpoint;
+	BOOST_REQUIRE(!Checkpoint::exists(filename));
+	BOOST_REQUIRE_THROW(checkpoint.read(filename),const char *);
+
+	// The directory doesn't exist, so the write fails on the writer thread
+	CheckpointWriter badWriter("noSuchDirectory/" + filename);
+	badWriter.write(particles,0,0.0);
+	BOOST_REQUIRE_THROW(badWriter.flush(),const char *);
+
+	// A truncated file is not read
+	checkpoint.particles = particles;
+	checkpoint.step = 4;
+	checkpoint.write(filename);
+	FILE * file = fopen(filename.c_str(),"r+b");
+	fseek(file,0,SEEK_END);
+	long size = ftell(file);
+	fclose(file);
+	BOOST_REQUIRE(truncate(filename.c_str(),size - 8) == 0);
+	Checkpoint truncated;
+	BOOST_REQUIRE_THROW(truncated.read(filename),const char *);
+	remove(filename.c_str());
+
+	return;
+}
@@ -52,21 +52,29 @@ using namespace fire;
 class TestConstitutiveRelationship : public ConstitutiveRelationship {
 public:
 
+	/**
+	 * The number of times that beginStep() was called.
+	 */
+	int numSteps = 0;
+
+	virtual void beginStep(const Kelvin::Grid & grid) {
+		numSteps++;
+	}
+
 	virtual void updateStrainRate(const Kelvin::Grid & grid,
-			Kelvin::MaterialPoint & matPoint) {
+			ParticleSet & particles, const int & index) {
 
 		// Just set the strains to 5.0.
-		int dim = matPoint.dimension();
-		for (int j = 0; j < dim; j++) {
-			for (int k = 0; k < dim; k++) {
-				matPoint.strain[j][k] = 5.0;
-			}
+		int dim = particles.dimension();
+		double * strain = particles.strain(index);
+		for (int j = 0; j < dim*dim; j++) {
+			strain[j] = 5.0;
 		}
 
 	}
 
 	virtual void updateStress(const Kelvin::Grid & grid,
-			Kelvin::MaterialPoint & matPoints) {
+			ParticleSet & particles, const int & index) {
 
 	}
 
@@ -125,5 +133,12 @@ BOOST_AUTO_TEST_CASE(checkServiceRegistration) {
 		}
 	}
 
+	// The single point adapters start a step on every call, but the service
+	// should start exactly one step for each registered relationship.
+	auto & testRel = dynamic_cast<TestConstitutiveRelationship &>(relationship);
+	BOOST_REQUIRE_EQUAL(mPoints.size(),testRel.numSteps);
+	ConstitutiveRelationshipService::beginStep(grid);
+	BOOST_REQUIRE_EQUAL(mPoints.size()+1,testRel.numSteps);
+
 	return;
 }
@@ -0,0 +1,144 @@
+/**----------------------------------------------------------------------------
+ Copyright  2018-, UT-Battelle, LLC
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ Author(s): Jay Jay Billings (billingsjj <at> ornl <dot> gov)
+ -----------------------------------------------------------------------------*/
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE kelvin
+
+#include <boost/test/included/unit_test.hpp>
+#include <mfem.hpp>
+#include <vector>
+#include <cmath>
+#include <MeshContainer.h>
+#include <H1FESpaceFactory.h>
+#include <ElementLocator.h>
+
+using namespace std;
+using namespace mfem;
+using namespace Kelvin;
+
+// Test file names. This mesh has 4x2 unit squares, so it is not a cube and
+// the element ids can't be computed from a single number of elements per
+// side.
+static std::string meshFile = "2Squares-background-unsquared.vtk";
+
+/**
+ * This operation checks that the locator finds the right element for points
+ * in a uniform but non-square mesh.
+ */
+BOOST_AUTO_TEST_CASE(checkLocate) {
+
+	// Load the mesh
+	H1FESpaceFactory spaceFactory;
+	MeshContainer mc(meshFile.c_str(),1,spaceFactory);
+	auto & locator = mc.getElementLocator();
+	BOOST_REQUIRE(locator.size() > 0);
+
+	// Check points in the middle of every element. The element ids run along
+	// x first.
+	int numX = 4, numY = 2;
+	for (int j = 0; j < numY; j++) {
+		for (int i = 0; i < numX; i++) {
+			double point[2] = {i + 0.5, j + 0.5};
+			BOOST_REQUIRE_EQUAL(i + numX*j,locator.locate(point));
+			BOOST_REQUIRE_EQUAL(i + numX*j,mc.getElementId(point));
+		}
+	}
+
+	// Check the reference coordinates
+	IntegrationPoint intPoint;
+	double point[2] = {1.25,0.75};
+	BOOST_REQUIRE_EQUAL(1,locator.locate(point,intPoint));
+	BOOST_REQUIRE_CLOSE(0.25,intPoint.x,1.0e-10);
+	BOOST_REQUIRE_CLOSE(0.75,intPoint.y,1.0e-10);
+
+	// Points on shared faces go to the upper element, like the floor of the
+	// coordinates, and points on the upper boundary stay in the mesh.
+	double sharedFace[2] = {1.0,0.5};
+	BOOST_REQUIRE_EQUAL(1,locator.locate(sharedFace));
+	double sharedCorner[2] = {2.0,1.0};
+	BOOST_REQUIRE_EQUAL(6,locator.locate(sharedCorner));
+	double upperCorner[2] = {4.0,2.0};
+	BOOST_REQUIRE_EQUAL(7,locator.locate(upperCorner));
+
+	// Points outside of the mesh aren't found
+	double left[2] = {-0.5,0.5};
+	BOOST_REQUIRE_EQUAL(-1,locator.locate(left));
+	double above[2] = {1.5,2.5};
+	BOOST_REQUIRE_EQUAL(-1,locator.locate(above));
+
+	return;
+}
+
+/**
+ * This operation checks that the locator works on a stretched mesh that is
+ * not anchored at the origin.
+ */
+BOOST_AUTO_TEST_CASE(checkLocateStretched) {
+
+	// Create a 3x2 mesh on [0,3]x[0,1] and then stretch and move it to
+	// [1,1+3*0.5] x [-2,-2+1*4] with elements of 0.5 by 2.
+	Mesh mesh(3,2,Element::QUADRILATERAL,true,3.0,1.0);
+	for (int i = 0; i < mesh.GetNV(); i++) {
+		double * vertex = mesh.GetVertex(i);
+		vertex[0] = 1.0 + 0.5*vertex[0];
+		vertex[1] = -2.0 + 4.0*vertex[1];
+	}
+	ElementLocator locator(mesh);
+
+	// Check the middle of each element
+	for (int j = 0; j < 2; j++) {
+		for (int i = 0; i < 3; i++) {
+			double point[2] = {1.0 + 0.5*(i + 0.5), -2.0 + 2.0*(j + 0.5)};
+			int elemId = locator.locate(point);
+			BOOST_REQUIRE(elemId > -1);
+			// Make sure the point is really in the element by checking the
+			// bounding box of the element
+			Array<int> vertexIds;
+			mesh.GetElementVertices(elemId,vertexIds);
+			double minX = 1.0e10, maxX = -1.0e10, minY = 1.0e10, maxY = -1.0e10;
+			for (int k = 0; k < vertexIds.Size(); k++) {
+				double * vertex = mesh.GetVertex(vertexIds[k]);
+				minX = min(minX,vertex[0]);
+				maxX = max(maxX,vertex[0]);
+				minY = min(minY,vertex[1]);
+				maxY = max(maxY,vertex[1]);
+			}
+			BOOST_REQUIRE(minX < point[0] && point[0] < maxX);
+			BOOST_REQUIRE(minY < point[1] && point[1] < maxY);
+		}
+	}
+
+	// The old origin is no longer in the mesh
+	double origin[2] = {0.1,0.1};
+	BOOST_REQUIRE_EQUAL(-1,locator.locate(origin));
+
+	return;
+}
@@ -109,7 +109,7 @@ BOOST_AUTO_TEST_CASE(checkStrain) {
 	grid.updateNodalVelocitiesFromMomenta(mPoints);
 
 	// Compute the velocity at the grid point for time dt = 1.0
-	grid.updateNodalVelocities(1.0,mPoints);
+	grid.updateNodalVelocities(1.0);
 
 	// Create the constitutive equation
 	HydrostaticCR conRel;
@@ -200,7 +200,7 @@ BOOST_AUTO_TEST_CASE(checkStress) {
 	grid.updateNodalVelocitiesFromMomenta(mPoints);
 
 	// Compute the velocity at the grid point for time dt = 1.0
-	grid.updateNodalVelocities(1.0,mPoints);
+	grid.updateNodalVelocities(1.0);
 
 	// Create the constitutive equation
 	HydrostaticCR conRel;
@@ -104,7 +104,7 @@ BOOST_AUTO_TEST_CASE(checkStrain) {
 	grid.updateNodalVelocitiesFromMomenta(mPoints);
 
 	// Compute the velocity at the grid point for time dt = 1.0
-	grid.updateNodalVelocities(1.0,mPoints);
+	grid.updateNodalVelocities(1.0);
 
 	// Create the constitutive equation
 	MFEMOlevskyLVCR conRel(data);
@@ -114,8 +114,8 @@ BOOST_AUTO_TEST_CASE(checkStrain) {
 		conRel.updateStrainRate(grid,mPoints[i]);
 	}
 	// Setup reference values
-	std::vector<double> p1Strain{0.0,-1.0,-1.0,-2.0};
-	std::vector<double> p2Strain{-4.0,-3.0,-3.0,-2.0};
+	std::vector<double> p1Strain{-2.0,-3.0,-3.0,-4.0};
+	std::vector<double> p2Strain{-2.0,-3.0,-3.0,-4.0};
 	cout << "----- Strains" << endl;
 	for (int i = 0; i < mPoints.size(); i++) {
 		for (int j = 0; j < dim; j++) {
@@ -137,6 +137,56 @@ BOOST_AUTO_TEST_CASE(checkStrain) {
 	BOOST_REQUIRE_CLOSE(p2Strain[2],mPoints[1].strain[1][0],1.0e-15);
 	BOOST_REQUIRE_CLOSE(p2Strain[3],mPoints[1].strain[1][1],1.0e-15);
 
+	// Compute the strain again for a particle set. The grid was not built
+	// from this set, so its stencils must not be used and the strain is
+	// computed from the mesh instead.
+	ParticleSet particles;
+	particles.assign(mPoints);
+	BOOST_REQUIRE(!grid.hasStencilsFor(particles));
+	conRel.beginStep(grid);
+	for (int i = 0; i < particles.size(); i++) {
+		conRel.updateStrainRate(grid,particles,i);
+	}
+	for (int i = 0; i < particles.size(); i++) {
+		const double * strain = particles.strain(i);
+		for (int j = 0; j < dim*dim; j++) {
+			BOOST_REQUIRE_CLOSE(p1Strain[j],strain[j],1.0e-15);
+		}
+	}
+
+	// Transfer the set to the grid, the way that the solver does, so that
+	// the strain is computed from the stencils of the grid. Another set of
+	// the same size is still not linked to them.
+	grid.updateNodalAccelerations(1.0,particles);
+	grid.updateNodalVelocitiesFromMomenta();
+	grid.updateNodalVelocities(1.0);
+	BOOST_REQUIRE(grid.hasStencilsFor(particles));
+	ParticleSet otherParticles;
+	otherParticles.assign(mPoints);
+	BOOST_REQUIRE(!grid.hasStencilsFor(otherParticles));
+	for (int i = 0; i < particles.size(); i++) {
+		conRel.updateStrainRate(grid,particles,i);
+		const double * strain = particles.strain(i);
+		for (int j = 0; j < dim*dim; j++) {
+			BOOST_REQUIRE_CLOSE(p1Strain[j],strain[j],1.0e-15);
+		}
+	}
+
+	// Update the whole range with one thread and then with several threads
+	// and make sure that the results are identical.
+	int defaultThreads = maxThreads();
+	setMaxThreads(1);
+	conRel.updateStrainRate(grid,particles,0,particles.size());
+	std::vector<double> serialStrain(particles.strain(0),
+			particles.strain(0)+particles.size()*dim*dim);
+	setMaxThreads(4);
+	conRel.updateStrainRate(grid,particles,0,particles.size());
+	setMaxThreads(defaultThreads);
+	for (int i = 0; i < serialStrain.size(); i++) {
+		BOOST_REQUIRE_EQUAL(serialStrain[i],particles.strain(0)[i]);
+		BOOST_REQUIRE_CLOSE(p1Strain[i%(dim*dim)],serialStrain[i],1.0e-15);
+	}
+
 	return;
 }
 
@@ -195,7 +245,7 @@ BOOST_AUTO_TEST_CASE(checkStress) {
 	grid.updateNodalVelocitiesFromMomenta(mPoints);
 
 	// Compute the velocity at the grid point for time dt = 1.0
-	grid.updateNodalVelocities(1.0,mPoints);
+	grid.updateNodalVelocities(1.0);
 
 	// Create the constitutive equation
 	MFEMOlevskyLVCR conRel(data);
@@ -208,16 +258,8 @@ BOOST_AUTO_TEST_CASE(checkStress) {
 	}
 
 	// Setup reference values
-	std::vector<double> p1Stress{-169444,-508333,-508333,-1.18611e6};
-	std::vector<double> p2Stress{-2.54167e6,-1.525e6,-1.525e6,-1.525e6};
-//  I'm guessing that these will change really soon... but for now:
-//	----- Stress
-//	-169444 -508333
-//	-508333 -1.18611e+06
-//	-----
-//	-2.54167e+06 -1.525e+06
-//	-1.525e+06 -1.525e+06
-//	-----
+	std::vector<double> p1Stress{-1.525e6,-1.525e6,-1.525e6,-2.54167e6};
+	std::vector<double> p2Stress{-1.525e6,-1.525e6,-1.525e6,-2.54167e6};
 
 
 	cout << "----- Stress" << endl;
@@ -242,5 +284,26 @@ BOOST_AUTO_TEST_CASE(checkStress) {
 	BOOST_REQUIRE_CLOSE(p2Stress[2],mPoints[1].stress[1][0],1.0e-3);
 	BOOST_REQUIRE_CLOSE(p2Stress[3],mPoints[1].stress[1][1],1.0e-3);
 
+	// Update the stress for all of the points in one batch and make sure that
+	// it matches the update for each point.
+	ParticleSet particles;
+	particles.assign(mPoints);
+	for (int i = 0; i < particles.size(); i++) {
+		double * stress = particles.stress(i);
+		for (int j = 0; j < dim*dim; j++) {
+			stress[j] = 0.0;
+		}
+	}
+	conRel.updateStress(grid,particles,0,particles.size());
+	for (int i = 0; i < particles.size(); i++) {
+		const double * stress = particles.stress(i);
+		for (int j = 0; j < dim; j++) {
+			for (int k = 0; k < dim; k++) {
+				BOOST_REQUIRE_CLOSE(mPoints[i].stress[j][k],stress[j*dim+k],
+						1.0e-12);
+			}
+		}
+	}
+
 	return;
 }
@@ -167,6 +167,51 @@ BOOST_AUTO_TEST_CASE(checkMass) {
 		outerIt++;
 	}
 
+	// Check the in-place version of the lumping operation. The vector should
+	// be resized to match the node set and refilled on every call.
+	std::vector<double> inPlaceLumpedMass(2,-1.0);
+	massMatrix.lump(inPlaceLumpedMass);
+	BOOST_REQUIRE_EQUAL(nodeSet.size(),inPlaceLumpedMass.size());
+	for (int i = 0; i < inPlaceLumpedMass.size(); i++) {
+		BOOST_REQUIRE_CLOSE(lumpedMassMatrix[i],inPlaceLumpedMass[i],
+				percentEPS);
+	}
+
+	// Assemble the consistent mass matrix. It is restricted to the massive
+	// nodes and must match the on-the-fly values exactly.
+	std::vector<double> onTheFlyMasses;
+	for (outerIt = nodeSet.begin(); outerIt != nodeSet.end(); outerIt++) {
+		for(innerIt = nodeSet.begin(); innerIt != nodeSet.end(); innerIt++) {
+			onTheFlyMasses.push_back(massMatrix(*outerIt,*innerIt));
+		}
+	}
+	auto & consistentMatrix = massMatrix.assembleConsistentMatrix();
+	BOOST_REQUIRE_EQUAL(nodeSet.size(),consistentMatrix.Height());
+	BOOST_REQUIRE_EQUAL(nodeSet.size(),consistentMatrix.Width());
+	int k = 0;
+	for (outerIt = nodeSet.begin(); outerIt != nodeSet.end(); outerIt++) {
+		for(innerIt = nodeSet.begin(); innerIt != nodeSet.end(); innerIt++) {
+			BOOST_REQUIRE_CLOSE(onTheFlyMasses[k],
+					massMatrix(*outerIt,*innerIt),percentEPS);
+			k++;
+		}
+	}
+	// Nodes without mass are still zero
+	BOOST_REQUIRE_CLOSE(0.0,massMatrix(20,20),percentEPS);
+	BOOST_REQUIRE_CLOSE(0.0,massMatrix(12,20),percentEPS);
+
+	// Solve M x = b for a right hand side in the range of M, b = M * 1, and
+	// check the residual since M is singular with one particle per element.
+	Vector ones(nodeSet.size()), b(nodeSet.size()), x, residual(nodeSet.size());
+	ones = 1.0;
+	consistentMatrix.Mult(ones,b);
+	BOOST_REQUIRE(massMatrix.solve(b,x));
+	BOOST_REQUIRE_EQUAL(b.Size(),x.Size());
+	consistentMatrix.Mult(x,residual);
+	for (int i = 0; i < b.Size(); i++) {
+		BOOST_REQUIRE_SMALL(residual[i] - b[i],1.0e-10);
+	}
+
 	return;
 
 }
@@ -118,5 +118,3 @@ BOOST_AUTO_TEST_CASE(checkConstruction) {
 
 	return;
 }
-
-
@@ -440,6 +440,29 @@ BOOST_AUTO_TEST_CASE(checkGradients) {
 		}
     }
 
+    // Compute the stencil for the first point. The elements are unit squares,
+    // so the physical gradients in the stencil are equal to the reference
+    // gradients.
+    ParticleStencil stencil;
+    int elemId = mc.getElementId(pt1Vec);
+    mc.computeStencil(pt1Vec,elemId,stencil);
+    auto pt1Shapes = mc.getNodalShapes(pt1Vec,elemId);
+    ids = mc.getSurroundingNodeIds(pt1Vec);
+    BOOST_REQUIRE_EQUAL(elemId,stencil.elementId);
+    BOOST_REQUIRE_EQUAL(e1->GetDof(),stencil.numNodes);
+    for (int i = 0; i < stencil.numNodes; i++) {
+    	BOOST_REQUIRE_EQUAL(ids[i],stencil.nodeIds[i]);
+    	BOOST_REQUIRE_CLOSE(pt1Shapes[i],stencil.weights[i],1.0e-13);
+    	for (int j = 0; j < dimension; j++) {
+    		BOOST_REQUIRE_CLOSE(grad1(i,j),stencil.gradients[i][j],1.0e-13);
+    	}
+    }
+
+    // Points outside of the mesh have empty stencils
+    mc.computeStencil(pt1Vec,-1,stencil);
+    BOOST_REQUIRE_EQUAL(-1,stencil.elementId);
+    BOOST_REQUIRE_EQUAL(0,stencil.numNodes);
+
 	return;
 }
 
@@ -475,6 +498,65 @@ BOOST_AUTO_TEST_CASE(checkGettingElementIds) {
     return;
 }
 
+/**
+ * This operation checks that locating points and computing their stencils in
+ * batches gives the same results as doing it one point at a time.
+ */
+BOOST_AUTO_TEST_CASE(checkBatchLocation) {
+
+	// Test points, stored point-major. The last one is outside of the mesh.
+	vector<double> points = {1.1,0.1,0.98,0.34,-1.0,-1.0};
+	int numPoints = 3;
+
+	// Load the input file
+	INIPropertyParser propertyParser;
+	propertyParser.setSource(inputFile);
+    propertyParser.parse();
+
+	// Load the mesh
+	H1FESpaceFactory spaceFactory;
+    MeshContainer mc(propertyParser.getPropertyBlock("mesh"),spaceFactory);
+    int dim = mc.dimension();
+
+    // Locate all of the points at once and compare to the single version
+    vector<int> ids(numPoints,-2);
+    vector<double> refPoints(numPoints*dim);
+    mc.locate(numPoints,points.data(),ids.data(),refPoints.data());
+    BOOST_REQUIRE_EQUAL(1,ids[0]);
+    BOOST_REQUIRE_EQUAL(0,ids[1]);
+    BOOST_REQUIRE_EQUAL(-1,ids[2]);
+    for (int i = 0; i < numPoints; i++) {
+    	mfem::IntegrationPoint intPoint;
+    	BOOST_REQUIRE_EQUAL(mc.locate(&points[i*dim],intPoint),ids[i]);
+    	if (ids[i] > -1) {
+    		BOOST_REQUIRE_CLOSE(intPoint.x,refPoints[i*dim],1.0e-13);
+    		BOOST_REQUIRE_CLOSE(intPoint.y,refPoints[i*dim+1],1.0e-13);
+    	}
+    }
+
+    // Compute all of the stencils at once and compare them too
+    vector<ParticleStencil> stencils(numPoints);
+    mc.computeStencils(numPoints,ids.data(),refPoints.data(),stencils.data());
+    for (int i = 0; i < numPoints; i++) {
+    	ParticleStencil stencil;
+    	mc.computeStencil(&points[i*dim],ids[i],stencil);
+    	BOOST_REQUIRE_EQUAL(stencil.elementId,stencils[i].elementId);
+    	BOOST_REQUIRE_EQUAL(stencil.numNodes,stencils[i].numNodes);
+    	for (int j = 0; j < stencil.numNodes; j++) {
+    		BOOST_REQUIRE_EQUAL(stencil.nodeIds[j],stencils[i].nodeIds[j]);
+    		BOOST_REQUIRE_CLOSE(stencil.weights[j],stencils[i].weights[j],
+    				1.0e-13);
+    		for (int k = 0; k < dim; k++) {
+    			BOOST_REQUIRE_CLOSE(stencil.gradients[j][k],
+    					stencils[i].gradients[j][k],1.0e-13);
+    		}
+    	}
+    }
+    BOOST_REQUIRE_EQUAL(0,stencils[2].numNodes);
+
+    return;
+}
+
 BOOST_AUTO_TEST_CASE(checkMFEMMeshGradients) {
 
 	// Load the input file
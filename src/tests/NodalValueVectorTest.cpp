@@ -98,5 +98,3 @@ BOOST_AUTO_TEST_CASE(checkClearing) {
 
 	return;
 }
-
-
@@ -0,0 +1,218 @@
+/**----------------------------------------------------------------------------
+ Copyright  2018-, UT-Battelle, LLC
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ Author(s): Jay Jay Billings (billingsjj <at> ornl <dot> gov)
+ -----------------------------------------------------------------------------*/
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE kelvin
+
+#include <boost/test/included/unit_test.hpp>
+#include <vector>
+#include <NodeBlocks.h>
+
+using namespace std;
+using namespace Kelvin;
+
+/**
+ * This operation checks that blocks are activated with their first node and
+ * retired with their last.
+ */
+BOOST_AUTO_TEST_CASE(checkActivation) {
+
+	// Ten blocks, the last one partly used
+	int blockSize = NodeBlocks::blockSize;
+	int numNodes = 9*blockSize + 3;
+	NodeBlocks blocks(numNodes,3);
+	BOOST_REQUIRE(!blocks.isSparse());
+	BOOST_REQUIRE_EQUAL(0,blocks.numActiveBlocks());
+	BOOST_REQUIRE_EQUAL(0,blocks.capacity());
+	for (int i = 0; i < numNodes; i += blockSize/2) {
+		BOOST_REQUIRE(!blocks.contains(i));
+	}
+
+	// Activate two nodes in the second block and one in the last. Only those
+	// blocks are stored.
+	BOOST_REQUIRE(blocks.activate(blockSize + 1));
+	BOOST_REQUIRE(blocks.activate(blockSize + 7));
+	BOOST_REQUIRE(blocks.activate(numNodes - 1));
+	BOOST_REQUIRE_EQUAL(2,blocks.numActiveBlocks());
+	BOOST_REQUIRE_EQUAL(2*blockSize,blocks.capacity());
+	BOOST_REQUIRE(blocks.contains(blockSize));
+	BOOST_REQUIRE(blocks.contains(2*blockSize - 1));
+	BOOST_REQUIRE(!blocks.contains(0));
+	BOOST_REQUIRE(!blocks.contains(2*blockSize));
+	BOOST_REQUIRE(blocks.contains(numNodes - 3));
+
+	// The nodes of a block are contiguous and blocks don't overlap
+	BOOST_REQUIRE_EQUAL(blocks.index(blockSize) + 7,
+			blocks.index(blockSize + 7));
+	BOOST_REQUIRE(blocks.index(blockSize + 1)/blockSize
+			!= blocks.index(numNodes - 1)/blockSize);
+
+	// Write through the accessors and read through the arrays
+	blocks.mass(blockSize + 7) = 2.0;
+	blocks.velocity(numNodes - 1)[2] = 5.0;
+	BOOST_REQUIRE_CLOSE(2.0,blocks.masses()[blocks.index(blockSize + 7)],
+			1.0e-15);
+	BOOST_REQUIRE_CLOSE(5.0,
+			blocks.velocities()[blocks.index(numNodes - 1)*3 + 2],1.0e-15);
+
+	// Nodes are counted by reference and only change state with their first
+	// and last references
+	BOOST_REQUIRE(!blocks.activate(blockSize + 7));
+	BOOST_REQUIRE_EQUAL(2,blocks.count(blockSize + 7));
+	BOOST_REQUIRE_EQUAL(0,blocks.count(blockSize + 8));
+	BOOST_REQUIRE_EQUAL(0,blocks.count(0));
+	BOOST_REQUIRE(!blocks.deactivate(blockSize + 7));
+	BOOST_REQUIRE_EQUAL(1,blocks.count(blockSize + 7));
+
+	// The block stays until its last node is gone
+	BOOST_REQUIRE(blocks.deactivate(blockSize + 1));
+	BOOST_REQUIRE(blocks.contains(blockSize + 1));
+	BOOST_REQUIRE(blocks.deactivate(blockSize + 7));
+	BOOST_REQUIRE(!blocks.contains(blockSize + 7));
+	BOOST_REQUIRE_EQUAL(1,blocks.numActiveBlocks());
+
+	// New blocks reuse the storage of retired ones, cleared
+	blocks.activate(0);
+	BOOST_REQUIRE_EQUAL(2,blocks.numActiveBlocks());
+	BOOST_REQUIRE_EQUAL(2*blockSize,blocks.capacity());
+	for (int i = 0; i < blockSize; i++) {
+		BOOST_REQUIRE_SMALL(blocks.mass(i),1.0e-15);
+	}
+	BOOST_REQUIRE_CLOSE(5.0,blocks.velocity(numNodes - 1)[2],1.0e-15);
+
+	// Clearing the transfer leaves the kinematics alone
+	blocks.mass(0) = 1.0;
+	blocks.momentum(0)[1] = 1.0;
+	blocks.force(0)[2] = 1.0;
+	blocks.clearTransfer();
+	BOOST_REQUIRE_SMALL(blocks.mass(0),1.0e-15);
+	BOOST_REQUIRE_SMALL(blocks.momentum(0)[1],1.0e-15);
+	BOOST_REQUIRE_SMALL(blocks.force(0)[2],1.0e-15);
+	BOOST_REQUIRE_CLOSE(5.0,blocks.velocity(numNodes - 1)[2],1.0e-15);
+
+	// Resizing retires everything
+	blocks.resize(numNodes,2);
+	BOOST_REQUIRE_EQUAL(0,blocks.numActiveBlocks());
+	BOOST_REQUIRE_EQUAL(2,blocks.dimension());
+	BOOST_REQUIRE(!blocks.contains(numNodes - 1));
+
+	return;
+}
+
+/**
+ * This operation checks that the storage of the blocks follows the active
+ * nodes instead of the size of the grid.
+ */
+BOOST_AUTO_TEST_CASE(checkLargeGrid) {
+
+	// A grid that would need gigabytes for one entry per node, with the
+	// blocks found through a hash table
+	int numNodes = 1 << 30;
+	NodeBlocks blocks(numNodes,3,true);
+	BOOST_REQUIRE(blocks.isSparse());
+	BOOST_REQUIRE(blocks.activate(numNodes - 1));
+	BOOST_REQUIRE(blocks.activate(5));
+	BOOST_REQUIRE_EQUAL(2,blocks.numActiveBlocks());
+	BOOST_REQUIRE_EQUAL(2*NodeBlocks::blockSize,blocks.capacity());
+	blocks.velocity(numNodes - 1)[0] = 3.0;
+	BOOST_REQUIRE_CLOSE(3.0,blocks.velocity(numNodes - 1)[0],1.0e-15);
+	BOOST_REQUIRE(!blocks.contains(numNodes/2));
+
+	// Retiring a block removes it from the table
+	BOOST_REQUIRE(blocks.deactivate(5));
+	BOOST_REQUIRE(!blocks.contains(5));
+	BOOST_REQUIRE(blocks.contains(numNodes - 1));
+	BOOST_REQUIRE_EQUAL(1,blocks.numActiveBlocks());
+
+	return;
+}
+
+/**
+ * This operation checks that the blocks are tiles of the vertex lattice of a
+ * Cartesian mesh when the lattice is set.
+ */
+BOOST_AUTO_TEST_CASE(checkLattice) {
+
+	// A 2D lattice of 10x6 nodes with ids along x first
+	int nx = 10, ny = 6;
+	NodeBlocks blocks(nx*ny,2);
+	blocks.setLattice({{nx,ny,1}});
+	auto id = [&](int i, int j) { return i + nx*j; };
+
+	// The first tile is the 8x4 nodes in the corner
+	BOOST_REQUIRE(blocks.activate(id(1,1)));
+	BOOST_REQUIRE_EQUAL(1,blocks.numActiveBlocks());
+	BOOST_REQUIRE(blocks.contains(id(0,0)));
+	BOOST_REQUIRE(blocks.contains(id(7,3)));
+	BOOST_REQUIRE(!blocks.contains(id(8,0)));
+	BOOST_REQUIRE(!blocks.contains(id(0,4)));
+	// All of the nodes of a stencil in the tile share it
+	for (auto nodeId : {id(1,2),id(2,1),id(2,2)}) {
+		BOOST_REQUIRE(blocks.activate(nodeId));
+	}
+	BOOST_REQUIRE_EQUAL(1,blocks.numActiveBlocks());
+
+	// Every node gets its own entry, including those in the partial tiles
+	for (int j = 0; j < ny; j++) {
+		for (int i = 0; i < nx; i++) {
+			blocks.activate(id(i,j));
+		}
+	}
+	BOOST_REQUIRE_EQUAL(4,blocks.numActiveBlocks());
+	vector<bool> used(blocks.capacity(),false);
+	for (int nodeId = 0; nodeId < nx*ny; nodeId++) {
+		int index = blocks.index(nodeId);
+		BOOST_REQUIRE(index >= 0 && index < blocks.capacity());
+		BOOST_REQUIRE(!used[index]);
+		used[index] = true;
+	}
+	BOOST_REQUIRE_EQUAL(2,blocks.count(id(1,1)));
+	BOOST_REQUIRE_EQUAL(1,blocks.count(id(9,5)));
+
+	// In 3D the tiles are 4x4x2 nodes
+	int nz = 3;
+	blocks.resize(nx*ny*nz,3);
+	blocks.setLattice({{nx,ny,nz}});
+	BOOST_REQUIRE(blocks.activate(id(0,0)));
+	BOOST_REQUIRE(blocks.contains(id(3,3) + nx*ny));
+	BOOST_REQUIRE(!blocks.contains(id(4,0)));
+	BOOST_REQUIRE(!blocks.contains(id(0,0) + 2*nx*ny));
+
+	// Sparse blocks use the same tiles
+	blocks.resize(nx*ny*nz,3,true);
+	blocks.setLattice({{nx,ny,nz}});
+	BOOST_REQUIRE(blocks.isSparse());
+	BOOST_REQUIRE(blocks.activate(id(0,0)));
+	BOOST_REQUIRE(blocks.contains(id(3,3) + nx*ny));
+	BOOST_REQUIRE(!blocks.contains(id(4,0)));
+
+	return;
+}
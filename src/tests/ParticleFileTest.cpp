@@ -0,0 +1,182 @@
+/**----------------------------------------------------------------------------
+ Copyright  2018-, UT-Battelle, LLC
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ Author(s): Jay Jay Billings (billingsjj <at> ornl <dot> gov)
+ -----------------------------------------------------------------------------*/
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE kelvin
+
+#include <boost/test/included/unit_test.hpp>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <climits>
+#include <cstdio>
+#include <ParticleFile.h>
+
+using namespace std;
+using namespace Kelvin;
+
+/**
+ * This operation checks that CSV particle files with comments, blank lines
+ * and missing material ids are read correctly.
+ */
+BOOST_AUTO_TEST_CASE(checkCSV) {
+
+	string filename = "particleFileTest.csv";
+	ofstream file(filename);
+	file << "# particles.csv generated by PMGen\n";
+	file << "# x, y, materialId\n";
+	file << "1.5, 1.5, 1\n";
+	file << "\n";
+	file << "2.5,1.5,2\n";
+	file << "  # A comment in the middle\n";
+	file << "3.5, -1.0e-2";
+	file.close();
+
+	ParticleSet particles;
+	BOOST_REQUIRE(!ParticleFile::isBinary(filename));
+	ParticleFile::read(filename,2,particles);
+	BOOST_REQUIRE_EQUAL(2,particles.dimension());
+	BOOST_REQUIRE_EQUAL(3,particles.size());
+	BOOST_REQUIRE_EQUAL(1.5,particles.pos(0)[0]);
+	BOOST_REQUIRE_EQUAL(1.5,particles.pos(0)[1]);
+	BOOST_REQUIRE_EQUAL(1,particles.materialId(0));
+	BOOST_REQUIRE_EQUAL(2.5,particles.pos(1)[0]);
+	BOOST_REQUIRE_EQUAL(2,particles.materialId(1));
+	// The last line has no material id and no line break
+	BOOST_REQUIRE_EQUAL(3.5,particles.pos(2)[0]);
+	BOOST_REQUIRE_EQUAL(-1.0e-2,particles.pos(2)[1]);
+	BOOST_REQUIRE_EQUAL(1,particles.materialId(2));
+
+	// A line without every coordinate is an error
+	file.open(filename);
+	file << "1.0, 2.0, 1\n";
+	file << "1.0\n";
+	file.close();
+	BOOST_REQUIRE_THROW(ParticleFile::read(filename,2,particles),
+			const char *);
+	remove(filename.c_str());
+
+	// Missing files are errors
+	BOOST_REQUIRE_THROW(ParticleFile::read(filename,2,particles),
+			const char *);
+
+	return;
+}
+
+/**
+ * This operation checks that binary files and large CSV files, which are
+ * parsed in parallel chunks, give the same particles as the ones written.
+ */
+BOOST_AUTO_TEST_CASE(checkRoundTrips) {
+
+	// Enough particles for several chunks
+	int numParticles = 20000;
+	ParticleSet particles(3,numParticles);
+	for (int i = 0; i < numParticles; i++) {
+		for (int j = 0; j < 3; j++) {
+			particles.pos(i)[j] = 0.1*i + 1.0/(j + 3.0);
+		}
+		particles.materialId(i) = i % 3;
+	}
+
+	string binaryFilename = "particleFileTest.bin";
+	string csvFilename = "particleFileTest.csv";
+	ParticleFile::writeBinary(binaryFilename,particles);
+	ParticleFile::writeCSV(csvFilename,particles);
+	BOOST_REQUIRE(ParticleFile::isBinary(binaryFilename));
+	BOOST_REQUIRE(!ParticleFile::isBinary(csvFilename));
+	BOOST_REQUIRE_EQUAL(3,ParticleFile::binaryDimension(binaryFilename));
+	BOOST_REQUIRE_THROW(ParticleFile::binaryDimension(csvFilename),
+			const char *);
+
+	// The header is 24 bytes followed by three doubles and an int each
+	ifstream file(binaryFilename, ios::binary | ios::ate);
+	BOOST_REQUIRE_EQUAL(24 + numParticles*(3*8 + 4),(int) file.tellg());
+	file.close();
+
+	int numThreads = maxThreads();
+	setMaxThreads(4);
+	for (const string & filename : {binaryFilename,csvFilename}) {
+		ParticleSet readParticles;
+		ParticleFile::read(filename,3,readParticles);
+		BOOST_REQUIRE_EQUAL(numParticles,readParticles.size());
+		for (int i = 0; i < numParticles; i++) {
+			for (int j = 0; j < 3; j++) {
+				BOOST_REQUIRE_EQUAL(particles.pos(i)[j],
+						readParticles.pos(i)[j]);
+			}
+			BOOST_REQUIRE_EQUAL(particles.materialId(i),
+					readParticles.materialId(i));
+			BOOST_REQUIRE_EQUAL(0.0,readParticles.vel(i)[0]);
+		}
+	}
+	setMaxThreads(numThreads);
+
+	// The dimension of a binary file must match
+	ParticleSet readParticles;
+	BOOST_REQUIRE_THROW(ParticleFile::readBinary(binaryFilename,2,
+			readParticles),const char *);
+	BOOST_REQUIRE_THROW(ParticleFile::readBinary(csvFilename,3,
+			readParticles),const char *);
+
+	// Headers with an impossible dimension or count, or more particles than
+	// the file holds, are rejected
+	auto writeHeader = [&](int32_t fileDim, int64_t count) {
+		swapToLittleEndian(&fileDim,1);
+		swapToLittleEndian(&count,1);
+		fstream header(binaryFilename, ios::in | ios::out | ios::binary);
+		header.seekp(12);
+		header.write(reinterpret_cast<const char *>(&fileDim),
+				sizeof(fileDim));
+		header.write(reinterpret_cast<const char *>(&count),sizeof(count));
+	};
+	for (int32_t badDim : {0,4,-1}) {
+		writeHeader(badDim,numParticles);
+		BOOST_REQUIRE_THROW(ParticleFile::binaryDimension(binaryFilename),
+				const char *);
+		BOOST_REQUIRE_THROW(ParticleFile::readBinary(binaryFilename,3,
+				readParticles),const char *);
+	}
+	for (int64_t badCount : {(int64_t) -1,(int64_t) numParticles + 1,
+			(int64_t) INT_MAX + 1,(int64_t) 1 << 62}) {
+		writeHeader(3,badCount);
+		BOOST_REQUIRE_THROW(ParticleFile::readBinary(binaryFilename,3,
+				readParticles),const char *);
+	}
+	writeHeader(3,numParticles - 1);
+	ParticleFile::readBinary(binaryFilename,3,readParticles);
+	BOOST_REQUIRE_EQUAL(numParticles - 1,readParticles.size());
+
+	remove(binaryFilename.c_str());
+	remove(csvFilename.c_str());
+
+	return;
+}
@@ -0,0 +1,320 @@
+/**----------------------------------------------------------------------------
+ Copyright  2018-, UT-Battelle, LLC
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ Author(s): Jay Jay Billings (billingsjj <at> ornl <dot> gov)
+ -----------------------------------------------------------------------------*/
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE kelvin
+
+#include <boost/test/included/unit_test.hpp>
+#include <ParticleSet.h>
+#include <cstdint>
+
+using namespace std;
+using namespace Kelvin;
+
+/**
+ * This operation insures that the particle set can be constructed, resized
+ * and accessed correctly.
+ */
+BOOST_AUTO_TEST_CASE(checkConstruction) {
+
+	// Check the basic size of the set
+	int dim = 2;
+	int numParticles = 3;
+	ParticleSet particles(dim,numParticles);
+	BOOST_REQUIRE_EQUAL(dim,particles.dimension());
+	BOOST_REQUIRE_EQUAL(numParticles,particles.size());
+
+	// All values should be zero initially
+	for (int i = 0; i < numParticles; i++) {
+		for (int j = 0; j < dim; j++) {
+			BOOST_REQUIRE_EQUAL(0.0,particles.pos(i)[j]);
+			BOOST_REQUIRE_EQUAL(0.0,particles.vel(i)[j]);
+			BOOST_REQUIRE_EQUAL(0.0,particles.acc(i)[j]);
+			BOOST_REQUIRE_EQUAL(0.0,particles.bodyForce(i)[j]);
+		}
+		for (int j = 0; j < dim*dim; j++) {
+			BOOST_REQUIRE_EQUAL(0.0,particles.stress(i)[j]);
+			BOOST_REQUIRE_EQUAL(0.0,particles.strain(i)[j]);
+		}
+		BOOST_REQUIRE_EQUAL(0.0,particles.mass(i));
+		BOOST_REQUIRE_EQUAL(0.0,particles.volume(i));
+		BOOST_REQUIRE_EQUAL(0,particles.materialId(i));
+		BOOST_REQUIRE_EQUAL(i,particles.id(i));
+	}
+
+	// The fields must be contiguous and aligned
+	BOOST_REQUIRE_EQUAL(particles.pos(0) + dim,particles.pos(1));
+	BOOST_REQUIRE_EQUAL(particles.stress(0) + dim*dim,particles.stress(1));
+	BOOST_REQUIRE_EQUAL(0,((uintptr_t) particles.pos(0)) % 64);
+	BOOST_REQUIRE_EQUAL(0,((uintptr_t) particles.stress(0)) % 64);
+	BOOST_REQUIRE_EQUAL(0,((uintptr_t) &particles.mass(0)) % 64);
+
+	// Set some values and make sure they are stored in place
+	particles.pos(1)[1] = 2.0;
+	particles.stress(1)[0*dim+1] = 3.0;
+	particles.mass(2) = 4.0;
+	particles.materialId(2) = 5;
+	BOOST_REQUIRE_EQUAL(2.0,particles.pos(1)[1]);
+	BOOST_REQUIRE_EQUAL(3.0,particles.stress(1)[1]);
+	BOOST_REQUIRE_EQUAL(4.0,particles.mass(2));
+	BOOST_REQUIRE_EQUAL(5,particles.materialId(2));
+
+	// Growing the set keeps the old values and zeroes the new ones
+	particles.resize(numParticles+1);
+	BOOST_REQUIRE_EQUAL(numParticles+1,particles.size());
+	BOOST_REQUIRE_EQUAL(2.0,particles.pos(1)[1]);
+	BOOST_REQUIRE_EQUAL(4.0,particles.mass(2));
+	BOOST_REQUIRE_EQUAL(0.0,particles.mass(numParticles));
+
+	// Clearing it removes everything
+	particles.clear();
+	BOOST_REQUIRE_EQUAL(0,particles.size());
+
+	return;
+}
+
+/**
+ * This operation checks that material points can be copied into and out of
+ * the particle set.
+ */
+BOOST_AUTO_TEST_CASE(checkMaterialPointAdapters) {
+
+	// Create some material points
+	int dim = 3;
+	int numPoints = 2;
+	vector<MaterialPoint> points(numPoints,MaterialPoint(dim));
+	for (int i = 0; i < numPoints; i++) {
+		auto & point = points[i];
+		for (int j = 0; j < dim; j++) {
+			point.pos[j] = (double) (i+j);
+			point.vel[j] = 2.0*(i+j);
+			point.acc[j] = 3.0*(i+j);
+			point.bodyForce[j] = 4.0*(i+j);
+			for (int k = 0; k < dim; k++) {
+				point.stress[j][k] = (double) (i+j*dim+k);
+				point.strain[j][k] = -1.0*(i+j*dim+k);
+			}
+		}
+		point.mass = 1.0 + i;
+		point.volume = 2.0 + i;
+		point.materialId = 3 + i;
+	}
+
+	// Load them into the set
+	ParticleSet particles;
+	particles.assign(points);
+	BOOST_REQUIRE_EQUAL(dim,particles.dimension());
+	BOOST_REQUIRE_EQUAL(numPoints,particles.size());
+	// The tensors are stored in row-major order
+	BOOST_REQUIRE_EQUAL(points[1].stress[1][2],particles.stress(1)[1*dim+2]);
+	BOOST_REQUIRE_EQUAL(points[1].strain[2][0],particles.strain(1)[2*dim+0]);
+
+	// Read them back as material points and compare
+	for (int i = 0; i < numPoints; i++) {
+		auto point = particles[i];
+		auto & refPoint = points[i];
+		BOOST_REQUIRE_EQUAL(dim,point.dimension());
+		for (int j = 0; j < dim; j++) {
+			BOOST_REQUIRE_EQUAL(refPoint.pos[j],point.pos[j]);
+			BOOST_REQUIRE_EQUAL(refPoint.vel[j],point.vel[j]);
+			BOOST_REQUIRE_EQUAL(refPoint.acc[j],point.acc[j]);
+			BOOST_REQUIRE_EQUAL(refPoint.bodyForce[j],point.bodyForce[j]);
+			for (int k = 0; k < dim; k++) {
+				BOOST_REQUIRE_EQUAL(refPoint.stress[j][k],point.stress[j][k]);
+				BOOST_REQUIRE_EQUAL(refPoint.strain[j][k],point.strain[j][k]);
+			}
+		}
+		BOOST_REQUIRE_EQUAL(refPoint.mass,point.mass);
+		BOOST_REQUIRE_EQUAL(refPoint.volume,point.volume);
+		BOOST_REQUIRE_EQUAL(refPoint.materialId,point.materialId);
+	}
+
+	// Copies are not views, so changing one doesn't change the set
+	auto copy = particles[0];
+	copy.mass = 10.0;
+	BOOST_REQUIRE_EQUAL(1.0,particles.mass(0));
+	// But set() does
+	particles.set(0,copy);
+	BOOST_REQUIRE_EQUAL(10.0,particles.mass(0));
+
+	// Add one to the end
+	particles.push_back(points[1]);
+	BOOST_REQUIRE_EQUAL(numPoints+1,particles.size());
+	BOOST_REQUIRE_EQUAL(points[1].pos[2],particles.pos(numPoints)[2]);
+	// Points with the wrong dimension are rejected
+	BOOST_REQUIRE_THROW(particles.push_back(MaterialPoint(2)),const char *);
+
+	// Copy everything back out
+	vector<MaterialPoint> outPoints;
+	particles.copyTo(outPoints);
+	BOOST_REQUIRE_EQUAL(numPoints+1,outPoints.size());
+	BOOST_REQUIRE_EQUAL(10.0,outPoints[0].mass);
+	BOOST_REQUIRE_EQUAL(points[1].strain[1][1],outPoints[2].strain[1][1]);
+
+	return;
+}
+
+/**
+ * This operation checks that particles can be reordered and grouped by
+ * material.
+ */
+BOOST_AUTO_TEST_CASE(checkGroupByMaterial) {
+
+	// Create a set with interleaved materials. The x position stores the
+	// original index so that the order can be checked.
+	int dim = 2;
+	std::vector<int> materials{2,1,2,1,3};
+	ParticleSet particles(dim,materials.size());
+	for (int i = 0; i < particles.size(); i++) {
+		particles.pos(i)[0] = (double) i;
+		particles.stress(i)[3] = 10.0*i;
+		particles.mass(i) = 100.0*i;
+		particles.materialId(i) = materials[i];
+	}
+
+	// The interleaved set has a range for every change in material
+	BOOST_REQUIRE_EQUAL(5,particles.materialRanges().size());
+
+	// Group the particles and make sure the order within each group is kept
+	particles.groupByMaterial();
+	std::vector<int> expectedOrder{1,3,0,2,4};
+	for (int i = 0; i < particles.size(); i++) {
+		int oldIndex = expectedOrder[i];
+		BOOST_REQUIRE_EQUAL((double) oldIndex,particles.pos(i)[0]);
+		BOOST_REQUIRE_EQUAL(10.0*oldIndex,particles.stress(i)[3]);
+		BOOST_REQUIRE_EQUAL(100.0*oldIndex,particles.mass(i));
+		BOOST_REQUIRE_EQUAL(materials[oldIndex],particles.materialId(i));
+		// The stable id is the original index
+		BOOST_REQUIRE_EQUAL(oldIndex,particles.id(i));
+	}
+
+	// Check the ranges
+	auto ranges = particles.materialRanges();
+	BOOST_REQUIRE_EQUAL(3,ranges.size());
+	BOOST_REQUIRE_EQUAL(1,ranges[0].materialId);
+	BOOST_REQUIRE_EQUAL(0,ranges[0].begin);
+	BOOST_REQUIRE_EQUAL(2,ranges[0].end);
+	BOOST_REQUIRE_EQUAL(2,ranges[1].materialId);
+	BOOST_REQUIRE_EQUAL(2,ranges[1].begin);
+	BOOST_REQUIRE_EQUAL(4,ranges[1].end);
+	BOOST_REQUIRE_EQUAL(3,ranges[2].materialId);
+	BOOST_REQUIRE_EQUAL(4,ranges[2].begin);
+	BOOST_REQUIRE_EQUAL(5,ranges[2].end);
+
+	// A bad order is rejected
+	std::vector<int> badOrder{0,1};
+	BOOST_REQUIRE_THROW(particles.permute(badOrder),const char *);
+
+	// An empty set has no ranges
+	ParticleSet empty(dim);
+	BOOST_REQUIRE(empty.materialRanges().empty());
+
+	return;
+}
+
+/**
+ * This operation checks the particle location cache.
+ */
+BOOST_AUTO_TEST_CASE(checkLocationCache) {
+
+	// New particles are not located
+	int dim = 2;
+	ParticleSet particles(dim,3);
+	BOOST_REQUIRE(!particles.locationsAreCurrent());
+	for (int i = 0; i < particles.size(); i++) {
+		BOOST_REQUIRE_EQUAL(-1,particles.elementId(i));
+	}
+
+	// Fill the cache
+	for (int i = 0; i < particles.size(); i++) {
+		particles.elementId(i) = 10*i;
+		particles.referencePos(i)[0] = 0.1*i;
+		particles.referencePos(i)[1] = 0.2*i;
+	}
+	particles.validateLocations();
+	BOOST_REQUIRE(particles.locationsAreCurrent());
+
+	// Reordering the particles keeps the cache and moves it with them
+	std::vector<int> order{2,0,1};
+	particles.permute(order);
+	BOOST_REQUIRE(particles.locationsAreCurrent());
+	for (int i = 0; i < particles.size(); i++) {
+		BOOST_REQUIRE_EQUAL(10*order[i],particles.elementId(i));
+		BOOST_REQUIRE_CLOSE(0.2*order[i],particles.referencePos(i)[1],
+				1.0e-15);
+	}
+
+	// Setting a particle or adding one invalidates the cache
+	MaterialPoint point(dim);
+	particles.set(0,point);
+	BOOST_REQUIRE(!particles.locationsAreCurrent());
+	particles.validateLocations();
+	particles.push_back(point);
+	BOOST_REQUIRE(!particles.locationsAreCurrent());
+	BOOST_REQUIRE_EQUAL(-1,particles.elementId(3));
+
+	// So does moving the particles
+	particles.validateLocations();
+	particles.pos(1)[0] += 1.0;
+	particles.invalidateLocations();
+	BOOST_REQUIRE(!particles.locationsAreCurrent());
+
+	return;
+}
+
+/**
+ * This operation checks that the generation of a set changes when its
+ * particles are added or reordered, but not when their values change.
+ */
+BOOST_AUTO_TEST_CASE(checkGeneration) {
+
+	int dim = 2;
+	ParticleSet particles(dim,3);
+	ParticleSet otherParticles(dim,3);
+	BOOST_REQUIRE(particles.generation() != otherParticles.generation());
+
+	// Changing values keeps the generation
+	long generation = particles.generation();
+	MaterialPoint point(dim);
+	particles.set(0,point);
+	particles.pos(1)[0] += 1.0;
+	BOOST_REQUIRE_EQUAL(generation,particles.generation());
+
+	// Reordering or adding particles does not
+	std::vector<int> order{2,0,1};
+	particles.permute(order);
+	BOOST_REQUIRE(generation != particles.generation());
+	generation = particles.generation();
+	particles.push_back(point);
+	BOOST_REQUIRE(generation != particles.generation());
+
+	return;
+}
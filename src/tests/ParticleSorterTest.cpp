@@ -0,0 +1,127 @@
+/**----------------------------------------------------------------------------
+ Copyright  2018-, UT-Battelle, LLC
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ Author(s): Jay Jay Billings (billingsjj <at> ornl <dot> gov)
+ -----------------------------------------------------------------------------*/
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE kelvin
+
+#include <boost/test/included/unit_test.hpp>
+#include <mfem.hpp>
+#include <vector>
+#include <Grid.h>
+#include <MeshContainer.h>
+#include <H1FESpaceFactory.h>
+#include <INIPropertyParser.h>
+#include <ParticleSorter.h>
+
+using namespace std;
+using namespace mfem;
+using namespace Kelvin;
+using namespace fire;
+
+// Test file names
+static std::string inputFile = "2SquaresInput-smallerMesh.ini";
+
+/**
+ * This operation checks the Morton codes.
+ */
+BOOST_AUTO_TEST_CASE(checkMortonCode) {
+
+	// 2D
+	uint32_t x[3] = {1,0,0};
+	BOOST_REQUIRE_EQUAL(1,ParticleSorter::mortonCode(x,2));
+	uint32_t y[3] = {0,1,0};
+	BOOST_REQUIRE_EQUAL(2,ParticleSorter::mortonCode(y,2));
+	// x = 011, y = 101 interleave to 100111
+	uint32_t xy[3] = {3,5,0};
+	BOOST_REQUIRE_EQUAL(39,ParticleSorter::mortonCode(xy,2));
+
+	// 3D
+	uint32_t xyz[3] = {1,1,1};
+	BOOST_REQUIRE_EQUAL(7,ParticleSorter::mortonCode(xyz,3));
+	uint32_t x2[3] = {2,0,0};
+	BOOST_REQUIRE_EQUAL(8,ParticleSorter::mortonCode(x2,3));
+
+	return;
+}
+
+/**
+ * This operation checks that the particles are binned by element and sorted
+ * by material, and that their ids move with them.
+ */
+BOOST_AUTO_TEST_CASE(checkSort) {
+
+	// Create the space factory
+	H1FESpaceFactory spaceFactory;
+
+	// Load the input file
+	INIPropertyParser propertyParser;
+	propertyParser.setSource(inputFile);
+    propertyParser.parse();
+
+	// Load the mesh, which has two elements side by side
+    MeshContainer mc(propertyParser.getPropertyBlock("mesh"),spaceFactory);
+    Grid grid(mc);
+
+    // Create particles that alternate between the elements
+    std::vector<double> xPositions{1.25,0.25,1.75,0.75};
+    ParticleSet particles(2,xPositions.size());
+    for (int i = 0; i < particles.size(); i++) {
+    	particles.pos(i)[0] = xPositions[i];
+    	particles.pos(i)[1] = 0.5;
+    	particles.materialId(i) = 1;
+    }
+
+    // The particles in the first element should come first and each element
+    // should keep the order of its particles.
+    ParticleSorter sorter(mc);
+    BOOST_REQUIRE(sorter.sort(grid,particles));
+    std::vector<int> expectedIds{1,3,0,2};
+    for (int i = 0; i < particles.size(); i++) {
+    	BOOST_REQUIRE_EQUAL(expectedIds[i],particles.id(i));
+    	BOOST_REQUIRE_CLOSE(xPositions[expectedIds[i]],particles.pos(i)[0],
+    			1.0e-15);
+    }
+
+    // Sorting again doesn't do anything
+    BOOST_REQUIRE(!sorter.sort(grid,particles));
+
+    // Materials come before elements. Moving the last particle, which is in
+    // the second element, to a lower material must move it to the front.
+    particles.materialId(3) = 0;
+    BOOST_REQUIRE(sorter.sort(grid,particles));
+    expectedIds = {2,1,3,0};
+    for (int i = 0; i < particles.size(); i++) {
+    	BOOST_REQUIRE_EQUAL(expectedIds[i],particles.id(i));
+    }
+    BOOST_REQUIRE_EQUAL(2,particles.materialRanges().size());
+
+	return;
+}
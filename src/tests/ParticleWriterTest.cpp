@@ -0,0 +1,177 @@
+/**----------------------------------------------------------------------------
+ Copyright  2018-, UT-Battelle, LLC
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ Author(s): Jay Jay Billings (billingsjj <at> ornl <dot> gov)
+ -----------------------------------------------------------------------------*/
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE kelvin
+
+#include <boost/test/included/unit_test.hpp>
+#include <vector>
+#include <string>
+#include <fstream>
+#include <cstdio>
+#include <ParticleWriter.h>
+
+using namespace std;
+using namespace Kelvin;
+
+/**
+ * This operation creates a 2D particle set with distinct values in every
+ * field and stores the particles out of id order.
+ */
+static ParticleSet createParticles(const int & numParticles) {
+	ParticleSet particles(2,numParticles);
+	for (int i = 0; i < numParticles; i++) {
+		particles.pos(i)[0] = 1.0 + i;
+		particles.pos(i)[1] = 0.5 - i;
+		particles.vel(i)[0] = 0.25*i;
+		particles.vel(i)[1] = -0.25*i;
+		for (int j = 0; j < 4; j++) {
+			particles.stress(i)[j] = 10.0*i + j;
+		}
+		particles.materialId(i) = 1 + i % 2;
+	}
+	// Reverse the order in memory
+	vector<int> order(numParticles);
+	for (int i = 0; i < numParticles; i++) {
+		order[i] = numParticles - 1 - i;
+	}
+	particles.permute(order);
+	return particles;
+}
+
+/**
+ * This operation checks that binary snapshots are written in id order and
+ * read back exactly.
+ */
+BOOST_AUTO_TEST_CASE(checkBinarySnapshot) {
+
+	int numParticles = 5;
+	ParticleSet particles = createParticles(numParticles);
+	BOOST_REQUIRE_EQUAL(numParticles - 1,particles.id(0));
+
+	// Write two steps so that both buffers are used
+	string prefix = "particleWriterTest_";
+	ParticleWriter writer(ParticleOutputFormat::BINARY,prefix);
+	BOOST_REQUIRE(ParticleOutputFormat::BINARY == writer.format());
+	BOOST_REQUIRE_EQUAL(prefix + "3.bin",writer.filename(3));
+	writer.write(particles,3,0.75);
+	particles.pos(0)[0] = -1.0;
+	writer.write(particles,4,1.0);
+	writer.flush();
+
+	// The first snapshot must not see the change made after it was queued
+	ParticleSnapshot snapshot;
+	snapshot.readBinary(writer.filename(3));
+	BOOST_REQUIRE_EQUAL(2,snapshot.dim);
+	BOOST_REQUIRE_EQUAL(numParticles,snapshot.numParticles);
+	BOOST_REQUIRE_EQUAL(3,snapshot.step);
+	BOOST_REQUIRE_CLOSE(0.75,snapshot.time,1.0e-15);
+	for (int i = 0; i < numParticles; i++) {
+		BOOST_REQUIRE_EQUAL(1.0 + i,snapshot.pos[i]);
+		BOOST_REQUIRE_EQUAL(0.5 - i,snapshot.pos[numParticles + i]);
+		BOOST_REQUIRE_EQUAL(0.25*i,snapshot.vel[i]);
+		BOOST_REQUIRE_EQUAL(-0.25*i,snapshot.vel[numParticles + i]);
+		for (int j = 0; j < 4; j++) {
+			BOOST_REQUIRE_EQUAL(10.0*i + j,snapshot.stress[j*numParticles + i]);
+		}
+		BOOST_REQUIRE_EQUAL(1 + i % 2,snapshot.materialId[i]);
+	}
+	snapshot.readBinary(writer.filename(4));
+	BOOST_REQUIRE_EQUAL(4,snapshot.step);
+	BOOST_REQUIRE_EQUAL(-1.0,snapshot.pos[numParticles - 1]);
+
+	// The header is 40 bytes and the arrays are 8 doubles and one int each
+	ifstream file(writer.filename(4), ios::binary | ios::ate);
+	BOOST_REQUIRE_EQUAL(40 + numParticles*(8*8 + 4),(int) file.tellg());
+	file.close();
+
+	// Other files are rejected
+	remove(writer.filename(3).c_str());
+	BOOST_REQUIRE_THROW(snapshot.readBinary(writer.filename(3)),const char *);
+	remove(writer.filename(4).c_str());
+
+	return;
+}
+
+/**
+ * This operation checks that the CSV output has the position of each
+ * particle and the step on one line, in id order.
+ */
+BOOST_AUTO_TEST_CASE(checkCSV) {
+
+	int numParticles = 3;
+	ParticleSet particles = createParticles(numParticles);
+
+	ParticleWriter writer(ParticleOutputFormat::CSV,"particleWriterTest_");
+	BOOST_REQUIRE_EQUAL("particleWriterTest_2.000000.csv",writer.filename(2));
+	writer.write(particles,2,0.5);
+	writer.flush();
+
+	ifstream file(writer.filename(2));
+	vector<string> lines;
+	string line;
+	while (getline(file,line)) {
+		lines.push_back(line);
+	}
+	file.close();
+	remove(writer.filename(2).c_str());
+	BOOST_REQUIRE_EQUAL(numParticles,lines.size());
+	BOOST_REQUIRE_EQUAL("1.000000000000000, 0.500000000000000, 2.000000000000000",
+			lines[0]);
+	BOOST_REQUIRE_EQUAL("3.000000000000000, -1.500000000000000, 2.000000000000000",
+			lines[2]);
+
+	return;
+}
+
+/**
+ * This operation checks the format names and that errors on the writer
+ * thread are reported to the caller.
+ */
+BOOST_AUTO_TEST_CASE(checkFormatsAndErrors) {
+
+	BOOST_REQUIRE(ParticleOutputFormat::BINARY
+			== ParticleWriter::parseFormat("binary"));
+	BOOST_REQUIRE(ParticleOutputFormat::CSV
+			== ParticleWriter::parseFormat("csv"));
+	BOOST_REQUIRE_THROW(ParticleWriter::parseFormat("vtk"),const char *);
+
+	// The directory doesn't exist, so the write fails on the writer thread
+	ParticleSet particles = createParticles(2);
+	ParticleWriter writer(ParticleOutputFormat::BINARY,
+			"noSuchDirectory/particleWriterTest_");
+	writer.write(particles,0,0.0);
+	BOOST_REQUIRE_THROW(writer.flush(),const char *);
+	// The error is only reported once
+	writer.flush();
+
+	return;
+}
@@ -82,5 +82,3 @@ BOOST_AUTO_TEST_CASE(checkConstruction) {
 
 	return;
 }
-
-
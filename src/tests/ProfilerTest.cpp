@@ -0,0 +1,182 @@
+/**----------------------------------------------------------------------------
+ Copyright  2018-, UT-Battelle, LLC
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ Author(s): Jay Jay Billings (billingsjj <at> ornl <dot> gov)
+ -----------------------------------------------------------------------------*/
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE kelvin
+
+#include <boost/test/included/unit_test.hpp>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <thread>
+#include <Profiler.h>
+
+using namespace std;
+using namespace Kelvin;
+
+/**
+ * This operation checks the statistics of the phases and the counters.
+ */
+BOOST_AUTO_TEST_CASE(checkPhasesAndCounters) {
+
+	Profiler::reset();
+
+	// 1 to 100 ms, out of order
+	for (int i = 100; i > 0; i--) {
+		Profiler::record("phase",1.0e-3*i);
+	}
+	auto phase = Profiler::phase("phase");
+	BOOST_REQUIRE_EQUAL(100,phase.samples.size());
+	BOOST_REQUIRE_CLOSE(5.05,phase.total(),1.0e-12);
+	BOOST_REQUIRE_CLOSE(1.0e-3,phase.percentile(0.0),1.0e-12);
+	BOOST_REQUIRE_CLOSE(50.0e-3,phase.percentile(50.0),1.0e-12);
+	BOOST_REQUIRE_CLOSE(90.0e-3,phase.percentile(90.0),1.0e-12);
+	BOOST_REQUIRE_CLOSE(99.0e-3,phase.percentile(99.0),1.0e-12);
+	BOOST_REQUIRE_CLOSE(100.0e-3,phase.percentile(100.0),1.0e-12);
+	BOOST_REQUIRE_THROW(Profiler::phase("missing"),const char *);
+
+	Profiler::count("counter",3);
+	Profiler::count("counter",4);
+	BOOST_REQUIRE_EQUAL(7,Profiler::counter("counter"));
+	BOOST_REQUIRE_EQUAL(0,Profiler::counter("missing"));
+
+	// Scoped timers always record. The macros only do if profiling is on.
+	{
+		ScopedTimer timer("scoped");
+	}
+	BOOST_REQUIRE_EQUAL(1,Profiler::phase("scoped").samples.size());
+	BOOST_REQUIRE(Profiler::phase("scoped").samples[0] >= 0.0);
+	{
+		KELVIN_PROFILE_SCOPE("macro");
+		KELVIN_PROFILE_COUNT("macroCounter",2);
+	}
+	BOOST_REQUIRE_EQUAL(Profiler::enabled() ? 2 : 0,
+			Profiler::counter("macroCounter"));
+
+	Profiler::reset();
+	BOOST_REQUIRE_EQUAL(0,Profiler::counter("counter"));
+	BOOST_REQUIRE_THROW(Profiler::phase("phase"),const char *);
+
+	return;
+}
+
+/**
+ * This operation checks the JSON report.
+ */
+BOOST_AUTO_TEST_CASE(checkReport) {
+
+	Profiler::reset();
+	string filename = "profilerTest.json";
+
+	// Empty reports are still valid JSON
+	Profiler::writeReport(filename);
+	ifstream file(filename);
+	stringstream contents;
+	contents << file.rdbuf();
+	file.close();
+	BOOST_REQUIRE(contents.str().find("\"phases\": {},") != string::npos);
+	BOOST_REQUIRE(contents.str().find("\"counters\": {}") != string::npos);
+
+	Profiler::record("shapeUpdate",0.5);
+	Profiler::record("shapeUpdate",1.5);
+	Profiler::count("steps",2);
+	Profiler::writeReport(filename);
+	file.open(filename);
+	contents.str("");
+	contents << file.rdbuf();
+	file.close();
+	string report = contents.str();
+	BOOST_REQUIRE(report.find("\"shapeUpdate\": {\"calls\": 2, \"total\": 2, "
+			"\"mean\": 1, \"min\": 0.5, \"p50\": 0.5, \"p90\": 1.5, "
+			"\"p99\": 1.5, \"max\": 1.5}") != string::npos);
+	BOOST_REQUIRE(report.find("\"steps\": 2") != string::npos);
+	BOOST_REQUIRE(report.find("\"threads\": ") != string::npos);
+	remove(filename.c_str());
+	Profiler::reset();
+
+	return;
+}
+
+/**
+ * This operation checks that long phases keep a bounded sample and that the
+ * records of other threads are merged.
+ */
+BOOST_AUTO_TEST_CASE(checkSamplesAndThreads) {
+
+	Profiler::reset();
+
+	// Many more calls than samples. The count, total and extremes are exact
+	// and the median of the sample is close.
+	int numCalls = 20*ProfilePhase::maxSamples;
+	int id = Profiler::phaseId("long");
+	BOOST_REQUIRE_EQUAL(id,Profiler::phaseId("long"));
+	for (int i = 1; i <= numCalls; i++) {
+		Profiler::record(id,(double) i);
+	}
+	auto phase = Profiler::phase("long");
+	BOOST_REQUIRE_EQUAL(numCalls,phase.calls);
+	BOOST_REQUIRE_EQUAL(ProfilePhase::maxSamples,phase.samples.size());
+	BOOST_REQUIRE_CLOSE(0.5*numCalls*(numCalls + 1.0),phase.total(),1.0e-12);
+	BOOST_REQUIRE_CLOSE(1.0,phase.percentile(0.0),1.0e-12);
+	BOOST_REQUIRE_CLOSE((double) numCalls,phase.percentile(100.0),1.0e-12);
+	BOOST_REQUIRE_CLOSE(0.5*numCalls,phase.percentile(50.0),5.0);
+
+	// Records from threads that are still running and that have finished
+	// are both included.
+	Profiler::reset();
+	int counterId = Profiler::counterId("threadCounter");
+	std::vector<std::thread> threads;
+	for (int t = 0; t < 4; t++) {
+		threads.emplace_back([id,counterId]() {
+			for (int i = 0; i < 10; i++) {
+				Profiler::record(id,1.0);
+				Profiler::count(counterId,1);
+			}
+		});
+	}
+	for (auto & thread : threads) {
+		thread.join();
+	}
+	Profiler::record(id,2.0);
+	phase = Profiler::phase("long");
+	BOOST_REQUIRE_EQUAL(41,phase.calls);
+	BOOST_REQUIRE_EQUAL(41,phase.samples.size());
+	BOOST_REQUIRE_CLOSE(42.0,phase.total(),1.0e-12);
+	BOOST_REQUIRE_CLOSE(2.0,phase.percentile(100.0),1.0e-12);
+	BOOST_REQUIRE_EQUAL(40,Profiler::counter("threadCounter"));
+
+	Profiler::reset();
+	BOOST_REQUIRE_THROW(Profiler::phase("long"),const char *);
+	BOOST_REQUIRE_EQUAL(0,Profiler::counter("threadCounter"));
+
+	return;
+}
@@ -0,0 +1,154 @@
+/**----------------------------------------------------------------------------
+ Copyright  2018-, UT-Battelle, LLC
+ All rights reserved.
+
+ Redistribution and use in source and binary forms, with or without
+ modification, are permitted provided that the following conditions are met:
+
+ * Redistributions of source code must retain the above copyright notice, this
+ list of conditions and the following disclaimer.
+
+ * Redistributions in binary form must reproduce the above copyright notice,
+ this list of conditions and the following disclaimer in the documentation
+ and/or other materials provided with the distribution.
+
+ * Neither the name of the copyright holder nor the names of its
+ contributors may be used to endorse or promote products derived from
+ this software without specific prior written permission.
+
+ THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS"
+ AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE
+ IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE
+ FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+ Author(s): Jay Jay Billings (billingsjj <at> ornl <dot> gov)
+ -----------------------------------------------------------------------------*/
+#define BOOST_TEST_DYN_LINK
+#define BOOST_TEST_MODULE kelvin
+
+#include <boost/test/included/unit_test.hpp>
+#include <vector>
+#include <VelocityBoundaryCondition.h>
+
+using namespace std;
+using namespace Kelvin;
+
+/**
+ * This operation creates the blocks for a list of 2D nodes and activates the
+ * first few, which all have the same velocity and acceleration.
+ */
+static NodeBlocks createNodes(const int & numActiveNodes) {
+	// Use enough nodes for more than one block
+	NodeBlocks nodes(2*NodeBlocks::blockSize,2);
+	for (int i = 0; i < numActiveNodes; i++) {
+		nodes.activate(i);
+		nodes.velocity(i)[0] = 1.0;
+		nodes.velocity(i)[1] = 2.0;
+		nodes.acceleration(i)[0] = 3.0;
+		nodes.acceleration(i)[1] = 4.0;
+	}
+	return nodes;
+}
+
+/**
+ * This operation checks that conditions are read from their descriptions.
+ */
+BOOST_AUTO_TEST_CASE(checkDescriptions) {
+
+	VelocityBoundaryCondition noSlip("side1","noSlip",2);
+	BOOST_REQUIRE_EQUAL("side1",noSlip.getSide());
+	BOOST_REQUIRE(VelocityBoundaryType::NO_SLIP == noSlip.getType());
+	BOOST_REQUIRE(noSlip.getVelocity().empty());
+
+	VelocityBoundaryCondition freeSlip("xMax"," freeSlip ",2);
+	BOOST_REQUIRE(VelocityBoundaryType::FREE_SLIP == freeSlip.getType());
+
+	VelocityBoundaryCondition fixed("yMax","fixed 0.5 -1.0e-3",2);
+	BOOST_REQUIRE(VelocityBoundaryType::FIXED == fixed.getType());
+	BOOST_REQUIRE_EQUAL(2,fixed.getVelocity().size());
+	BOOST_REQUIRE_CLOSE(0.5,fixed.getVelocity()[0],1.0e-15);
+	BOOST_REQUIRE_CLOSE(-1.0e-3,fixed.getVelocity()[1],1.0e-15);
+
+	// A fixed condition without a velocity holds the nodes still
+	VelocityBoundaryCondition still("yMin","fixed",2);
+	BOOST_REQUIRE_EQUAL(2,still.getVelocity().size());
+	BOOST_REQUIRE_SMALL(still.getVelocity()[0],1.0e-15);
+	BOOST_REQUIRE_SMALL(still.getVelocity()[1],1.0e-15);
+
+	// Bad descriptions
+	BOOST_REQUIRE_THROW(VelocityBoundaryCondition("side1","slippery",2),
+			const char *);
+	BOOST_REQUIRE_THROW(VelocityBoundaryCondition("side1","fixed 1.0",2),
+			const char *);
+	BOOST_REQUIRE_THROW(VelocityBoundaryCondition("side1","fixed 1.0 a",2),
+			const char *);
+
+	return;
+}
+
+/**
+ * This operation checks that the conditions are only applied to their nodes.
+ */
+BOOST_AUTO_TEST_CASE(checkApply) {
+
+	// No slip
+	auto nodes = createNodes(4);
+	VelocityBoundaryCondition noSlip("side1","noSlip",2);
+	noSlip.setNodes({0,2},{});
+	noSlip.apply(nodes);
+	for (int i = 0; i < 2; i++) {
+		BOOST_REQUIRE_SMALL(nodes.velocity(0)[i],1.0e-15);
+		BOOST_REQUIRE_SMALL(nodes.acceleration(0)[i],1.0e-15);
+		BOOST_REQUIRE_SMALL(nodes.velocity(2)[i],1.0e-15);
+		BOOST_REQUIRE_SMALL(nodes.acceleration(2)[i],1.0e-15);
+	}
+	BOOST_REQUIRE_CLOSE(1.0,nodes.velocity(1)[0],1.0e-15);
+	BOOST_REQUIRE_CLOSE(4.0,nodes.acceleration(3)[1],1.0e-15);
+
+	// Free slip only removes the normal component. The normals don't need to
+	// be unit vectors.
+	nodes = createNodes(4);
+	VelocityBoundaryCondition freeSlip("xMax","freeSlip",2);
+	freeSlip.setNodes({1,3},{2.0,0.0,1.0,1.0});
+	freeSlip.apply(nodes);
+	BOOST_REQUIRE_SMALL(nodes.velocity(1)[0],1.0e-15);
+	BOOST_REQUIRE_CLOSE(2.0,nodes.velocity(1)[1],1.0e-13);
+	BOOST_REQUIRE_SMALL(nodes.acceleration(1)[0],1.0e-15);
+	BOOST_REQUIRE_CLOSE(4.0,nodes.acceleration(1)[1],1.0e-13);
+	// n = (1,1)/sqrt(2), so v - (v.n)n = (-0.5,0.5) and a = (-0.5,0.5)
+	BOOST_REQUIRE_CLOSE(-0.5,nodes.velocity(3)[0],1.0e-12);
+	BOOST_REQUIRE_CLOSE(0.5,nodes.velocity(3)[1],1.0e-12);
+	BOOST_REQUIRE_CLOSE(-0.5,nodes.acceleration(3)[0],1.0e-12);
+	BOOST_REQUIRE_CLOSE(0.5,nodes.acceleration(3)[1],1.0e-12);
+	BOOST_REQUIRE_CLOSE(1.0,nodes.velocity(0)[0],1.0e-15);
+	// Every node needs a normal
+	BOOST_REQUIRE_THROW(freeSlip.setNodes({1,3},{1.0,0.0}),const char *);
+
+	// Fixed velocities
+	nodes = createNodes(4);
+	VelocityBoundaryCondition fixed("yMax","fixed 0.0 -1.0",2);
+	fixed.setNodes({3},{});
+	fixed.apply(nodes);
+	BOOST_REQUIRE_SMALL(nodes.velocity(3)[0],1.0e-15);
+	BOOST_REQUIRE_CLOSE(-1.0,nodes.velocity(3)[1],1.0e-15);
+	BOOST_REQUIRE_SMALL(nodes.acceleration(3)[0],1.0e-15);
+	BOOST_REQUIRE_SMALL(nodes.acceleration(3)[1],1.0e-15);
+	BOOST_REQUIRE_CLOSE(2.0,nodes.velocity(2)[1],1.0e-15);
+
+	// Nodes in blocks without particles are skipped
+	nodes = createNodes(4);
+	VelocityBoundaryCondition farAway("yMin","noSlip",2);
+	farAway.setNodes({1,NodeBlocks::blockSize + 1},{});
+	BOOST_REQUIRE(!nodes.contains(NodeBlocks::blockSize + 1));
+	farAway.apply(nodes);
+	BOOST_REQUIRE_SMALL(nodes.velocity(1)[0],1.0e-15);
+	BOOST_REQUIRE_EQUAL(1,nodes.numActiveBlocks());
+
+	return;
+}